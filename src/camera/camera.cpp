@@ -3,11 +3,9 @@
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <gtx/string_cast.hpp>
-#include <iostream>
 
 #include "camera.h"
+#include "../core/Log.h"
 
 Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch)
 {
@@ -30,42 +28,35 @@ glm::mat4 Camera::GetProjectionMatrix(float width, float height) const
 
 void Camera::ProcessKeyboard(Camera_Movement direction, float deltaTime)
 {
-    std::cout << "Initial Camera Position: " << glm::to_string(Position) << std::endl;
+    glm::vec3 initialPosition = Position;
     float velocity = MovementSpeed * deltaTime;
-    std::cout << "Velocity: " << velocity << std::endl;
 
     if (direction == FORWARD)
     {
-        std::cout << "Moving FORWARD" << std::endl;
         Position += Front * velocity;
     }
     if (direction == BACKWARD)
     {
-        std::cout << "Moving BACKWARD" << std::endl;
         Position -= Front * velocity;
     }
     if (direction == LEFT)
     {
-        std::cout << "Moving LEFT" << std::endl;
         Position -= Right * velocity;
     }
     if (direction == RIGHT)
     {
-        std::cout << "Moving RIGHT" << std::endl;
         Position += Right * velocity;
     }
     if (direction == UP)
     {
-        std::cout << "Moving UP" << std::endl;
         Position += Up * velocity;
     }
     if (direction == DOWN)
     {
-        std::cout << "Moving DOWN" << std::endl;
         Position -= Up * velocity;
     }
 
-    std::cout << "Updated Camera Position: " << glm::to_string(Position) << std::endl;
+    LOG_TRACE(LogCategory::Camera, "Moved {} from {} to {} (velocity {})", static_cast<int>(direction), initialPosition, Position, velocity);
 }
 
 void Camera::ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch)
@@ -86,8 +77,7 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset, GLboolean constr
 
     updateCameraVectors();
 
-    std::cout << "Yaw: " << Yaw << ", Pitch: " << Pitch << std::endl;
-    std::cout << "Camera Front: " << glm::to_string(Front) << std::endl;
+    LOG_TRACE(LogCategory::Camera, "Yaw: {}, Pitch: {}, Front: {}", Yaw, Pitch, Front);
 }
 
 void Camera::updateCameraVectors()
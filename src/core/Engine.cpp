@@ -5,11 +5,29 @@
 #include "../scene/Scene.h"    // Include Scene definition if necessary
 #include <GLFW/glfw3.h>        // Ensure this is included to define GLFWwindow
 #include "../ecs/MovementSystem.h"
-#include <iostream>
+#include "Framebuffer.h"
+#include "ImageWriter.h"
+#include "../camera/camera.h"
+#include <json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "Log.h"
+#include "Profiler.h"
 
 Engine::Engine()
-    : window(nullptr), renderer(nullptr), guiManager(nullptr), scene(nullptr), isPlaying(false)
+    : window(nullptr), renderer(nullptr), guiManager(nullptr), scene(nullptr), isPlaying(false),
+      frontSnapshot(0), fixedDeltaTime(1.0f / 60.0f), simulationTime(0.0f)
 {
+    // Systems and other engine code find the job system through the registry
+    PROFILE_THREAD("Main");
+    registry.ctx().emplace<JobSystem *>(&jobSystem);
+    registry.ctx().emplace<TextureManager *>(&textureManager);
+    // Structural changes from outside the systems, e.g. the editor; applied with the next step
+    registry.ctx().emplace<CommandBuffer>(&jobSystem);
 
     // Add the MovementSystem
     auto movementSystem = std::make_shared<MovementSystem>();
@@ -21,9 +39,13 @@ Engine::~Engine()
     Shutdown();
 }
 
-bool Engine::Initialize()
+bool Engine::Initialize(const EngineOptions &options)
 {
-    window = new Window(800, 600, "Edu Game Engine", false); // Set fullscreen to true
+    this->options = options;
+    fixedDeltaTime = 1.0f / options.tickRate;
+
+    window = new Window(options.width, options.height, "Edu Game Engine", false); // Set fullscreen to true
+    window->SetHeadless(options.headless, options.contextApi);
     if (!window->Initialize())
     {
         return false;
@@ -35,15 +57,29 @@ bool Engine::Initialize()
         return false;
     }
 
+    if (options.headless)
+    {
+        // No editor: the scene is rendered straight into an offscreen target
+        scene = new Scene(&registry);
+        scene->GetImporter().SetTextureCompression(options.textureCompression);
+        if (!options.scenePath.empty() && !scene->ImportModel(options.scenePath))
+        {
+            return false;
+        }
+        isPlaying = options.simulate;
+        return true;
+    }
+
     guiManager = new GUIManager();
+    guiManager->engine = this;
+    guiManager->registry = &registry; // The editor's icons go through the texture manager in the registry
     if (!guiManager->Initialize(window))
     {
         return false;
     }
-    guiManager->engine = this;
-    guiManager->registry = &registry;
 
     scene = new Scene(&registry);
+    scene->GetImporter().SetTextureCompression(options.textureCompression);
     // Initialize scene, load resources, etc.
     guiManager->scene = scene;
     guiManager->renderer = renderer;
@@ -52,15 +88,28 @@ bool Engine::Initialize()
 
 void Engine::Run()
 {
+    if (options.headless)
+    {
+        RunHeadless();
+        return;
+    }
+
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
 
+    // The first frame needs something to draw before any step has been scheduled
+    if (options.pipelined)
+    {
+        StepSimulation(0.0f, true);
+    }
+
     while (!window->ShouldClose())
     {
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        // Camera input only, so it may overlap the step still running from last frame
         guiManager->ProcessInput(window->GetGLFWWindow(), deltaTime);
 
         window->PollEvents();
@@ -71,19 +120,249 @@ void Engine::Run()
         glm::mat4 viewMatrix = guiManager->camera.GetViewMatrix();
         glm::mat4 projectionMatrix = guiManager->camera.GetProjectionMatrix(static_cast<float>(width), static_cast<float>(height));
 
-        if (isPlaying)
+        const RenderSnapshot &snapshot = SyncSimulation(deltaTime, true);
+
+        // GL work queued by jobs has to run on this thread
+        jobSystem.RunMainThreadJobs();
+
+        // Imported meshes become entities here, while no step is running
+        scene->GetImporter().Update(static_cast<size_t>(options.uploadBudgetMB) << 20);
+
+        // The editor reads and edits the registry, so it is built while no step is running
+        guiManager->BuildFrame(viewMatrix, projectionMatrix, snapshot);
+
+        // Its edits, e.g. a gizmo drag, are drawn this frame instead of after the next step
+        RefreshSnapshot();
+
+        ScheduleSimulation(deltaTime, true);
+
+        // Drawing only reads the snapshot, so it overlaps the next step
+        guiManager->DrawFrame();
+
+        {
+            PROFILE_SCOPE("Window::SwapBuffers");
+            window->SwapBuffers();
+        }
+        PROFILE_FRAME();
+    }
+}
+
+void Engine::StepSimulation(float deltaTime, bool interpolate)
+{
+    PROFILE_SCOPE("Engine::StepSimulation");
+
+    // Commands recorded by the editor since the last step, so they apply even while paused
+    systemManager.PlaybackCommands(registry);
+
+    // Fixed simulation steps, as many as the elapsed time covers, capped so a slow frame cannot
+    // demand ever more steps. Rendering then blends between the last two steps.
+    if (isPlaying)
+    {
+        simulationTime += deltaTime;
+        int steps = 0;
+        while (simulationTime >= fixedDeltaTime && steps < options.maxSimulationSteps)
         {
-            systemManager.TickAllSystems(registry, deltaTime);
+            scene->SavePreviousTransforms();
+            systemManager.TickAllSystems(registry, fixedDeltaTime);
+            scene->UpdateSpatialIndex();
+            simulationTime -= fixedDeltaTime;
+            steps++;
         }
+        if (simulationTime >= fixedDeltaTime)
+        {
+            LOG_DEBUG(LogCategory::Core, "Simulation fell behind, dropping {} ms", (simulationTime - std::fmod(simulationTime, fixedDeltaTime)) * 1000.0f);
+            simulationTime = std::fmod(simulationTime, fixedDeltaTime);
+        }
+        scene->SetInterpolation(interpolate ? simulationTime / fixedDeltaTime : 1.0f);
+    }
+    else
+    {
+        simulationTime = 0.0f;
+        scene->SavePreviousTransforms();
+        scene->SetInterpolation(1.0f);
+    }
+
+    // Refit the spatial index for edits made outside the simulation, e.g. with the gizmo
+    scene->UpdateSpatialIndex();
 
-        guiManager->NewFrame(viewMatrix, projectionMatrix);
+    scene->ExtractSnapshot(snapshots[1 - frontSnapshot]);
+}
+
+const RenderSnapshot &Engine::SyncSimulation(float deltaTime, bool interpolate)
+{
+    PROFILE_SCOPE("Engine::SyncSimulation");
+    if (options.pipelined)
+    {
+        // Never more than one step in flight, which bounds the added latency to one frame
+        jobSystem.Wait(simulationJob);
+        simulationJob = JobHandle();
+    }
+    else
+    {
+        StepSimulation(deltaTime, interpolate);
+    }
 
-        guiManager->Render(viewMatrix, projectionMatrix);
+    frontSnapshot = 1 - frontSnapshot;
+    return snapshots[frontSnapshot];
+}
 
-        window->SwapBuffers();
+void Engine::RefreshSnapshot()
+{
+    PROFILE_SCOPE("Engine::RefreshSnapshot");
+    uint64_t revision = scene->GetRevision();
+    scene->UpdateSpatialIndex();
+    if (scene->GetRevision() != revision)
+    {
+        scene->ExtractSnapshot(snapshots[frontSnapshot]);
     }
 }
 
+void Engine::ScheduleSimulation(float deltaTime, bool interpolate)
+{
+    if (options.pipelined)
+    {
+        simulationJob = jobSystem.Schedule([this, deltaTime, interpolate]
+                                           { StepSimulation(deltaTime, interpolate); });
+    }
+}
+
+void Engine::RunHeadless()
+{
+    using Clock = std::chrono::steady_clock;
+
+    Framebuffer target;
+    target.Resize(options.width, options.height);
+
+    // Same starting camera as the editor so captures match what the Scene tab shows
+    Camera camera(glm::vec3(0.0f, 5.0f, 15.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f);
+    glm::mat4 viewMatrix = camera.GetViewMatrix();
+    glm::mat4 projectionMatrix = camera.GetProjectionMatrix(static_cast<float>(options.width), static_cast<float>(options.height));
+
+    if (!options.captureDirectory.empty())
+    {
+        std::filesystem::create_directories(options.captureDirectory);
+    }
+
+    // One fixed step per frame, drawn without blending, keeps simulated runs reproducible
+    std::vector<double> frameTimes;
+    std::vector<double> latencies; // From the end of a step to its frame being finished
+    frameTimes.reserve(options.frameCount);
+    latencies.reserve(options.frameCount);
+    std::vector<uint8_t> pixels;
+
+    // Keep every frame of the run for the trace
+    if (!options.tracePath.empty())
+    {
+        Profiler::SetHistorySize(options.frameCount);
+    }
+
+    if (options.pipelined)
+    {
+        StepSimulation(0.0f, false);
+    }
+
+    for (int frame = 0; frame < options.frameCount; frame++)
+    {
+        Clock::time_point frameStart = Clock::now();
+
+        const RenderSnapshot &snapshot = SyncSimulation(fixedDeltaTime, false);
+        jobSystem.RunMainThreadJobs();
+        ScheduleSimulation(fixedDeltaTime, false);
+
+        target.Bind();
+        renderer->Render(snapshot, viewMatrix, projectionMatrix);
+        target.Unbind();
+
+        // Wait for the GPU so the timing covers the whole frame, not just command submission
+        {
+            PROFILE_SCOPE("glFinish");
+            glFinish();
+        }
+        PROFILE_FRAME();
+        Clock::time_point frameEnd = Clock::now();
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+        latencies.push_back(std::chrono::duration<double, std::milli>(frameEnd - snapshot.capturedAt).count());
+
+        bool lastFrame = frame + 1 == options.frameCount;
+        bool captureFrame = options.captureInterval > 0 ? (frame + 1) % options.captureInterval == 0 : lastFrame;
+        if (!options.captureDirectory.empty() && captureFrame)
+        {
+            char fileName[32];
+            std::snprintf(fileName, sizeof(fileName), "frame_%05d.png", frame);
+            target.ReadPixels(pixels);
+            WritePNG((std::filesystem::path(options.captureDirectory) / fileName).string(), target.GetWidth(), target.GetHeight(), pixels);
+        }
+    }
+
+    jobSystem.Wait(simulationJob);
+    simulationJob = JobHandle();
+
+    if (!options.tracePath.empty())
+    {
+        Profiler::WriteChromeTrace(options.tracePath);
+    }
+
+    if (frameTimes.empty())
+    {
+        return;
+    }
+
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [](const std::vector<double> &values, double p)
+    {
+        size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        return values[index];
+    };
+    double total = 0.0;
+    for (double time : frameTimes)
+    {
+        total += time;
+    }
+    std::vector<double> sortedLatencies = latencies;
+    std::sort(sortedLatencies.begin(), sortedLatencies.end());
+    double totalLatency = 0.0;
+    for (double latency : latencies)
+    {
+        totalLatency += latency;
+    }
+
+    const RenderStats &stats = renderer->GetStats();
+    nlohmann::json report;
+    report["scene"] = options.scenePath;
+    report["width"] = options.width;
+    report["height"] = options.height;
+    report["frames"] = frameTimes.size();
+    report["simulated"] = isPlaying;
+    report["tick_rate"] = options.tickRate;
+    report["pipelined"] = options.pipelined;
+    const GLubyte *rendererName = glGetString(GL_RENDERER);
+    report["renderer"] = rendererName ? reinterpret_cast<const char *>(rendererName) : "unknown";
+    report["mean_ms"] = total / frameTimes.size();
+    report["min_ms"] = sorted.front();
+    report["p50_ms"] = percentile(sorted, 0.50);
+    report["p95_ms"] = percentile(sorted, 0.95);
+    report["p99_ms"] = percentile(sorted, 0.99);
+    report["max_ms"] = sorted.back();
+    report["latency_mean_ms"] = totalLatency / latencies.size();
+    report["latency_p99_ms"] = percentile(sortedLatencies, 0.99);
+    report["latency_max_ms"] = sortedLatencies.back();
+    report["draw_calls"] = stats.drawCalls;
+    report["submitted"] = stats.submitted;
+    report["culled"] = stats.culled;
+    report["frame_ms"] = frameTimes;
+
+    std::ofstream file(options.timingsPath);
+    if (!file.is_open())
+    {
+        LOG_ERROR(LogCategory::Core, "Failed to write frame timings to {}", options.timingsPath);
+        return;
+    }
+    file << report.dump(2) << std::endl;
+    LOG_INFO(LogCategory::Core, "Headless run: {} frames, mean {} ms, written to {}", frameTimes.size(),
+             report["mean_ms"].get<double>(), options.timingsPath);
+}
+
 void Engine::SetPlaying(bool play)
 {
     isPlaying = play;
@@ -91,8 +370,19 @@ void Engine::SetPlaying(bool play)
 
 void Engine::Shutdown()
 {
+    // A step still in flight uses the scene
+    jobSystem.Wait(simulationJob);
+    simulationJob = JobHandle();
+
+    // Shutdown also runs from the destructor, so leave nothing dangling
     delete scene;
+    // Meshes and their textures go while the GL context and the texture manager still exist
+    registry.clear();
     delete guiManager;
     delete renderer;
     delete window;
+    scene = nullptr;
+    guiManager = nullptr;
+    renderer = nullptr;
+    window = nullptr;
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 #include "Window.h"
 #include "Renderer.h"
+#include "EngineOptions.h"
+#include "JobSystem.h"
+#include "TextureManager.h"
 #include "../gui/GUIManager.h"
 #include "../scene/Scene.h"
 #include "../ecs/SystemManager.h"
@@ -15,7 +18,7 @@ public:
     Engine();
     ~Engine();
 
-    bool Initialize();
+    bool Initialize(const EngineOptions &options = EngineOptions());
     void Run();
     void Shutdown();
     void SetPlaying(bool play);
@@ -23,10 +26,37 @@ public:
     entt::registry registry;
 
 private:
+    // Renders options.frameCount frames offscreen, then writes timings and captures
+    void RunHeadless();
+
+    // Advances the simulation by deltaTime in fixed steps and captures the result into the back
+    // snapshot. Runs inline, or as a job overlapping the draw of the front snapshot when pipelined.
+    // With interpolate false the latest step is drawn as is instead of blended with the one before.
+    void StepSimulation(float deltaTime, bool interpolate);
+
+    // Waits for the step that fills the back snapshot, or runs it inline, then makes it the front
+    // one. Afterwards nothing else touches the registry until ScheduleSimulation.
+    const RenderSnapshot &SyncSimulation(float deltaTime, bool interpolate);
+    void ScheduleSimulation(float deltaTime, bool interpolate);
+
+    // Main thread, between SyncSimulation and ScheduleSimulation: propagates edits made outside
+    // the simulation and captures the front snapshot again if they changed the scene
+    void RefreshSnapshot();
+
+    EngineOptions options;
     Window *window;
     Renderer *renderer;
     GUIManager *guiManager;
     Scene *scene;
+    JobSystem jobSystem; // Shared task runtime, also reachable through registry.ctx()
+    TextureManager textureManager; // Every GL texture, also reachable through registry.ctx(); outlives the scene and editor
     SystemManager systemManager;
     bool isPlaying;
+
+    // The registry is the simulation's working copy; the renderer only ever sees these snapshots
+    RenderSnapshot snapshots[2];
+    int frontSnapshot;         // Snapshot being drawn; the other one is being filled
+    JobHandle simulationJob;   // Pending step when pipelined
+    float fixedDeltaTime;      // 1 / options.tickRate
+    float simulationTime;      // Elapsed time not yet simulated
 };
@@ -0,0 +1,157 @@
+#include "EngineOptions.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    void PrintUsage(const char *program)
+    {
+        std::cout << "Usage: " << program << " [options]\n"
+                  << "  --headless              Render without a visible window or editor, then exit\n"
+                  << "  --frames N              Number of frames to render in headless mode (default 300)\n"
+                  << "  --size WxH              Render target size (default 800x600)\n"
+                  << "  --scene PATH            Model to load into the scene\n"
+                  << "  --timings PATH          Where to write frame timings as JSON (default frame_timings.json)\n"
+                  << "  --capture DIR           Write PNG captures of the rendered frames into DIR\n"
+                  << "  --capture-every N       Capture every N frames instead of only the last one\n"
+                  << "  --trace PATH            Write a Chrome trace of the headless run (needs EGE_PROFILE)\n"
+                  << "  --context-api API       native, egl or osmesa (egl/osmesa need no display)\n"
+                  << "  --simulate              Tick systems while rendering in headless mode (one step per frame)\n"
+                  << "  --tick-rate HZ          Fixed simulation steps per second (default 60)\n"
+                  << "  --max-steps N           Steps a slow frame may catch up before time is dropped (default 5)\n"
+                  << "  --upload-budget MB      Imported data uploaded to the GPU per frame (default 16)\n"
+                  << "  --textures MODE         Imported texture compression: none, bc (BC1/BC3, default) or bc7\n"
+                  << "  --pipelined             Simulate frame N+1 on a worker while frame N is drawn\n";
+    }
+
+    bool ParsePositiveInt(const char *text, int &value)
+    {
+        char *end = nullptr;
+        long parsed = std::strtol(text, &end, 10);
+        if (end == text || *end != '\0' || parsed <= 0)
+        {
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+}
+
+bool ParseCommandLine(int argc, char **argv, EngineOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool valid = true;
+
+        if (std::strcmp(arg, "--headless") == 0)
+        {
+            options.headless = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--simulate") == 0)
+        {
+            options.simulate = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--pipelined") == 0)
+        {
+            options.pipelined = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--help") == 0)
+        {
+            PrintUsage(argv[0]);
+            return false;
+        }
+
+        // Everything below takes a value
+        if (!value)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            PrintUsage(argv[0]);
+            return false;
+        }
+
+        if (std::strcmp(arg, "--frames") == 0)
+        {
+            valid = ParsePositiveInt(value, options.frameCount);
+        }
+        else if (std::strcmp(arg, "--size") == 0)
+        {
+            valid = std::sscanf(value, "%dx%d", &options.width, &options.height) == 2 && options.width > 0 && options.height > 0;
+        }
+        else if (std::strcmp(arg, "--scene") == 0)
+        {
+            options.scenePath = value;
+        }
+        else if (std::strcmp(arg, "--timings") == 0)
+        {
+            options.timingsPath = value;
+        }
+        else if (std::strcmp(arg, "--capture") == 0)
+        {
+            options.captureDirectory = value;
+        }
+        else if (std::strcmp(arg, "--trace") == 0)
+        {
+            options.tracePath = value;
+        }
+        else if (std::strcmp(arg, "--tick-rate") == 0)
+        {
+            valid = ParsePositiveInt(value, options.tickRate);
+        }
+        else if (std::strcmp(arg, "--max-steps") == 0)
+        {
+            valid = ParsePositiveInt(value, options.maxSimulationSteps);
+        }
+        else if (std::strcmp(arg, "--upload-budget") == 0)
+        {
+            valid = ParsePositiveInt(value, options.uploadBudgetMB);
+        }
+        else if (std::strcmp(arg, "--capture-every") == 0)
+        {
+            valid = ParsePositiveInt(value, options.captureInterval);
+        }
+        else if (std::strcmp(arg, "--textures") == 0)
+        {
+            if (std::strcmp(value, "none") == 0)
+                options.textureCompression = TextureCompression::None;
+            else if (std::strcmp(value, "bc") == 0)
+                options.textureCompression = TextureCompression::BC;
+            else if (std::strcmp(value, "bc7") == 0)
+                options.textureCompression = TextureCompression::BC7;
+            else
+                valid = false;
+        }
+        else if (std::strcmp(arg, "--context-api") == 0)
+        {
+            if (std::strcmp(value, "native") == 0)
+                options.contextApi = ContextApi::Native;
+            else if (std::strcmp(value, "egl") == 0)
+                options.contextApi = ContextApi::EGL;
+            else if (std::strcmp(value, "osmesa") == 0)
+                options.contextApi = ContextApi::OSMesa;
+            else
+                valid = false;
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+            return false;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            PrintUsage(argv[0]);
+            return false;
+        }
+        i++; // Skip the consumed value
+    }
+    return true;
+}
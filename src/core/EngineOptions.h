@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include "TextureCompression.h"
+
+// Which API GLFW uses to create the OpenGL context
+enum class ContextApi
+{
+    Native, // WGL/GLX/NSGL, needs a display
+    EGL,    // EGL, surfaceless with Mesa when there is no display
+    OSMesa  // Off-screen Mesa, pure software (llvmpipe)
+};
+
+// Start-up configuration, filled from the command line by ParseCommandLine
+struct EngineOptions
+{
+    bool headless = false;                          // Hidden window, no editor; renders frameCount frames and exits
+    ContextApi contextApi = ContextApi::Native;
+    int width = 800;
+    int height = 600;
+    int frameCount = 300;                           // Frames rendered in headless mode
+    bool simulate = false;                          // Tick systems while rendering in headless mode
+    int tickRate = 60;                              // Simulation steps per second
+    int maxSimulationSteps = 5;                     // Steps per frame before the backlog is dropped
+    bool pipelined = false;                         // Simulate the next frame while the current one is drawn
+    std::string scenePath;                          // Model loaded into the scene before the first frame
+    std::string timingsPath = "frame_timings.json"; // Frame timings written at the end of a headless run
+    std::string captureDirectory;                   // PNG captures are written here when not empty
+    int captureInterval = 0;                        // Capture every N frames; 0 captures only the last frame
+    std::string tracePath;                          // Profiler trace of a headless run is written here when not empty
+    int uploadBudgetMB = 16;                        // Imported geometry and textures sent to the GPU per frame
+    TextureCompression textureCompression = TextureCompression::BC; // How imported textures are cooked
+};
+
+// Parses --headless, --frames N, --size WxH, --scene PATH, --timings PATH, --capture DIR,
+// --capture-every N, --trace PATH, --context-api native|egl|osmesa, --simulate, --tick-rate HZ,
+// --max-steps N, --upload-budget MB, --textures none|bc|bc7 and --pipelined.
+// Prints usage and returns false on unknown or malformed arguments.
+bool ParseCommandLine(int argc, char **argv, EngineOptions &options);
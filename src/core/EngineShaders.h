@@ -0,0 +1,36 @@
+#pragma once
+#include "FrameConstants.h"
+
+// GLSL sources for the shaders used by the engine itself.
+// Programs are built from these through the ShaderRegistry, never compiled directly.
+
+// Vertex Shader source code for static meshes, always drawn instanced
+inline const char *MeshVertexShaderSource = "#version 330 core\n" FRAME_CONSTANTS_GLSL R"(
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    layout (location = 2) in vec2 aTexCoords;
+    layout (location = 3) in mat4 aModel; // Per-instance model matrix
+
+    out vec2 TexCoords;
+
+    void main()
+    {
+        TexCoords = aTexCoords; // Pass the texture coordinates to the fragment shader
+        gl_Position = viewProjection * aModel * vec4(aPos, 1.0);
+    }
+)";
+
+// Fragment Shader source code for static meshes
+inline const char *MeshFragmentShaderSource = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    in vec2 TexCoords;
+
+    uniform sampler2D texture1; // Texture uniform
+
+    void main()
+    {
+        FragColor = texture(texture1, TexCoords); // Sample the texture
+    }
+)";
@@ -0,0 +1,32 @@
+#pragma once
+#include <glm.hpp>
+
+// Uniform buffer binding point every engine shader reads its FrameConstants block from
+const unsigned int FrameConstantsBinding = 0;
+
+// Per-frame values shared by every draw, laid out to match the std140 block below.
+// Renderer::Render uploads this once per frame.
+struct FrameConstants
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPosition; // xyz = world position, w unused
+    float time;               // Seconds since the window was created
+    float deltaTime;          // Seconds since the previous rendered frame
+    float padding[2];
+};
+
+static_assert(sizeof(FrameConstants) == 224, "FrameConstants must match the std140 layout of the GLSL block");
+
+// GLSL declaration of the block, spliced into engine shaders after their #version line
+#define FRAME_CONSTANTS_GLSL                 \
+    "layout (std140) uniform FrameConstants\n" \
+    "{\n"                                      \
+    "    mat4 view;\n"                         \
+    "    mat4 projection;\n"                   \
+    "    mat4 viewProjection;\n"               \
+    "    vec4 cameraPosition;\n"               \
+    "    float time;\n"                        \
+    "    float deltaTime;\n"                   \
+    "};\n"
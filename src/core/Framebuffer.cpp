@@ -0,0 +1,103 @@
+#include "Framebuffer.h"
+#include "Log.h"
+#include <algorithm>
+
+Framebuffer::Framebuffer()
+    : framebuffer(0), colorTexture(0), depthRenderbuffer(0), width(0), height(0), previousFramebuffer(0), previousViewport{0, 0, 0, 0} {}
+
+Framebuffer::~Framebuffer()
+{
+    Release();
+}
+
+void Framebuffer::Release()
+{
+    if (framebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &colorTexture);
+        glDeleteRenderbuffers(1, &depthRenderbuffer);
+    }
+    framebuffer = colorTexture = depthRenderbuffer = 0;
+    width = height = 0;
+}
+
+bool Framebuffer::Resize(int newWidth, int newHeight)
+{
+    newWidth = newWidth > 0 ? newWidth : 1;
+    newHeight = newHeight > 0 ? newHeight : 1;
+    if (framebuffer != 0 && newWidth == width && newHeight == height)
+    {
+        return false;
+    }
+
+    Release();
+    width = newWidth;
+    height = newHeight;
+
+    glGenTextures(1, &colorTexture);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Linear so scaled-down renders upsample smoothly
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &depthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint boundFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &boundFramebuffer);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_ERROR(LogCategory::Render, "Framebuffer: incomplete framebuffer {}x{}", width, height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(boundFramebuffer));
+    return true;
+}
+
+void Framebuffer::Bind()
+{
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+void Framebuffer::Unbind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+}
+
+void Framebuffer::ReadPixels(std::vector<uint8_t> &rgba)
+{
+    rgba.resize(static_cast<size_t>(width) * height * 4);
+
+    GLint boundFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &boundFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(boundFramebuffer));
+
+    // GL returns the bottom row first
+    size_t rowSize = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> row(rowSize);
+    for (int y = 0; y < height / 2; y++)
+    {
+        uint8_t *top = rgba.data() + y * rowSize;
+        uint8_t *bottom = rgba.data() + (height - 1 - y) * rowSize;
+        std::copy(top, top + rowSize, row.data());
+        std::copy(bottom, bottom + rowSize, top);
+        std::copy(row.data(), row.data() + rowSize, bottom);
+    }
+}
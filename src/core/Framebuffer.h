@@ -0,0 +1,42 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+// Offscreen render target with an RGBA8 colour texture and a depth/stencil renderbuffer.
+// The colour texture can be shown directly in ImGui or read back for captures.
+class Framebuffer
+{
+public:
+    Framebuffer();
+    ~Framebuffer();
+
+    Framebuffer(const Framebuffer &) = delete;
+    Framebuffer &operator=(const Framebuffer &) = delete;
+
+    // (Re)creates the attachments if the size changed; returns true when it did
+    bool Resize(int width, int height);
+
+    // Binds the framebuffer and sets the viewport to cover it, remembering the previous state
+    void Bind();
+    // Restores the framebuffer and viewport that were bound before Bind()
+    void Unbind();
+
+    // Reads the colour attachment back as RGBA8 with the top row first
+    void ReadPixels(std::vector<uint8_t> &rgba);
+
+    GLuint GetColorTexture() const { return colorTexture; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    bool IsValid() const { return framebuffer != 0; }
+
+private:
+    void Release();
+
+    GLuint framebuffer;
+    GLuint colorTexture;
+    GLuint depthRenderbuffer;
+    int width, height;
+    GLint previousFramebuffer;
+    GLint previousViewport[4];
+};
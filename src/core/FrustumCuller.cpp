@@ -0,0 +1,149 @@
+#include "FrustumCuller.h"
+#include <cmath>
+
+Frustum Frustum::FromMatrix(const glm::mat4 &viewProjection)
+{
+    // Rows of the matrix; glm stores columns, so gather element i of every column
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0]; // Left
+    frustum.planes[1] = rows[3] - rows[0]; // Right
+    frustum.planes[2] = rows[3] + rows[1]; // Bottom
+    frustum.planes[3] = rows[3] - rows[1]; // Top
+    frustum.planes[4] = rows[3] + rows[2]; // Near
+    frustum.planes[5] = rows[3] - rows[2]; // Far
+
+    // Normalise so plane distances are in world units and comparable with radii
+    for (glm::vec4 &plane : frustum.planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+        {
+            plane /= length;
+        }
+    }
+    return frustum;
+}
+
+void FrustumCuller::Clear()
+{
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+    radius.clear();
+    visibility.clear();
+}
+
+uint32_t FrustumCuller::Add(const AABB &worldBox, const BoundingSphere &worldSphere)
+{
+    glm::vec3 center = worldBox.GetCenter();
+    glm::vec3 extents = worldBox.GetExtents();
+
+    // Both tests share the box centre, so the sphere is widened to be centred there as well
+    float sphereRadius = worldSphere.radius + glm::length(worldSphere.center - center);
+
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    extentX.push_back(extents.x);
+    extentY.push_back(extents.y);
+    extentZ.push_back(extents.z);
+    radius.push_back(sphereRadius);
+    visibility.push_back(1);
+    return static_cast<uint32_t>(visibility.size() - 1);
+}
+
+void FrustumCuller::Cull(const Frustum &frustum)
+{
+    size_t count = visibility.size();
+    size_t simdEnd = 0;
+
+#ifdef EGE_SIMD_SSE
+    simdEnd = count & ~static_cast<size_t>(3);
+    CullSSE(frustum, simdEnd);
+#endif
+    CullScalar(frustum, simdEnd, count);
+
+    stats.tested = static_cast<uint32_t>(count);
+    stats.visible = 0;
+    for (uint8_t visible : visibility)
+    {
+        stats.visible += visible;
+    }
+    stats.culled = stats.tested - stats.visible;
+}
+
+void FrustumCuller::CullScalar(const Frustum &frustum, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        uint8_t visible = 1;
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+            float boxRadius = std::fabs(plane.x) * extentX[i] + std::fabs(plane.y) * extentY[i] + std::fabs(plane.z) * extentZ[i];
+            if (distance < -std::fmin(boxRadius, radius[i]))
+            {
+                visible = 0;
+                break;
+            }
+        }
+        visibility[i] = visible;
+    }
+}
+
+#ifdef EGE_SIMD_SSE
+void FrustumCuller::CullSSE(const Frustum &frustum, size_t end)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    // Broadcast every plane component once; they are reused for the whole array
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    __m128 absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+        planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+        planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+        planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+        absX[p] = _mm_andnot_ps(signMask, planeX[p]);
+        absY[p] = _mm_andnot_ps(signMask, planeY[p]);
+        absZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+    }
+
+    for (size_t i = 0; i < end; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&centerX[i]);
+        __m128 cy = _mm_loadu_ps(&centerY[i]);
+        __m128 cz = _mm_loadu_ps(&centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&extentX[i]);
+        __m128 ey = _mm_loadu_ps(&extentY[i]);
+        __m128 ez = _mm_loadu_ps(&extentZ[i]);
+        __m128 r = _mm_loadu_ps(&radius[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+            __m128 limit = _mm_xor_ps(_mm_min_ps(boxRadius, r), signMask);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, limit));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        visibility[i + 0] = (mask & 1) ? 0 : 1;
+        visibility[i + 1] = (mask & 2) ? 0 : 1;
+        visibility[i + 2] = (mask & 4) ? 0 : 1;
+        visibility[i + 3] = (mask & 8) ? 0 : 1;
+    }
+}
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "../scene/Bounds.h"
+#include "Simd.h"
+
+// Six planes (left, right, bottom, top, near, far) with normals pointing inside.
+// A point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // Gribb/Hartmann extraction from a combined projection * view matrix
+    static Frustum FromMatrix(const glm::mat4 &viewProjection);
+};
+
+struct CullStats
+{
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    uint32_t culled = 0;
+};
+
+// Culls world-space bounds against a frustum.
+// An object is culled as soon as either its box or its sphere lies outside a plane: both enclose
+// the mesh, so either one being outside is enough, and whichever is tighter for that plane wins.
+// Bounds are stored structure-of-arrays so the plane tests run four objects at a time with SSE.
+class FrustumCuller
+{
+public:
+    void Clear();
+
+    // Returns the index used to query visibility after Cull
+    uint32_t Add(const AABB &worldBox, const BoundingSphere &worldSphere);
+
+    void Cull(const Frustum &frustum);
+
+    bool IsVisible(uint32_t index) const { return visibility[index] != 0; }
+    const CullStats &GetStats() const { return stats; }
+
+private:
+    void CullScalar(const Frustum &frustum, size_t begin, size_t end);
+#ifdef EGE_SIMD_SSE
+    void CullSSE(const Frustum &frustum, size_t end);
+#endif
+
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+    std::vector<uint8_t> visibility;
+    CullStats stats;
+};
@@ -0,0 +1,62 @@
+#include "GLStateCache.h"
+
+GLStateCache::GLStateCache()
+{
+    Reset();
+}
+
+void GLStateCache::Reset()
+{
+    currentProgram = Unknown;
+    currentVertexArray = Unknown;
+    activeUnit = Unknown;
+    for (unsigned int i = 0; i < MaxTextureUnits; i++)
+    {
+        boundTextures[i] = Unknown;
+    }
+    stats = RenderStats();
+}
+
+void GLStateCache::UseProgram(GLuint program)
+{
+    if (currentProgram == program)
+    {
+        stats.redundantSkipped++;
+        return;
+    }
+    glUseProgram(program);
+    currentProgram = program;
+    stats.programChanges++;
+}
+
+void GLStateCache::BindTexture(unsigned int unit, GLuint texture)
+{
+    if (unit < MaxTextureUnits && boundTextures[unit] == texture)
+    {
+        stats.redundantSkipped++;
+        return;
+    }
+    if (activeUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (unit < MaxTextureUnits)
+    {
+        boundTextures[unit] = texture;
+    }
+    stats.textureChanges++;
+}
+
+void GLStateCache::BindVertexArray(GLuint vertexArray)
+{
+    if (currentVertexArray == vertexArray)
+    {
+        stats.redundantSkipped++;
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    currentVertexArray = vertexArray;
+    stats.vertexArrayChanges++;
+}
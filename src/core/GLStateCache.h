@@ -0,0 +1,46 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+
+// Counters the renderer collects each frame to verify batching and sorting
+struct RenderStats
+{
+    uint32_t culled = 0;             // Mesh instances rejected by frustum culling
+    uint32_t submitted = 0;          // Draw commands pushed into the render queue
+    uint32_t drawCalls = 0;          // glDraw* calls actually issued
+    uint32_t instances = 0;          // Instances drawn across all draw calls
+    uint32_t programChanges = 0;     // glUseProgram calls issued
+    uint32_t textureChanges = 0;     // glBindTexture calls issued
+    uint32_t vertexArrayChanges = 0; // glBindVertexArray calls issued
+    uint32_t redundantSkipped = 0;   // Binds dropped because the state was already current
+
+    uint32_t StateChanges() const { return programChanges + textureChanges + vertexArrayChanges; }
+};
+
+// Shadows the GL bindings the renderer touches and skips calls that would not change anything.
+// Reset() must be called whenever other code (ImGui, gizmos) may have changed GL state behind its back.
+class GLStateCache
+{
+public:
+    static const unsigned int MaxTextureUnits = 16;
+
+    GLStateCache();
+
+    void Reset();
+
+    void UseProgram(GLuint program);
+    void BindTexture(unsigned int unit, GLuint texture);
+    void BindVertexArray(GLuint vertexArray);
+
+    RenderStats &GetStats() { return stats; }
+    const RenderStats &GetStats() const { return stats; }
+
+private:
+    static const GLuint Unknown = 0xFFFFFFFFu;
+
+    GLuint currentProgram;
+    GLuint currentVertexArray;
+    unsigned int activeUnit;
+    GLuint boundTextures[MaxTextureUnits];
+    RenderStats stats;
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+const uint64_t HashSeed = 14695981039346656037ull;
+
+// FNV-1a, 64-bit; pass a previous result as hash to continue it
+inline uint64_t HashBytes(const void *data, size_t size, uint64_t hash = HashSeed)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,124 @@
+#include "ImageWriter.h"
+#include "Log.h"
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+    uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+    {
+        static uint32_t table[256];
+        static bool tableReady = false;
+        if (!tableReady)
+        {
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            tableReady = true;
+        }
+
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void AppendBigEndian(std::vector<uint8_t> &out, uint32_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void WriteChunk(std::ofstream &file, const char *type, const std::vector<uint8_t> &data)
+    {
+        std::vector<uint8_t> chunk;
+        chunk.reserve(data.size() + 12);
+        AppendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+
+        // The CRC covers the type and the data, not the length
+        AppendBigEndian(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+        file.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+    }
+}
+
+bool WritePNG(const std::string &path, int width, int height, const std::vector<uint8_t> &rgba)
+{
+    if (width <= 0 || height <= 0 || rgba.size() < static_cast<size_t>(width) * height * 4)
+    {
+        LOG_ERROR(LogCategory::Core, "WritePNG: invalid image for {}", path);
+        return false;
+    }
+
+    // Raw scanlines, each prefixed with filter type 0 (none)
+    size_t rowSize = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba.begin() + y * rowSize, rgba.begin() + (y + 1) * rowSize);
+    }
+
+    // zlib stream made of stored deflate blocks (at most 65535 bytes each)
+    std::vector<uint8_t> compressed;
+    compressed.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    compressed.push_back(0x78);
+    compressed.push_back(0x01);
+    size_t offset = 0;
+    do
+    {
+        size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+        bool finalBlock = offset + blockSize == raw.size();
+        compressed.push_back(finalBlock ? 1 : 0);
+        compressed.push_back(static_cast<uint8_t>(blockSize));
+        compressed.push_back(static_cast<uint8_t>(blockSize >> 8));
+        compressed.push_back(static_cast<uint8_t>(~blockSize));
+        compressed.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        compressed.insert(compressed.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+
+    uint32_t adlerA = 1, adlerB = 0;
+    for (uint8_t byte : raw)
+    {
+        adlerA = (adlerA + byte) % 65521;
+        adlerB = (adlerB + adlerA) % 65521;
+    }
+    AppendBigEndian(compressed, (adlerB << 16) | adlerA);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        LOG_ERROR(LogCategory::Core, "WritePNG: failed to open {}", path);
+        return false;
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    AppendBigEndian(header, static_cast<uint32_t>(width));
+    AppendBigEndian(header, static_cast<uint32_t>(height));
+    header.push_back(8); // Bit depth
+    header.push_back(6); // Colour type RGBA
+    header.push_back(0); // Compression
+    header.push_back(0); // Filter
+    header.push_back(0); // No interlace
+    WriteChunk(file, "IHDR", header);
+    WriteChunk(file, "IDAT", compressed);
+    WriteChunk(file, "IEND", std::vector<uint8_t>());
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Writes 8-bit RGBA pixels (top row first) as a PNG file.
+// The image data is stored uncompressed inside the zlib stream: captures stay byte-exact
+// and cheap to produce, which is what image-diff tests need.
+bool WritePNG(const std::string &path, int width, int height, const std::vector<uint8_t> &rgba);
@@ -0,0 +1,455 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+struct JobHandle::Job
+{
+    std::function<void()> task;
+    Job *parent = nullptr;                     // Group that waits for this job (ParallelFor)
+    std::atomic<int> unfinished{1};            // The job itself plus its unfinished children
+    std::atomic<int> pendingDependencies{0};   // Dependencies that have not finished yet
+    std::atomic<int> references{1};            // Handles plus one held by the scheduler until completion
+    std::atomic<bool> finished{false};
+    std::atomic_flag continuationLock = ATOMIC_FLAG_INIT;
+    std::vector<Job *> continuations;          // Jobs waiting for this one
+    JobAffinity affinity = JobAffinity::Any;
+};
+
+namespace
+{
+    using Job = JobHandle::Job;
+
+    struct ThreadSlot
+    {
+        const JobSystem *owner = nullptr;
+        int queueIndex = -1;
+    };
+
+    thread_local ThreadSlot currentThread;
+
+    void Release(Job *job)
+    {
+        if (job && job->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete job;
+        }
+    }
+
+    void LockContinuations(Job *job)
+    {
+        while (job->continuationLock.test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void UnlockContinuations(Job *job)
+    {
+        job->continuationLock.clear(std::memory_order_release);
+    }
+}
+
+JobHandle::JobHandle(const JobHandle &other) : job(other.job)
+{
+    if (job)
+    {
+        job->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+JobHandle::~JobHandle()
+{
+    Release(job);
+}
+
+bool JobHandle::IsFinished() const
+{
+    return !job || job->finished.load(std::memory_order_acquire);
+}
+
+bool JobSystem::WorkQueue::Push(Job *job)
+{
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= Capacity)
+    {
+        return false;
+    }
+    buffer[b & (Capacity - 1)].store(job, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release); // Publishes the slot to thieves
+    return true;
+}
+
+JobSystem::Job *JobSystem::WorkQueue::Pop()
+{
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        // Empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job *job = buffer[b & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // Last element: race against thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job *JobSystem::WorkQueue::Steal()
+{
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+    {
+        return nullptr;
+    }
+
+    Job *job = buffer[t & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr; // Lost to the owner or another thief
+    }
+    return job;
+}
+
+JobSystem::JobSystem(unsigned int workerCount) : mainThreadId(std::this_thread::get_id())
+{
+    if (workerCount == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i <= workerCount; i++)
+    {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    currentThread.owner = this;
+    currentThread.queueIndex = 0;
+
+    workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&JobSystem::WorkerLoop, this, static_cast<int>(i + 1));
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    if (currentThread.owner == this)
+    {
+        currentThread = ThreadSlot();
+    }
+}
+
+bool JobSystem::IsMainThread() const
+{
+    return std::this_thread::get_id() == mainThreadId;
+}
+
+int JobSystem::CurrentQueueIndex() const
+{
+    return currentThread.owner == this ? currentThread.queueIndex : -1;
+}
+
+JobSystem::Job *JobSystem::CreateJob(std::function<void()> task, JobAffinity affinity)
+{
+    Job *job = new Job();
+    job->task = std::move(task);
+    job->affinity = affinity;
+    return job;
+}
+
+bool JobSystem::AddDependency(Job *job, Job *dependency)
+{
+    LockContinuations(dependency);
+    bool pending = !dependency->finished.load(std::memory_order_acquire);
+    if (pending)
+    {
+        job->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+        dependency->continuations.push_back(job);
+    }
+    UnlockContinuations(dependency);
+    return pending;
+}
+
+JobHandle JobSystem::Schedule(std::function<void()> task, std::initializer_list<JobHandle> dependencies, JobAffinity affinity)
+{
+    return Schedule(std::move(task), std::vector<JobHandle>(dependencies), affinity);
+}
+
+JobHandle JobSystem::Schedule(std::function<void()> task, const std::vector<JobHandle> &dependencies, JobAffinity affinity)
+{
+    Job *job = CreateJob(std::move(task), affinity);
+    job->references.fetch_add(1, std::memory_order_relaxed); // For the returned handle
+    JobHandle handle(job);
+
+    // The extra count keeps the job from starting while dependencies are still being registered
+    job->pendingDependencies.store(1, std::memory_order_relaxed);
+    for (const JobHandle &dependency : dependencies)
+    {
+        if (dependency.job)
+        {
+            AddDependency(job, dependency.job);
+        }
+    }
+    if (job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        Enqueue(job);
+    }
+    return handle;
+}
+
+void JobSystem::Enqueue(Job *job)
+{
+    if (job->affinity == JobAffinity::MainThread)
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        mainThreadQueue.push_back(job);
+        return;
+    }
+
+    int queueIndex = CurrentQueueIndex();
+    if (job->affinity == JobAffinity::Background)
+    {
+        // Never in a deque, where the main thread could steal it
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        backgroundQueue.push_back(job);
+    }
+    else if (queueIndex < 0 || !queues[queueIndex]->Push(job))
+    {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        injectionQueue.push_back(job);
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    wake.notify_one();
+}
+
+void JobSystem::Execute(Job *job)
+{
+    if (job->task)
+    {
+        job->task();
+    }
+    Finish(job);
+}
+
+void JobSystem::Finish(Job *job)
+{
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return; // Children are still running
+    }
+
+    std::vector<Job *> ready;
+    LockContinuations(job);
+    job->finished.store(true, std::memory_order_release);
+    ready.swap(job->continuations);
+    UnlockContinuations(job);
+
+    for (Job *continuation : ready)
+    {
+        if (continuation->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Enqueue(continuation);
+        }
+    }
+
+    if (job->parent)
+    {
+        Finish(job->parent);
+    }
+    Release(job); // The scheduler's reference
+}
+
+JobSystem::Job *JobSystem::FindJob(int queueIndex, bool includeMainThreadJobs, bool includeBackgroundJobs)
+{
+    if (includeMainThreadJobs)
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        if (!mainThreadQueue.empty())
+        {
+            Job *job = mainThreadQueue.front();
+            mainThreadQueue.pop_front();
+            return job;
+        }
+    }
+
+    Job *job = queueIndex >= 0 ? queues[queueIndex]->Pop() : nullptr;
+
+    if (!job)
+    {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        if (!injectionQueue.empty())
+        {
+            job = injectionQueue.front();
+            injectionQueue.pop_front();
+        }
+    }
+
+    if (!job && includeBackgroundJobs)
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        if (!backgroundQueue.empty())
+        {
+            job = backgroundQueue.front();
+            backgroundQueue.pop_front();
+        }
+    }
+
+    if (!job)
+    {
+        // Start at a different victim per thief so they do not all hammer the same deque
+        size_t count = queues.size();
+        size_t start = static_cast<size_t>(queueIndex + 1);
+        for (size_t i = 0; i < count && !job; i++)
+        {
+            size_t victim = (start + i) % count;
+            if (static_cast<int>(victim) != queueIndex)
+            {
+                job = queues[victim]->Steal();
+            }
+        }
+    }
+
+    if (job)
+    {
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+void JobSystem::WorkerLoop(int queueIndex)
+{
+    currentThread.owner = this;
+    currentThread.queueIndex = queueIndex;
+    PROFILE_THREAD("Worker " + std::to_string(queueIndex));
+
+    int idleSpins = 0;
+    for (;;)
+    {
+        Job *job = FindJob(queueIndex, false, true);
+        if (job)
+        {
+            Execute(job);
+            idleSpins = 0;
+            continue;
+        }
+
+        if (stopping.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        // Spin briefly so bursts of small jobs do not pay for a sleep, then park
+        if (++idleSpins < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait_for(lock, std::chrono::milliseconds(2), [this]
+                      { return stopping.load(std::memory_order_acquire) || queuedJobs.load(std::memory_order_acquire) > 0; });
+        idleSpins = 0;
+    }
+}
+
+void JobSystem::Wait(const JobHandle &handle)
+{
+    int queueIndex = CurrentQueueIndex();
+    bool mainThread = IsMainThread();
+    while (!handle.IsFinished())
+    {
+        // A Background job could run far longer than what is being waited for
+        Job *job = FindJob(queueIndex, mainThread, false);
+        if (job)
+        {
+            Execute(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    std::deque<Job *> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        jobs.swap(mainThreadQueue);
+    }
+    for (Job *job : jobs)
+    {
+        Execute(job);
+    }
+}
+
+void JobSystem::SplitRange(Job *group, size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)> &body)
+{
+    // Hand the upper halves to other threads and keep splitting the lower half, so thieves take large pieces
+    while (end - begin > grainSize)
+    {
+        size_t middle = begin + (end - begin) / 2;
+        Job *child = CreateJob([this, group, middle, end, grainSize, &body]
+                               { SplitRange(group, middle, end, grainSize, body); },
+                               JobAffinity::Any);
+        child->parent = group;
+        group->unfinished.fetch_add(1, std::memory_order_relaxed);
+        Enqueue(child);
+        end = middle;
+    }
+    body(begin, end);
+}
+
+void JobSystem::ParallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)> &body, size_t grainSize)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    size_t count = end - begin;
+    if (grainSize == 0)
+    {
+        grainSize = std::max<size_t>(1, count / (GetThreadCount() * 4));
+    }
+    if (count <= grainSize || workers.empty())
+    {
+        body(begin, end);
+        return;
+    }
+
+    // The group finishes once the calling thread's share and every spawned piece are done
+    Job *group = CreateJob(nullptr, JobAffinity::Any);
+    group->references.fetch_add(1, std::memory_order_relaxed);
+    JobHandle handle(group);
+
+    SplitRange(group, begin, end, grainSize, body);
+    Finish(group);
+    Wait(handle);
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+enum class JobAffinity : uint8_t
+{
+    Any,        // Any worker, or the main thread while it waits
+    MainThread, // Only the thread that created the JobSystem (e.g. GL calls)
+    Background  // Workers only, never the main thread; for long blocking work such as file parsing
+};
+
+// Reference-counted handle to a scheduled job. A job counts as finished once its task and
+// every child spawned from it have completed; jobs scheduled with it as a dependency start then.
+class JobHandle
+{
+public:
+    JobHandle() : job(nullptr) {}
+    JobHandle(const JobHandle &other);
+    JobHandle(JobHandle &&other) noexcept : job(other.job) { other.job = nullptr; }
+    JobHandle &operator=(JobHandle other) noexcept
+    {
+        std::swap(job, other.job);
+        return *this;
+    }
+    ~JobHandle();
+
+    bool IsValid() const { return job != nullptr; }
+    bool IsFinished() const;
+
+    struct Job; // Defined in JobSystem.cpp
+
+private:
+    friend class JobSystem;
+    explicit JobHandle(Job *job) : job(job) {}
+
+    Job *job;
+};
+
+// Work-stealing job runtime.
+//
+// Every worker owns a Chase-Lev deque: it pushes and pops its own jobs at the bottom (LIFO, cache
+// warm) while idle workers steal the oldest jobs from the top. Threads that are not part of the
+// system submit through a shared injection queue, and main-thread jobs wait in their own queue
+// until the main thread runs them from Wait() or RunMainThreadJobs().
+//
+// While the main thread waits it helps with Any jobs, including those it scheduled itself, which
+// land in its own deque. Work that may take longer than a frame is scheduled as Background: those
+// jobs sit in a queue that only idle workers pop from their top-level loop, never a thread inside
+// Wait(), so they can neither stall the main loop nor a job the main loop is waiting for.
+class JobSystem
+{
+public:
+    // 0 picks one worker per hardware thread, minus the main thread
+    explicit JobSystem(unsigned int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Runs task once every dependency has finished
+    JobHandle Schedule(std::function<void()> task, std::initializer_list<JobHandle> dependencies = {},
+                       JobAffinity affinity = JobAffinity::Any);
+    JobHandle Schedule(std::function<void()> task, const std::vector<JobHandle> &dependencies,
+                       JobAffinity affinity = JobAffinity::Any);
+
+    // Blocks until the job finished, running other jobs in the meantime: MainThread and Any jobs on
+    // the main thread, Any jobs on a worker. Background jobs are never run here, so a job must not
+    // wait for one unless another worker is free to pick it up.
+    void Wait(const JobHandle &handle);
+
+    // Executes the queued main-thread jobs; call once per frame from the main loop
+    void RunMainThreadJobs();
+
+    // Calls body(first, last) over sub-ranges of [begin, end) in parallel and returns when all are done.
+    // A grain size of 0 splits the range into a few chunks per thread.
+    void ParallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)> &body, size_t grainSize = 0);
+
+    // Workers plus the main thread
+    size_t GetThreadCount() const { return workers.size() + 1; }
+    bool IsMainThread() const;
+    // 0 on the main thread, 1 to GetThreadCount() - 1 on the workers, -1 on any other thread
+    int GetThreadIndex() const { return CurrentQueueIndex(); }
+
+private:
+    using Job = JobHandle::Job;
+
+    // Fixed-capacity Chase-Lev work-stealing deque
+    class WorkQueue
+    {
+    public:
+        static const int64_t Capacity = 4096; // Power of two
+
+        bool Push(Job *job);   // Owner only; false when full
+        Job *Pop();            // Owner only
+        Job *Steal();          // Any thread
+
+    private:
+        std::unique_ptr<std::atomic<Job *>[]> buffer{new std::atomic<Job *>[Capacity]};
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+    };
+
+    Job *CreateJob(std::function<void()> task, JobAffinity affinity);
+    bool AddDependency(Job *job, Job *dependency);
+    void Enqueue(Job *job);
+    void Execute(Job *job);
+    void Finish(Job *job);
+    Job *FindJob(int queueIndex, bool includeMainThreadJobs, bool includeBackgroundJobs);
+    void WorkerLoop(int queueIndex);
+    void SplitRange(Job *group, size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)> &body);
+    int CurrentQueueIndex() const;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues; // Index 0 belongs to the main thread
+    std::vector<std::thread> workers;
+    std::thread::id mainThreadId;
+
+    std::mutex injectionMutex;
+    std::deque<Job *> injectionQueue; // Jobs from threads that own no deque
+    std::mutex mainThreadMutex;
+    std::deque<Job *> mainThreadQueue;
+    std::mutex backgroundMutex;
+    std::deque<Job *> backgroundQueue; // Popped by idle workers only, never from Wait()
+
+    std::atomic<int64_t> queuedJobs{0}; // Approximate, only used to decide whether to sleep
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+};
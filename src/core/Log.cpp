@@ -0,0 +1,466 @@
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point startTime = Clock::now();
+
+    int64_t MicrosecondsSinceStart()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime).count();
+    }
+
+    const char *LevelName(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Trace:
+            return "TRACE";
+        case LogLevel::Debug:
+            return "DEBUG";
+        case LogLevel::Info:
+            return "INFO ";
+        case LogLevel::Warning:
+            return "WARN ";
+        case LogLevel::Error:
+            return "ERROR";
+        default:
+            return "     ";
+        }
+    }
+
+    const char *CategoryName(LogCategory category)
+    {
+        static const char *names[] = {"Core", "Render", "Scene", "ECS", "Camera", "Editor", "Assets"};
+        size_t index = static_cast<size_t>(category);
+        return index < sizeof(names) / sizeof(names[0]) ? names[index] : "?";
+    }
+
+    struct LogRecord
+    {
+        int64_t timestamp;
+        const char *format;
+        uint32_t suppressed;
+        LogLevel level;
+        LogCategory category;
+        uint16_t payloadSize;
+        uint8_t payload[LogPayload::Capacity];
+    };
+
+    template <typename T>
+    T ReadValue(const uint8_t *&cursor)
+    {
+        T value;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    // Appends the next argument of the payload and advances the cursor past it
+    void FormatArgument(std::string &out, const uint8_t *&cursor)
+    {
+        char buffer[64];
+        uint8_t tag = *cursor++;
+        switch (tag)
+        {
+        case LogPayload::Signed:
+            std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(ReadValue<int64_t>(cursor)));
+            out += buffer;
+            break;
+        case LogPayload::Unsigned:
+            std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(ReadValue<uint64_t>(cursor)));
+            out += buffer;
+            break;
+        case LogPayload::Float:
+            std::snprintf(buffer, sizeof(buffer), "%g", ReadValue<double>(cursor));
+            out += buffer;
+            break;
+        case LogPayload::Bool:
+            out += ReadValue<bool>(cursor) ? "true" : "false";
+            break;
+        case LogPayload::String:
+        {
+            uint16_t length = ReadValue<uint16_t>(cursor);
+            out.append(reinterpret_cast<const char *>(cursor), length);
+            cursor += length;
+            break;
+        }
+        case LogPayload::Vector:
+        {
+            uint8_t count = *cursor++;
+            out += '(';
+            for (uint8_t i = 0; i < count; i++)
+            {
+                std::snprintf(buffer, sizeof(buffer), i == 0 ? "%g" : ", %g", static_cast<double>(ReadValue<float>(cursor)));
+                out += buffer;
+            }
+            out += ')';
+            break;
+        }
+        }
+    }
+
+    void FormatRecord(std::string &out, const LogRecord &record)
+    {
+        char prefix[64];
+        std::snprintf(prefix, sizeof(prefix), "[%10.4f] [%s] %s ", record.timestamp / 1000000.0, CategoryName(record.category),
+                      LevelName(record.level));
+        out = prefix;
+
+        // Substitute "{}" with the arguments in order; surplus placeholders are kept verbatim
+        const uint8_t *cursor = record.payload;
+        const uint8_t *end = record.payload + record.payloadSize;
+        for (const char *c = record.format; *c; c++)
+        {
+            if (c[0] == '{' && c[1] == '}' && cursor < end)
+            {
+                FormatArgument(out, cursor);
+                c++;
+                continue;
+            }
+            out += *c;
+        }
+
+        if (record.suppressed > 0)
+        {
+            std::snprintf(prefix, sizeof(prefix), " (%u similar messages suppressed)", record.suppressed);
+            out += prefix;
+        }
+        out += '\n';
+    }
+
+    // Bounded multi-producer, single-consumer ring. Every slot carries a sequence number that tells
+    // producers whether it is free for their ticket and the consumer whether it has been published.
+    class LogRing
+    {
+    public:
+        static const size_t SlotCount = 4096; // Power of two
+
+        LogRing() : slots(new Slot[SlotCount])
+        {
+            for (size_t i = 0; i < SlotCount; i++)
+            {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool TryPush(const LogRecord &record)
+        {
+            size_t position = writePosition.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Slot &slot = slots[position & (SlotCount - 1)];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0)
+                {
+                    if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        slot.record = record;
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false; // Full
+                }
+                else
+                {
+                    position = writePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool TryPop(LogRecord &record)
+        {
+            Slot &slot = slots[readPosition & (SlotCount - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+            {
+                return false;
+            }
+            record = slot.record;
+            slot.sequence.store(readPosition + SlotCount, std::memory_order_release);
+            readPosition++;
+            return true;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            LogRecord record;
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<size_t> writePosition{0};
+        alignas(64) size_t readPosition = 0; // Only touched by the consumer thread
+    };
+
+    class Logger
+    {
+    public:
+        Logger() : running(true), submitted(0), written(0), dropped(0), file(nullptr)
+        {
+            worker = std::thread(&Logger::WorkerLoop, this);
+        }
+
+        ~Logger()
+        {
+            Stop();
+        }
+
+        void Push(const LogRecord &record)
+        {
+            if (!running.load(std::memory_order_acquire))
+            {
+                // Background thread is gone (shutdown or static destruction); write in place
+                std::lock_guard<std::mutex> lock(outputMutex);
+                WriteRecord(record);
+                FlushOutputs();
+                return;
+            }
+
+            if (ring.TryPush(record))
+            {
+                submitted.fetch_add(1, std::memory_order_release);
+            }
+            else
+            {
+                // Never block the caller; the loss is reported by the background thread
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void Flush()
+        {
+            uint64_t target = submitted.load(std::memory_order_acquire);
+            while (running.load(std::memory_order_acquire) && written.load(std::memory_order_acquire) < target)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+
+        void Stop()
+        {
+            if (running.exchange(false))
+            {
+                worker.join();
+            }
+            std::lock_guard<std::mutex> lock(outputMutex);
+
+            // Producers that passed the running check just before the stop may still have queued something
+            LogRecord record;
+            while (ring.TryPop(record))
+            {
+                WriteRecord(record);
+            }
+            FlushOutputs();
+            if (file)
+            {
+                std::fclose(file);
+                file = nullptr;
+            }
+        }
+
+        void SetOutputFile(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            if (file)
+            {
+                std::fclose(file);
+                file = nullptr;
+            }
+            if (!path.empty())
+            {
+                file = std::fopen(path.c_str(), "w");
+            }
+        }
+
+    private:
+        void WorkerLoop()
+        {
+            LogRecord record;
+            for (;;)
+            {
+                bool stopping = !running.load(std::memory_order_acquire);
+                bool any = false;
+                {
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    while (ring.TryPop(record))
+                    {
+                        WriteRecord(record);
+                        written.fetch_add(1, std::memory_order_release);
+                        any = true;
+                    }
+
+                    uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+                    if (lost > 0)
+                    {
+                        std::fprintf(stderr, "[Log] %llu messages dropped, ring buffer full\n", static_cast<unsigned long long>(lost));
+                    }
+                    if (any || lost > 0)
+                    {
+                        FlushOutputs();
+                    }
+                }
+
+                if (stopping)
+                {
+                    return; // The queue was drained after the stop was observed
+                }
+                if (!any)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        }
+
+        // Caller holds outputMutex
+        void WriteRecord(const LogRecord &record)
+        {
+            FormatRecord(line, record);
+            std::fwrite(line.data(), 1, line.size(), record.level >= LogLevel::Warning ? stderr : stdout);
+            if (file)
+            {
+                std::fwrite(line.data(), 1, line.size(), file);
+            }
+        }
+
+        void FlushOutputs()
+        {
+            std::fflush(stdout);
+            std::fflush(stderr);
+            if (file)
+            {
+                std::fflush(file);
+            }
+        }
+
+        LogRing ring;
+        std::atomic<bool> running;
+        std::atomic<uint64_t> submitted;
+        std::atomic<uint64_t> written;
+        std::atomic<uint64_t> dropped;
+        std::mutex outputMutex; // Serialises the writer thread with synchronous fallbacks and file changes
+        std::string line;
+        std::FILE *file;
+        std::thread worker;
+    };
+
+    Logger &GetLogger()
+    {
+        static Logger logger;
+        return logger;
+    }
+}
+
+bool LogSite::Allow()
+{
+    int64_t now = MicrosecondsSinceStart();
+    int64_t start = windowStart.load(std::memory_order_relaxed);
+    if (now - start >= 1000000 && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+    {
+        windowCount.store(0, std::memory_order_relaxed);
+    }
+
+    if (windowCount.fetch_add(1, std::memory_order_relaxed) >= maxPerSecond)
+    {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void LogPayload::Put(Tag tag, const void *value, size_t bytes)
+{
+    if (size + 1 + bytes > Capacity)
+    {
+        return;
+    }
+    data[size++] = tag;
+    std::memcpy(data + size, value, bytes);
+    size += static_cast<uint16_t>(bytes);
+}
+
+void LogPayload::AddString(const char *value, size_t length)
+{
+    const size_t header = 1 + sizeof(uint16_t);
+    if (size + header > Capacity)
+    {
+        return;
+    }
+
+    // Long strings are cut to the space left in the record
+    uint16_t stored = static_cast<uint16_t>(std::min(length, Capacity - size - header));
+    data[size++] = String;
+    std::memcpy(data + size, &stored, sizeof(stored));
+    size += sizeof(stored);
+    std::memcpy(data + size, value, stored);
+    size += stored;
+}
+
+void LogPayload::AddVector(const float *values, uint8_t count)
+{
+    size_t bytes = count * sizeof(float);
+    if (size + 2 + bytes > Capacity)
+    {
+        return;
+    }
+    data[size++] = Vector;
+    data[size++] = count;
+    std::memcpy(data + size, values, bytes);
+    size += static_cast<uint16_t>(bytes);
+}
+
+namespace Log
+{
+    void SetLevel(LogCategory category, LogLevel level)
+    {
+        categoryLevels[static_cast<size_t>(category)].store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    void SetLevel(LogLevel level)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(LogCategory::Count); i++)
+        {
+            SetLevel(static_cast<LogCategory>(i), level);
+        }
+    }
+
+    void SetOutputFile(const std::string &path)
+    {
+        GetLogger().SetOutputFile(path);
+    }
+
+    void Flush()
+    {
+        GetLogger().Flush();
+    }
+
+    void Shutdown()
+    {
+        GetLogger().Stop();
+    }
+
+    void Submit(LogLevel level, LogCategory category, const char *format, const LogPayload &payload, uint32_t suppressed)
+    {
+        LogRecord record;
+        record.timestamp = MicrosecondsSinceStart();
+        record.format = format;
+        record.suppressed = suppressed;
+        record.level = level;
+        record.category = category;
+        record.payloadSize = payload.Size();
+        std::memcpy(record.payload, payload.Data(), payload.Size());
+        GetLogger().Push(record);
+    }
+}
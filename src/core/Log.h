@@ -0,0 +1,189 @@
+#pragma once
+#include <glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Asynchronous, levelled logging.
+//
+//   LOG_INFO(LogCategory::Render, "Loaded {} meshes in {} ms", count, milliseconds);
+//
+// Call sites only copy their arguments into a fixed-size record and push it onto a lock-free
+// ring; a background thread does the formatting and the writing. Messages below
+// EGE_LOG_MIN_LEVEL are compiled out, the rest are filtered per category at runtime, and
+// every call site is rate limited so a message inside a per-entity loop cannot flood the output.
+
+enum class LogLevel : uint8_t
+{
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warning = 3,
+    Error = 4,
+    Off = 5
+};
+
+enum class LogCategory : uint8_t
+{
+    Core,
+    Render,
+    Scene,
+    ECS,
+    Camera,
+    Editor,
+    Assets,
+    Count
+};
+
+// Lowest level that is compiled in; define it on the command line to strip more
+#ifndef EGE_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define EGE_LOG_MIN_LEVEL 2
+#else
+#define EGE_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// Per call-site state: the rate limit window and how many messages it swallowed
+struct LogSite
+{
+    explicit LogSite(uint32_t maxPerSecond) : maxPerSecond(maxPerSecond) {}
+
+    // False once the site has logged maxPerSecond messages in the current one-second window
+    bool Allow();
+
+    const uint32_t maxPerSecond;
+    std::atomic<int64_t> windowStart{0};
+    std::atomic<uint32_t> windowCount{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+// Arguments are stored as a tag byte followed by the raw value
+class LogPayload
+{
+public:
+    static const size_t Capacity = 440;
+
+    enum Tag : uint8_t
+    {
+        Signed,
+        Unsigned,
+        Float,
+        Bool,
+        String,
+        Vector
+    };
+
+    void Add(bool value) { Put(Bool, &value, 1); }
+    void Add(const char *value) { AddString(value ? value : "(null)", value ? std::strlen(value) : 6); }
+    void Add(char *value) { Add(static_cast<const char *>(value)); }
+    void Add(const std::string &value) { AddString(value.data(), value.size()); }
+    void Add(const glm::vec2 &value) { AddVector(&value.x, 2); }
+    void Add(const glm::vec3 &value) { AddVector(&value.x, 3); }
+    void Add(const glm::vec4 &value) { AddVector(&value.x, 4); }
+
+    template <typename T>
+    std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>> Add(T value)
+    {
+        if constexpr (std::is_enum_v<T>)
+        {
+            Add(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            double stored = static_cast<double>(value);
+            Put(Float, &stored, sizeof(stored));
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            int64_t stored = static_cast<int64_t>(value);
+            Put(Signed, &stored, sizeof(stored));
+        }
+        else
+        {
+            uint64_t stored = static_cast<uint64_t>(value);
+            Put(Unsigned, &stored, sizeof(stored));
+        }
+    }
+
+    const uint8_t *Data() const { return data; }
+    uint16_t Size() const { return size; }
+
+private:
+    void Put(Tag tag, const void *value, size_t bytes);
+    void AddString(const char *value, size_t length);
+    void AddVector(const float *values, uint8_t count);
+
+    uint8_t data[Capacity];
+    uint16_t size = 0;
+};
+
+namespace Log
+{
+    // Messages below this level are dropped for the category at runtime (default Info)
+    void SetLevel(LogCategory category, LogLevel level);
+    void SetLevel(LogLevel level);
+
+    inline std::atomic<uint8_t> categoryLevels[static_cast<size_t>(LogCategory::Count)] = {2, 2, 2, 2, 2, 2, 2};
+
+    // False for levels below EGE_LOG_MIN_LEVEL, whose messages are compiled out
+    constexpr bool IsCompiledIn(LogLevel level)
+    {
+#if EGE_LOG_MIN_LEVEL > 0
+        return static_cast<int>(level) >= EGE_LOG_MIN_LEVEL;
+#else
+        // Every level; comparing the unsigned level with 0 would warn under -Wtype-limits
+        static_cast<void>(level);
+        return true;
+#endif
+    }
+
+    inline bool IsEnabled(LogLevel level, LogCategory category)
+    {
+        return static_cast<uint8_t>(level) >= categoryLevels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    // Also mirror every message into a file; an empty path closes it
+    void SetOutputFile(const std::string &path);
+
+    // Blocks until the background thread has written everything queued so far
+    void Flush();
+
+    // Drains the queue and stops the background thread; later messages are written synchronously
+    void Shutdown();
+
+    // Hands a finished record to the ring; called by the LOG_* macros
+    void Submit(LogLevel level, LogCategory category, const char *format, const LogPayload &payload, uint32_t suppressed);
+
+    template <typename... Args>
+    void Write(LogLevel level, LogCategory category, LogSite &site, const char *format, const Args &...args)
+    {
+        LogPayload payload;
+        (payload.Add(args), ...);
+        Submit(level, category, format, payload, site.suppressed.exchange(0, std::memory_order_relaxed));
+    }
+}
+
+// The format string must be a literal: only its pointer is queued. Arguments go into "{}" placeholders.
+#define EGE_LOG_RATE_LIMITED(level, category, maxPerSecond, ...)                                   \
+    do                                                                                             \
+    {                                                                                              \
+        if constexpr (Log::IsCompiledIn(level))                                                    \
+        {                                                                                          \
+            static LogSite egeLogSite(maxPerSecond);                                               \
+            if (Log::IsEnabled(level, category) && egeLogSite.Allow())                             \
+            {                                                                                      \
+                Log::Write(level, category, egeLogSite, __VA_ARGS__);                              \
+            }                                                                                      \
+        }                                                                                          \
+    } while (0)
+
+#define EGE_LOG(level, category, ...) EGE_LOG_RATE_LIMITED(level, category, 20, __VA_ARGS__)
+
+#define LOG_TRACE(category, ...) EGE_LOG(LogLevel::Trace, category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) EGE_LOG(LogLevel::Debug, category, __VA_ARGS__)
+#define LOG_INFO(category, ...) EGE_LOG(LogLevel::Info, category, __VA_ARGS__)
+#define LOG_WARN(category, ...) EGE_LOG(LogLevel::Warning, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...) EGE_LOG(LogLevel::Error, category, __VA_ARGS__)
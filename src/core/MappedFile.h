@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. The pages are loaded by the OS on first touch, so
+// data can be handed to the GPU straight from the mapping without reading it into a buffer first.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Replaces any previous mapping; false if the file cannot be opened or is empty
+    bool Open(const std::string &path);
+    void Close();
+
+    const uint8_t *GetData() const { return data; }
+    size_t GetSize() const { return size; }
+    bool IsOpen() const { return data != nullptr; }
+
+private:
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *file = nullptr;    // HANDLE
+    void *mapping = nullptr; // HANDLE
+#endif
+};
@@ -0,0 +1,215 @@
+#include "Profiler.h"
+#include "Log.h"
+#include <json.hpp>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ProfileThreadBuffer>> threads; // Kept until exit; a thread may end mid-frame
+
+    std::deque<ProfileFrame> frames;
+    size_t historySize = 300;
+    bool paused = false;
+    int64_t frameStart = Profiler::Now();
+
+    // Ticks are mapped to nanoseconds by a rate measured over the whole run so far
+    const int64_t baseTicks = Profiler::Ticks();
+    const int64_t baseTime = Profiler::Now();
+
+    // Spins for a couple of milliseconds at startup, so the first frames already convert with a
+    // usable rate; EndFrame refines it as the run goes on
+    double MeasureNanosecondsPerTick()
+    {
+#ifdef EGE_PROFILE_TSC
+        int64_t time = Profiler::Now();
+        while (time - baseTime < 2000000)
+        {
+            time = Profiler::Now();
+        }
+        int64_t ticks = Profiler::Ticks();
+        if (ticks > baseTicks)
+        {
+            return static_cast<double>(time - baseTime) / static_cast<double>(ticks - baseTicks);
+        }
+#endif
+        return 1.0;
+    }
+
+    double nanosecondsPerTick = MeasureNanosecondsPerTick();
+
+    void Calibrate()
+    {
+#ifdef EGE_PROFILE_TSC
+        int64_t ticks = Profiler::Ticks();
+        int64_t time = Profiler::Now();
+        if (ticks > baseTicks && time - baseTime > 1000000)
+        {
+            nanosecondsPerTick = static_cast<double>(time - baseTime) / static_cast<double>(ticks - baseTicks);
+        }
+#endif
+    }
+
+    int64_t ToNanoseconds(int64_t ticks)
+    {
+        return baseTime + static_cast<int64_t>(static_cast<double>(ticks - baseTicks) * nanosecondsPerTick);
+    }
+}
+
+ProfileThreadBuffer &Profiler::CreateThreadBuffer()
+{
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    threads.push_back(std::make_unique<ProfileThreadBuffer>());
+    ProfileThreadBuffer &buffer = *threads.back();
+    buffer.index = static_cast<uint16_t>(threads.size() - 1);
+    buffer.name = "Thread " + std::to_string(buffer.index);
+    threadBuffer = &buffer;
+    return buffer;
+}
+
+void Profiler::SetThreadName(const std::string &name)
+{
+    ProfileThreadBuffer &buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    buffer.name = name;
+}
+
+void Profiler::EndFrame()
+{
+    ProfileFrame frame;
+    frame.start = frameStart;
+    frame.end = Now();
+    frameStart = frame.end;
+    Calibrate();
+
+    std::vector<ProfileThreadBuffer *> buffers;
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (auto &buffer : threads)
+        {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    // Drain every ring, even while paused, so the threads keep room to record
+    for (ProfileThreadBuffer *buffer : buffers)
+    {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        for (; tail < head; tail++)
+        {
+            const ProfileEvent &event = buffer->events[tail & (ProfileThreadBuffer::Capacity - 1)];
+            if (event.type == ProfileEventType::Zone)
+            {
+                frame.zones.push_back({event.name, ToNanoseconds(event.start), ToNanoseconds(event.end), event.depth, buffer->index});
+            }
+            else
+            {
+                frame.counters.push_back({event.name, ToNanoseconds(event.start), event.value, buffer->index});
+            }
+        }
+        buffer->tail.store(head, std::memory_order_release);
+
+        uint64_t dropped = buffer->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            LOG_WARN(LogCategory::Core, "Profiler dropped {} events on thread {}, it recorded more than fit in one frame", dropped, buffer->index);
+        }
+    }
+
+    if (paused)
+    {
+        return;
+    }
+    frames.push_back(std::move(frame));
+    while (frames.size() > historySize)
+    {
+        frames.pop_front();
+    }
+}
+
+void Profiler::SetPaused(bool pause)
+{
+    paused = pause;
+}
+
+bool Profiler::IsPaused()
+{
+    return paused;
+}
+
+const std::deque<ProfileFrame> &Profiler::GetFrames()
+{
+    return frames;
+}
+
+size_t Profiler::GetHistorySize()
+{
+    return historySize;
+}
+
+void Profiler::SetHistorySize(size_t size)
+{
+    historySize = std::max<size_t>(size, 1);
+    while (frames.size() > historySize)
+    {
+        frames.pop_front();
+    }
+}
+
+std::vector<std::string> Profiler::GetThreadNames()
+{
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    std::vector<std::string> names;
+    for (auto &buffer : threads)
+    {
+        names.push_back(buffer->name);
+    }
+    return names;
+}
+
+bool Profiler::WriteChromeTrace(const std::string &path)
+{
+    // Timestamps are microseconds from the first recorded frame
+    int64_t origin = frames.empty() ? 0 : frames.front().start;
+    auto microseconds = [origin](int64_t time)
+    {
+        return static_cast<double>(time - origin) / 1000.0;
+    };
+
+    nlohmann::json events = nlohmann::json::array();
+    std::vector<std::string> names = GetThreadNames();
+    for (size_t thread = 0; thread < names.size(); thread++)
+    {
+        events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", thread}, {"args", {{"name", names[thread]}}}});
+    }
+
+    for (size_t index = 0; index < frames.size(); index++)
+    {
+        const ProfileFrame &frame = frames[index];
+        events.push_back({{"name", "Frame"}, {"ph", "i"}, {"s", "g"}, {"pid", 1}, {"tid", 0}, {"ts", microseconds(frame.start)}});
+        for (const ProfileFrame::Zone &zone : frame.zones)
+        {
+            events.push_back({{"name", zone.name}, {"ph", "X"}, {"pid", 1}, {"tid", zone.thread},
+                              {"ts", microseconds(zone.start)}, {"dur", static_cast<double>(zone.end - zone.start) / 1000.0}});
+        }
+        for (const ProfileFrame::Counter &counter : frame.counters)
+        {
+            events.push_back({{"name", counter.name}, {"ph", "C"}, {"pid", 1}, {"ts", microseconds(counter.time)},
+                              {"args", {{"value", counter.value}}}});
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        LOG_ERROR(LogCategory::Core, "Failed to write profiler trace to {}", path);
+        return false;
+    }
+    nlohmann::json trace = {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    file << trace.dump() << std::endl;
+    LOG_INFO(LogCategory::Core, "Wrote {} frames of profiler trace to {}", frames.size(), path);
+    return true;
+}
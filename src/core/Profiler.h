@@ -0,0 +1,225 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define EGE_PROFILE_TSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// CPU frame profiler.
+//
+//   void Renderer::Render(...)
+//   {
+//       PROFILE_SCOPE("Renderer::Render");
+//       ...
+//       PROFILE_COUNTER("Draw calls", stats.drawCalls);
+//   }
+//
+// A zone costs two time stamp counter reads and one store into the calling thread's own ring,
+// which only that thread writes and only the main thread reads, so recording takes no lock and
+// touches no cache line another thread writes. The counter is the bulk of it: about 15 ns per
+// zone on current hardware, twice that in some VMs, which trap the instruction. PROFILE_FRAME() on
+// the main thread moves everything recorded since the previous frame into a history of recent
+// frames, which the editor draws as a flame graph and WriteChromeTrace exports for
+// chrome://tracing or Perfetto. Zone and counter names must be literals: only the pointer is kept.
+//
+// Zones are compiled out unless EGE_PROFILE is 1, which is the default outside NDEBUG builds.
+
+#ifndef EGE_PROFILE
+#ifdef NDEBUG
+#define EGE_PROFILE 0
+#else
+#define EGE_PROFILE 1
+#endif
+#endif
+
+enum class ProfileEventType : uint8_t
+{
+    Zone,
+    Counter
+};
+
+struct ProfileEvent
+{
+    const char *name;
+    int64_t start; // Profiler::Ticks()
+    int64_t end;   // Zones only
+    double value;  // Counters only
+    uint16_t depth;
+    ProfileEventType type;
+};
+
+// Events of one thread: a single-producer, single-consumer ring
+struct ProfileThreadBuffer
+{
+    static const uint32_t Capacity = 1 << 14; // Power of two
+
+    ProfileEvent events[Capacity];
+    alignas(64) std::atomic<uint64_t> head{0}; // Written by the owning thread
+    uint64_t cachedTail = 0;                   // Owning thread's last look at tail; only reloaded once the ring seems full
+    uint16_t depth = 0;                        // Zones currently open on the thread
+    uint16_t index = 0;                        // Position in the profiler's thread list
+    alignas(64) std::atomic<uint64_t> tail{0}; // Written by the main thread
+    std::atomic<uint64_t> dropped{0};          // Events lost because the ring was full
+    std::string name;
+};
+
+// Recorded events of one frame, in the order they were collected. Times are nanoseconds on the
+// steady clock.
+struct ProfileFrame
+{
+    int64_t start;
+    int64_t end;
+    struct Zone
+    {
+        const char *name;
+        int64_t start;
+        int64_t end;
+        uint16_t depth;
+        uint16_t thread;
+    };
+    struct Counter
+    {
+        const char *name;
+        int64_t time;
+        double value;
+        uint16_t thread;
+    };
+    std::vector<Zone> zones;
+    std::vector<Counter> counters;
+};
+
+namespace Profiler
+{
+    // Nanoseconds on the steady clock
+    inline int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Event timestamp: the CPU's time stamp counter where there is one, which reads several times
+    // faster than the OS clock. EndFrame converts ticks to nanoseconds.
+    inline int64_t Ticks()
+    {
+#ifdef EGE_PROFILE_TSC
+        return static_cast<int64_t>(__rdtsc());
+#else
+        return Now();
+#endif
+    }
+
+    // The calling thread's ring, created on first use
+    ProfileThreadBuffer &CreateThreadBuffer();
+    inline thread_local ProfileThreadBuffer *threadBuffer = nullptr;
+
+    inline ProfileThreadBuffer &GetThreadBuffer()
+    {
+        return threadBuffer ? *threadBuffer : CreateThreadBuffer();
+    }
+
+    inline void Record(ProfileThreadBuffer &buffer, const ProfileEvent &event)
+    {
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        if (head - buffer.cachedTail >= ProfileThreadBuffer::Capacity)
+        {
+            // Reading tail touches a cache line the main thread writes, so it is skipped while
+            // the ring has room by the last count
+            buffer.cachedTail = buffer.tail.load(std::memory_order_acquire);
+            if (head - buffer.cachedTail >= ProfileThreadBuffer::Capacity)
+            {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        buffer.events[head & (ProfileThreadBuffer::Capacity - 1)] = event;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    inline void RecordCounter(const char *name, double value)
+    {
+        Record(GetThreadBuffer(), {name, Ticks(), 0, value, 0, ProfileEventType::Counter});
+    }
+
+    // Shown in the flame graph and the trace instead of "Thread N"
+    void SetThreadName(const std::string &name);
+
+    // Closes the current frame; main thread only, like everything below
+    void EndFrame();
+
+    // While paused the history is kept as it is, e.g. to inspect a spike
+    void SetPaused(bool paused);
+    bool IsPaused();
+
+    // Most recent frames, oldest first
+    const std::deque<ProfileFrame> &GetFrames();
+    size_t GetHistorySize();
+    void SetHistorySize(size_t frames);
+
+    // Names of the threads that recorded events, indexed by ProfileFrame::Zone::thread
+    std::vector<std::string> GetThreadNames();
+
+    // Writes the history in the Chrome trace event format; false if the file cannot be written
+    bool WriteChromeTrace(const std::string &path);
+}
+
+// Measures the enclosing scope
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char *name)
+        : name(name), buffer(Profiler::GetThreadBuffer()), depth(buffer.depth++), start(Profiler::Ticks())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        int64_t end = Profiler::Ticks();
+        buffer.depth--;
+        Profiler::Record(buffer, {name, start, end, 0.0, depth, ProfileEventType::Zone});
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    const char *name;
+    ProfileThreadBuffer &buffer;
+    uint16_t depth;
+    int64_t start;
+};
+
+#define EGE_PROFILE_CONCAT_INNER(a, b) a##b
+#define EGE_PROFILE_CONCAT(a, b) EGE_PROFILE_CONCAT_INNER(a, b)
+
+#if EGE_PROFILE
+#define PROFILE_SCOPE(name) ProfileScope EGE_PROFILE_CONCAT(egeProfileScope, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) Profiler::RecordCounter(name, static_cast<double>(value))
+#define PROFILE_FRAME() Profiler::EndFrame()
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name) \
+    do                      \
+    {                       \
+    } while (0)
+#define PROFILE_COUNTER(name, value) \
+    do                               \
+    {                                \
+    } while (0)
+#define PROFILE_FRAME() \
+    do                  \
+    {                   \
+    } while (0)
+#define PROFILE_THREAD(name) \
+    do                       \
+    {                        \
+    } while (0)
+#endif
@@ -0,0 +1,96 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+namespace
+{
+    const uint64_t DepthBits = 20;
+    const uint64_t VertexArrayBits = 14;
+    const uint64_t MaterialBits = 16;
+    const uint64_t ProgramBits = 12;
+
+    uint64_t Mask(uint64_t value, uint64_t bits)
+    {
+        return value & ((1ull << bits) - 1);
+    }
+
+    uint64_t QuantizeDepth(float normalizedDepth)
+    {
+        float clamped = std::min(std::max(normalizedDepth, 0.0f), 1.0f);
+        return static_cast<uint64_t>(clamped * static_cast<float>((1ull << DepthBits) - 1));
+    }
+}
+
+uint64_t RenderQueue::MakeSortKey(RenderPass pass, uint32_t program, uint32_t material, uint32_t vertexArray, float normalizedDepth)
+{
+    uint64_t state = (Mask(program, ProgramBits) << (MaterialBits + VertexArrayBits)) |
+                     (Mask(material, MaterialBits) << VertexArrayBits) |
+                     Mask(vertexArray, VertexArrayBits);
+    uint64_t key = static_cast<uint64_t>(pass) << 62;
+
+    if (pass == RenderPass::Transparent)
+    {
+        // Blending needs back-to-front order, so depth outranks state here
+        uint64_t depth = ((1ull << DepthBits) - 1) - QuantizeDepth(normalizedDepth);
+        return key | (depth << (ProgramBits + MaterialBits + VertexArrayBits)) | state;
+    }
+
+    return key | (state << DepthBits) | QuantizeDepth(normalizedDepth);
+}
+
+void RenderQueue::Clear()
+{
+    entries.clear();
+    commands.clear();
+}
+
+void RenderQueue::Submit(uint64_t key, const RenderCommand &command)
+{
+    entries.push_back({key, static_cast<uint32_t>(commands.size())});
+    commands.push_back(command);
+}
+
+void RenderQueue::Sort()
+{
+    if (entries.size() < 2)
+    {
+        return;
+    }
+
+    scratch.resize(entries.size());
+
+    // Bytes that are identical in every key cannot change the order
+    uint64_t differing = 0;
+    for (const Entry &entry : entries)
+    {
+        differing |= entry.key ^ entries[0].key;
+    }
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        if (((differing >> shift) & 0xFF) == 0)
+        {
+            continue;
+        }
+
+        size_t counts[256] = {};
+        for (const Entry &entry : entries)
+        {
+            counts[(entry.key >> shift) & 0xFF]++;
+        }
+
+        size_t offset = 0;
+        for (size_t &count : counts)
+        {
+            size_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+
+        // Stable scatter keeps the order established by the lower bytes
+        for (const Entry &entry : entries)
+        {
+            scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Mesh;
+class ShaderProgram;
+
+enum class RenderPass : uint8_t
+{
+    Opaque = 0,
+    Transparent = 1,
+    Overlay = 2
+};
+
+// Everything needed to issue one draw once the queue has been sorted
+struct RenderCommand
+{
+    const ShaderProgram *shader;
+    Mesh *mesh;
+    glm::mat4 model;
+};
+
+// Collects the draws of a frame under 64-bit sort keys and orders them so that
+// consecutive draws share as much GL state as possible.
+//
+// Key layout, most significant bits first:
+//   Opaque/Overlay: pass(2) | program(12) | material(16) | vertex array(14) | depth(20, front to back)
+//   Transparent:    pass(2) | depth(20, back to front) | program(12) | material(16) | vertex array(14)
+class RenderQueue
+{
+public:
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t command;
+    };
+
+    static uint64_t MakeSortKey(RenderPass pass, uint32_t program, uint32_t material, uint32_t vertexArray, float normalizedDepth);
+
+    void Clear();
+    void Submit(uint64_t key, const RenderCommand &command);
+
+    // LSD radix sort over the keys; byte positions shared by every key are skipped
+    void Sort();
+
+    const std::vector<Entry> &GetEntries() const { return entries; }
+    const RenderCommand &GetCommand(const Entry &entry) const { return commands[entry.command]; }
+    size_t Size() const { return entries.size(); }
+
+private:
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch;
+    std::vector<RenderCommand> commands;
+};
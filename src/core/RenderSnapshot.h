@@ -0,0 +1,31 @@
+#pragma once
+#include <glm.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Mesh;
+
+// One mesh entity as the renderer sees it
+struct RenderInstance
+{
+    std::shared_ptr<Mesh> mesh; // Shared, so the mesh outlives its entity while a frame still draws it
+    glm::mat4 model;
+    glm::mat4 previousModel; // Placement one simulation step earlier; equal to model when static
+};
+
+// Immutable copy of everything the renderer needs from the registry, taken at the end of a
+// simulation step. The renderer draws from a snapshot while the next step already writes the
+// registry, so it never touches ECS state itself. The camera is not part of it: the main thread
+// samples it when drawing, which keeps camera motion free of simulation latency.
+struct RenderSnapshot
+{
+    std::vector<RenderInstance> instances;
+    float interpolation = 1.0f;          // Blend factor from previousModel to model
+    uint64_t sceneRevision = 0;          // Scene::GetRevision() at capture, for views that cache images
+    uint64_t frame = 0;                  // Number of snapshots taken before this one
+    std::chrono::steady_clock::time_point capturedAt; // When the simulated state was complete
+
+    void Clear() { instances.clear(); }
+};
@@ -1,18 +1,46 @@
 #include "Renderer.h"
-#include <iostream>
+#include "EngineShaders.h"
+#include "../ecs/TransformHierarchy.h"
+#include "Log.h"
+#include "Profiler.h"
 #include <GL/glew.h>
 #include <entt.hpp>
 
-Renderer::Renderer() {}
+namespace
+{
+    // Far clip distance encoded in a perspective projection matrix
+    float GetFarPlane(const glm::mat4 &projectionMatrix)
+    {
+        float denominator = projectionMatrix[2][2] + 1.0f;
+        if (projectionMatrix[2][3] == 0.0f || denominator == 0.0f)
+        {
+            return 100.0f;
+        }
+        return projectionMatrix[3][2] / denominator;
+    }
+}
+
+Renderer::Renderer() : frameConstantsBuffer(0), lastFrameTime(0.0f) {}
 
-Renderer::~Renderer() {}
+Renderer::~Renderer()
+{
+    // Release programs while the GL context is still alive
+    meshShader.reset();
+    shaderRegistry.Clear();
+    if (frameConstantsBuffer != 0)
+    {
+        glDeleteBuffers(1, &frameConstantsBuffer);
+    }
+}
 
 bool Renderer::Initialize(Window *window)
 {
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK)
+    GLenum glewStatus = glewInit();
+    // EGL and OSMesa contexts have no GLX display; the core entry points still load
+    if (glewStatus != GLEW_OK && glewStatus != GLEW_ERROR_NO_GLX_DISPLAY)
     {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
+        LOG_ERROR(LogCategory::Render, "Failed to initialize GLEW: {}", reinterpret_cast<const char *>(glewGetErrorString(glewStatus)));
         return false;
     }
 
@@ -25,13 +53,26 @@ bool Renderer::Initialize(Window *window)
 
     glEnable(GL_DEPTH_TEST);
 
+    // One uniform buffer holds the per-frame constants for every engine shader
+    glGenBuffers(1, &frameConstantsBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameConstantsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FrameConstantsBinding, frameConstantsBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Keep linked program binaries around so warm starts skip GLSL compilation
+    shaderRegistry.SetBinaryCacheDirectory("cache/shaders");
+
+    // Compile the mesh program once; every draw shares this handle
+    meshShader = shaderRegistry.Acquire(MeshVertexShaderSource, MeshFragmentShaderSource);
+
     return true;
 }
 
-void Renderer::Render(Scene *scene, glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+void Renderer::Render(const RenderSnapshot &snapshot, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix)
 {
-    // Debug: Check if the renderer is rendering the scene
-    std::cout << "Renderer: Rendering Scene" << std::endl;
+    PROFILE_SCOPE("Renderer::Render");
+    LOG_TRACE(LogCategory::Render, "Rendering scene");
 
     // Ensure the depth test is enabled
     glEnable(GL_DEPTH_TEST);
@@ -39,13 +80,116 @@ void Renderer::Render(Scene *scene, glm::mat4 viewMatrix, glm::mat4 projectionMa
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Render the scene
-    scene->Draw(viewMatrix, projectionMatrix);
+    // Upload view/projection once; every draw reads them from the uniform buffer
+    UpdateFrameConstants(viewMatrix, projectionMatrix);
+
+    // Collect the frame's draws and order them to minimise state changes
+    renderQueue.Clear();
+    Submit(snapshot, viewMatrix, projectionMatrix, GetFarPlane(projectionMatrix));
+    renderQueue.Sort();
+
+    // GUI code runs between frames, so nothing cached from last frame can be trusted
+    stateCache.Reset();
+    const std::vector<RenderQueue::Entry> &entries = renderQueue.GetEntries();
+    for (size_t first = 0; first < entries.size();)
+    {
+        const RenderCommand &command = renderQueue.GetCommand(entries[first]);
+
+        // Sorting put every instance of the same mesh and program next to each other
+        instanceMatrices.clear();
+        size_t last = first;
+        while (last < entries.size())
+        {
+            const RenderCommand &next = renderQueue.GetCommand(entries[last]);
+            if (next.mesh != command.mesh || next.shader != command.shader)
+            {
+                break;
+            }
+            instanceMatrices.push_back(next.model);
+            last++;
+        }
+
+        stateCache.UseProgram(command.shader->GetID());
+        command.mesh->DrawInstanced(stateCache, instanceMatrices.data(), instanceMatrices.size());
+        first = last;
+    }
+
+    stats = stateCache.GetStats();
+    stats.submitted = static_cast<uint32_t>(renderQueue.Size());
+    stats.culled = frustumCuller.GetStats().culled;
+    PROFILE_COUNTER("Draw calls", stats.drawCalls);
+    PROFILE_COUNTER("Culled", stats.culled);
+
+    // Leave the bindings in the state the rest of the frame expects
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
 
     // Check for any OpenGL errors
     GLenum error = glGetError();
     if (error != GL_NO_ERROR)
     {
-        std::cerr << "OpenGL Error: " << error << std::endl;
+        LOG_ERROR(LogCategory::Render, "OpenGL error {}", error);
+    }
+}
+
+void Renderer::Submit(const RenderSnapshot &snapshot, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, float farPlane)
+{
+    PROFILE_SCOPE("Renderer::Submit");
+    const ShaderProgram &shader = *meshShader;
+
+    // Gather world-space bounds for everything that could be drawn
+    frustumCuller.Clear();
+    candidates.clear();
+    for (const RenderInstance &instance : snapshot.instances)
+    {
+        // Between simulation steps, moving entities are drawn part way from their previous placement
+        glm::mat4 model = snapshot.interpolation < 1.0f && instance.previousModel != instance.model
+                              ? InterpolateWorldMatrix(instance.previousModel, instance.model, snapshot.interpolation)
+                              : instance.model;
+        const MeshBounds &bounds = instance.mesh->GetBounds();
+        frustumCuller.Add(bounds.box.Transformed(model), bounds.sphere.Transformed(model));
+        candidates.push_back({&shader, instance.mesh.get(), model});
     }
+
+    frustumCuller.Cull(Frustum::FromMatrix(projectionMatrix * viewMatrix));
+
+    // Only what survived culling goes into the queue
+    for (uint32_t i = 0; i < candidates.size(); i++)
+    {
+        if (!frustumCuller.IsVisible(i))
+        {
+            continue;
+        }
+
+        const RenderCommand &command = candidates[i];
+
+        // Distance along the view direction, used to draw opaque geometry front to back
+        float viewDepth = -(viewMatrix * command.model[3]).z;
+
+        // Entities sharing a mesh get identical state bits and end up adjacent, ready to instance
+        uint64_t key = RenderQueue::MakeSortKey(RenderPass::Opaque, shader.GetID(), command.mesh->GetMaterialKey(),
+                                                command.mesh->GetVertexArray(), viewDepth / farPlane);
+        renderQueue.Submit(key, command);
+    }
+}
+
+void Renderer::UpdateFrameConstants(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix)
+{
+    float currentTime = static_cast<float>(glfwGetTime());
+
+    FrameConstants constants;
+    constants.view = viewMatrix;
+    constants.projection = projectionMatrix;
+    constants.viewProjection = projectionMatrix * viewMatrix;
+    constants.cameraPosition = glm::vec4(glm::vec3(glm::inverse(viewMatrix)[3]), 1.0f);
+    constants.time = currentTime;
+    constants.deltaTime = currentTime - lastFrameTime;
+    constants.padding[0] = constants.padding[1] = 0.0f;
+    lastFrameTime = currentTime;
+
+    // Orphan the previous contents so the driver never stalls on in-flight draws
+    glBindBuffer(GL_UNIFORM_BUFFER, frameConstantsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &constants);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
@@ -1,6 +1,12 @@
 #pragma once
 #include "Window.h"
 #include "../scene/Scene.h"
+#include "RenderSnapshot.h"
+#include "ShaderRegistry.h"
+#include "FrameConstants.h"
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+#include "FrustumCuller.h"
 #include <entt.hpp>
 
 class Renderer
@@ -10,8 +16,30 @@ public:
     ~Renderer();
 
     bool Initialize(Window *window);
-    void Render(Scene *scene, glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
+    // Draws a snapshot of the scene; never reads the registry, so a simulation step may run meanwhile
+    void Render(const RenderSnapshot &snapshot, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix);
+
+    ShaderRegistry &GetShaderRegistry() { return shaderRegistry; }
+
+    // Counters from the most recent Render call
+    const RenderStats &GetStats() const { return stats; }
 
 private:
     int width, height;
+    void UpdateFrameConstants(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix);
+
+    // Culls the snapshot's instances against the view frustum and queues a sort-keyed draw for
+    // each visible one; depth is normalised by farPlane
+    void Submit(const RenderSnapshot &snapshot, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, float farPlane);
+
+    ShaderRegistry shaderRegistry;
+    ShaderHandle meshShader;
+    GLuint frameConstantsBuffer;
+    float lastFrameTime;
+    RenderQueue renderQueue;
+    FrustumCuller frustumCuller;
+    GLStateCache stateCache;
+    RenderStats stats;
+    std::vector<glm::mat4> instanceMatrices;
+    std::vector<RenderCommand> candidates; // Reused between frames by Submit
 };
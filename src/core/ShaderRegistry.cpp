@@ -0,0 +1,444 @@
+#include "ShaderRegistry.h"
+#include "FrameConstants.h"
+#include "Hash.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "Log.h"
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+    const uint32_t ProgramBinaryMagic = 0x42534745; // "EGSB"
+
+    struct ProgramBinaryHeader
+    {
+        uint32_t magic;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    uint64_t HashString(uint64_t hash, const char *text)
+    {
+        // Include the terminator so ("ab", "c") and ("a", "bc") hash differently
+        return HashBytes(text ? text : "", text ? std::strlen(text) + 1 : 1, hash);
+    }
+
+    // Inserts "#define X" lines right after the #version directive
+    std::string InjectDefines(const char *source, const std::vector<std::string> &defines)
+    {
+        std::string result(source);
+        if (defines.empty())
+        {
+            return result;
+        }
+
+        std::string block;
+        for (const std::string &define : defines)
+        {
+            block += "#define " + define + "\n";
+        }
+
+        size_t version = result.find("#version");
+        size_t insertAt = 0;
+        if (version != std::string::npos)
+        {
+            size_t lineEnd = result.find('\n', version);
+            insertAt = (lineEnd == std::string::npos) ? result.size() : lineEnd + 1;
+            if (lineEnd == std::string::npos)
+            {
+                block = "\n" + block;
+            }
+        }
+        result.insert(insertAt, block);
+        return result;
+    }
+
+    GLuint CompileShader(const char *source, GLenum shaderType)
+    {
+        GLuint shader = glCreateShader(shaderType);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        // Check for compilation errors
+        GLint success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            char infoLog[512];
+            glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+            LOG_ERROR(LogCategory::Render, "Shader compilation failed:\n{}", infoLog);
+        }
+
+        return shader;
+    }
+
+    bool IsSamplerType(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+        case GL_SAMPLER_BUFFER:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Unit requested by the "textureN" naming convention, -1 for any other name
+    GLint ConventionalTextureUnit(const std::string &name)
+    {
+        const std::string prefix = "texture";
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0)
+        {
+            return -1;
+        }
+        for (size_t i = prefix.size(); i < name.size(); i++)
+        {
+            if (name[i] < '0' || name[i] > '9')
+            {
+                return -1;
+            }
+        }
+        int index = std::atoi(name.c_str() + prefix.size());
+        return index >= 1 ? index - 1 : -1;
+    }
+}
+
+ShaderProgram::ShaderProgram(GLuint id, uint64_t hash) : id(id), hash(hash)
+{
+    std::fill(std::begin(engineUniforms), std::end(engineUniforms), -1);
+    if (id != 0)
+    {
+        Reflect();
+    }
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    if (id != 0)
+    {
+        glDeleteProgram(id);
+    }
+}
+
+GLint ShaderProgram::FindUniformLocation(const std::string &name) const
+{
+    auto it = uniformLocations.find(name);
+    return it != uniformLocations.end() ? it->second : -1;
+}
+
+void ShaderProgram::Reflect()
+{
+    GLint uniformCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+    for (GLint i = 0; i < uniformCount; i++)
+    {
+        GLsizei length = 0;
+        ShaderUniformInfo info;
+        glGetActiveUniform(id, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length, &info.size, &info.type, nameBuffer.data());
+        info.name.assign(nameBuffer.data(), length);
+
+        // Arrays are reported as "name[0]"; expose them under their plain name too
+        std::string baseName = info.name;
+        size_t bracket = baseName.find('[');
+        if (bracket != std::string::npos)
+        {
+            baseName.resize(bracket);
+        }
+
+        // Uniforms inside blocks have no location and are set through buffers instead
+        info.location = glGetUniformLocation(id, info.name.c_str());
+        if (info.location < 0)
+        {
+            continue;
+        }
+
+        uniformLocations[info.name] = info.location;
+        uniformLocations[baseName] = info.location;
+        uniforms.push_back(info);
+
+        if (IsSamplerType(info.type))
+        {
+            samplers.push_back({baseName, info.location, ConventionalTextureUnit(baseName)});
+        }
+    }
+
+    engineUniforms[static_cast<size_t>(ShaderUniform::Model)] = FindUniformLocation("model");
+
+    // Programs that declare the shared frame block read it from the engine's binding point
+    GLuint frameBlock = glGetUniformBlockIndex(id, "FrameConstants");
+    if (frameBlock != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(id, frameBlock, FrameConstantsBinding);
+    }
+
+    // Give samplers outside the "textureN" convention the first units nobody asked for
+    std::vector<bool> taken;
+    for (const ShaderSamplerInfo &sampler : samplers)
+    {
+        if (sampler.unit >= 0)
+        {
+            taken.resize(std::max<size_t>(taken.size(), sampler.unit + 1), false);
+            taken[sampler.unit] = true;
+        }
+    }
+    GLint nextUnit = 0;
+    for (ShaderSamplerInfo &sampler : samplers)
+    {
+        if (sampler.unit < 0)
+        {
+            while (nextUnit < static_cast<GLint>(taken.size()) && taken[nextUnit])
+            {
+                nextUnit++;
+            }
+            sampler.unit = nextUnit++;
+        }
+    }
+    std::sort(samplers.begin(), samplers.end(), [](const ShaderSamplerInfo &a, const ShaderSamplerInfo &b)
+              { return a.unit < b.unit; });
+
+    // Sampler units are program state, so they only need to be set once
+    if (!samplers.empty())
+    {
+        GLint previousProgram = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+        glUseProgram(id);
+        for (const ShaderSamplerInfo &sampler : samplers)
+        {
+            glUniform1i(sampler.location, sampler.unit);
+        }
+        glUseProgram(static_cast<GLuint>(previousProgram));
+    }
+}
+
+ShaderRegistry::ShaderRegistry() : driverHash(0) {}
+
+ShaderRegistry::~ShaderRegistry()
+{
+    Clear();
+}
+
+void ShaderRegistry::SetBinaryCacheDirectory(const std::string &directory)
+{
+    binaryCacheDirectory = directory;
+    if (directory.empty())
+    {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        LOG_ERROR(LogCategory::Render, "ShaderRegistry: cannot create binary cache directory {}: {}", directory, error.message());
+        binaryCacheDirectory.clear();
+        return;
+    }
+
+    // Key cached binaries on the driver so an upgrade or GPU swap never feeds stale blobs back
+    driverHash = HashSeed;
+    driverHash = HashString(driverHash, reinterpret_cast<const char *>(glGetString(GL_VENDOR)));
+    driverHash = HashString(driverHash, reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+    driverHash = HashString(driverHash, reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+}
+
+ShaderHandle ShaderRegistry::Acquire(const char *vertexSource, const char *fragmentSource,
+                                     const std::vector<std::string> &defines)
+{
+    uint64_t hash = HashProgram(vertexSource, fragmentSource, defines);
+
+    auto it = programs.find(hash);
+    if (it != programs.end())
+    {
+        return it->second;
+    }
+
+    bool useCache = BinaryCacheAvailable();
+    GLuint program = useCache ? LoadProgramBinary(hash) : 0;
+    if (program == 0)
+    {
+        program = BuildProgram(vertexSource, fragmentSource, defines, useCache);
+        if (program != 0 && useCache)
+        {
+            SaveProgramBinary(hash, program);
+        }
+    }
+
+    // A failed build is not kept, so the next Acquire compiles again instead of handing out the
+    // empty program for the rest of the run
+    ShaderHandle handle = std::make_shared<ShaderProgram>(program, hash);
+    if (program != 0)
+    {
+        programs.emplace(hash, handle);
+    }
+    return handle;
+}
+
+void ShaderRegistry::Clear()
+{
+    programs.clear();
+}
+
+uint64_t ShaderRegistry::HashProgram(const char *vertexSource, const char *fragmentSource,
+                                     const std::vector<std::string> &defines) const
+{
+    uint64_t hash = HashSeed;
+    hash = HashString(hash, vertexSource);
+    hash = HashString(hash, fragmentSource);
+    for (const std::string &define : defines)
+    {
+        hash = HashString(hash, define.c_str());
+    }
+    return hash;
+}
+
+GLuint ShaderRegistry::BuildProgram(const char *vertexSource, const char *fragmentSource,
+                                    const std::vector<std::string> &defines, bool retrievable) const
+{
+    std::string vertexCode = InjectDefines(vertexSource, defines);
+    std::string fragmentCode = InjectDefines(fragmentSource, defines);
+
+    // Compile vertex shader
+    GLuint vertexShader = CompileShader(vertexCode.c_str(), GL_VERTEX_SHADER);
+
+    // Compile fragment shader
+    GLuint fragmentShader = CompileShader(fragmentCode.c_str(), GL_FRAGMENT_SHADER);
+
+    // Link shaders into a shader program
+    GLuint shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    if (retrievable)
+    {
+        glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(shaderProgram);
+
+    // Clean up shaders as they are now linked into the program
+    glDetachShader(shaderProgram, vertexShader);
+    glDetachShader(shaderProgram, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    // Check for linking errors
+    GLint success;
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
+        LOG_ERROR(LogCategory::Render, "Shader program linking failed:\n{}", infoLog);
+        glDeleteProgram(shaderProgram);
+        return 0;
+    }
+
+    return shaderProgram;
+}
+
+bool ShaderRegistry::BinaryCacheAvailable() const
+{
+    if (binaryCacheDirectory.empty())
+    {
+        return false;
+    }
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+    {
+        return false;
+    }
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+GLuint ShaderRegistry::LoadProgramBinary(uint64_t hash) const
+{
+    std::ifstream file(GetBinaryPath(hash), std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return 0;
+    }
+    std::streamoff fileSize = file.tellg();
+    file.seekg(0);
+
+    ProgramBinaryHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != ProgramBinaryMagic)
+    {
+        return 0;
+    }
+
+    // A truncated or corrupt file must not make us allocate whatever length it claims
+    if (header.length == 0 || header.length > static_cast<uint64_t>(fileSize) - sizeof(header))
+    {
+        LOG_WARN(LogCategory::Render, "ShaderRegistry: ignoring corrupt program binary {}", GetBinaryPath(hash));
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+    {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // The driver may reject binaries it no longer understands; fall back to compiling
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+void ShaderRegistry::SaveProgramBinary(uint64_t hash, GLuint program) const
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    std::ofstream file(GetBinaryPath(hash), std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        LOG_ERROR(LogCategory::Render, "ShaderRegistry: cannot write program binary to {}", GetBinaryPath(hash));
+        return;
+    }
+
+    ProgramBinaryHeader header = {ProgramBinaryMagic, format, static_cast<uint32_t>(length)};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), binary.size());
+}
+
+std::string ShaderRegistry::GetBinaryPath(uint64_t hash) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << (hash ^ driverHash) << ".glbin";
+    return (std::filesystem::path(binaryCacheDirectory) / name.str()).string();
+}
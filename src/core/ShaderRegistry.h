@@ -0,0 +1,110 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Uniforms the engine sets on every draw, resolved once when the program is linked
+enum class ShaderUniform
+{
+    Model,
+    Count
+};
+
+// One active uniform as reported by glGetActiveUniform
+struct ShaderUniformInfo
+{
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
+// A sampler uniform and the texture unit it was bound to at link time
+struct ShaderSamplerInfo
+{
+    std::string name;
+    GLint location;
+    GLint unit;
+};
+
+// A linked GLSL program owned by the ShaderRegistry.
+// The GL program object is deleted when the last handle goes away.
+// Its active uniforms are reflected once on creation so draw code never queries the driver.
+class ShaderProgram
+{
+public:
+    ShaderProgram(GLuint id, uint64_t hash);
+    ~ShaderProgram();
+
+    ShaderProgram(const ShaderProgram &) = delete;
+    ShaderProgram &operator=(const ShaderProgram &) = delete;
+
+    GLuint GetID() const { return id; }
+    uint64_t GetHash() const { return hash; }
+
+    // Pre-resolved location of an engine uniform, -1 if the program does not use it
+    GLint GetUniformLocation(ShaderUniform uniform) const { return engineUniforms[static_cast<size_t>(uniform)]; }
+
+    // Location of any active uniform by name, -1 if absent (not meant for per-draw use)
+    GLint FindUniformLocation(const std::string &name) const;
+
+    const std::vector<ShaderUniformInfo> &GetUniforms() const { return uniforms; }
+
+    // Samplers ordered by texture unit. "textureN" samplers are bound to unit N-1,
+    // matching the order of Mesh::textures; other samplers take the next free unit.
+    const std::vector<ShaderSamplerInfo> &GetSamplers() const { return samplers; }
+
+private:
+    void Reflect();
+
+    GLuint id;
+    uint64_t hash;
+    GLint engineUniforms[static_cast<size_t>(ShaderUniform::Count)];
+    std::vector<ShaderUniformInfo> uniforms;
+    std::vector<ShaderSamplerInfo> samplers;
+    std::unordered_map<std::string, GLint> uniformLocations;
+};
+
+using ShaderHandle = std::shared_ptr<ShaderProgram>;
+
+// Compiles every (vertex, fragment, defines) permutation exactly once and hands out
+// shared handles keyed by a content hash of the sources.
+// When a cache directory is set, linked program binaries are written to disk and
+// reloaded on the next start so warm starts skip GLSL compilation entirely.
+class ShaderRegistry
+{
+public:
+    ShaderRegistry();
+    ~ShaderRegistry();
+
+    // Enables the on-disk program binary cache. An empty path disables it.
+    void SetBinaryCacheDirectory(const std::string &directory);
+
+    // Returns the program for this source/permutation, building it on first use.
+    // Defines are injected right after the #version line as "#define NAME".
+    // If the build fails the handle's program is 0 and it is not cached, so the next call retries.
+    ShaderHandle Acquire(const char *vertexSource, const char *fragmentSource,
+                         const std::vector<std::string> &defines = {});
+
+    // Drops the registry's references; programs still in use stay alive until released.
+    void Clear();
+
+    size_t GetProgramCount() const { return programs.size(); }
+
+private:
+    uint64_t HashProgram(const char *vertexSource, const char *fragmentSource,
+                         const std::vector<std::string> &defines) const;
+    GLuint BuildProgram(const char *vertexSource, const char *fragmentSource,
+                        const std::vector<std::string> &defines, bool retrievable) const;
+    bool BinaryCacheAvailable() const;
+    GLuint LoadProgramBinary(uint64_t hash) const;
+    void SaveProgramBinary(uint64_t hash, GLuint program) const;
+    std::string GetBinaryPath(uint64_t hash) const;
+
+    std::unordered_map<uint64_t, ShaderHandle> programs;
+    std::string binaryCacheDirectory;
+    uint64_t driverHash; // Binaries are only valid for the driver that produced them
+};
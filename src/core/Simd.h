@@ -0,0 +1,13 @@
+#pragma once
+
+// Instruction sets the compiler was allowed to target. Kernels check these macros and keep a
+// scalar path for everything else. AVX2 needs /arch:AVX2 (MSVC) or -mavx2 (GCC/Clang).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EGE_SIMD_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define EGE_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
@@ -0,0 +1,1243 @@
+#include "TextureCompression.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // A 4x4 block of RGBA texels in row-major order
+    struct Block
+    {
+        uint8_t texels[16][4];
+    };
+
+    void LoadBlock(const uint8_t *rgba, int width, int height, int blockX, int blockY, Block &block)
+    {
+        for (int y = 0; y < 4; y++)
+        {
+            int sourceY = std::min(blockY * 4 + y, height - 1);
+            for (int x = 0; x < 4; x++)
+            {
+                int sourceX = std::min(blockX * 4 + x, width - 1);
+                std::memcpy(block.texels[y * 4 + x], rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+            }
+        }
+    }
+
+    void StoreBlock(const Block &block, int width, int height, int blockX, int blockY, uint8_t *rgba)
+    {
+        for (int y = 0; y < 4 && blockY * 4 + y < height; y++)
+        {
+            for (int x = 0; x < 4 && blockX * 4 + x < width; x++)
+            {
+                std::memcpy(rgba + (static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x) * 4, block.texels[y * 4 + x], 4);
+            }
+        }
+    }
+
+    int Clamp(int value, int low, int high)
+    {
+        return std::min(std::max(value, low), high);
+    }
+
+    void WriteU16(uint8_t *out, uint16_t value)
+    {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void WriteU32(uint8_t *out, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            out[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    uint32_t ReadU32(const uint8_t *in)
+    {
+        return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<uint32_t>(in[3]) << 24);
+    }
+
+#ifndef EGE_SIMD_SSE
+    uint32_t FitIndicesScalar(const Block &block, const int (*palette)[4], int paletteSize, bool useAlpha, uint8_t indices[16])
+    {
+        int channels = useAlpha ? 4 : 3;
+        uint32_t total = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            uint32_t best = std::numeric_limits<uint32_t>::max();
+            for (int p = 0; p < paletteSize; p++)
+            {
+                uint32_t distance = 0;
+                for (int c = 0; c < channels; c++)
+                {
+                    int difference = block.texels[i][c] - palette[p][c];
+                    distance += difference * difference;
+                }
+                if (distance < best)
+                {
+                    best = distance;
+                    indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+#else
+    // Four texels at a time: each is widened to 16-bit lanes and compared with every palette entry
+    uint32_t FitIndicesSSE(const Block &block, const int (*palette)[4], int paletteSize, bool useAlpha, uint8_t indices[16])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i channelMask = useAlpha ? _mm_set1_epi32(-1) : _mm_set1_epi32(0x00FFFFFF);
+
+        __m128i colors[16];
+        for (int p = 0; p < paletteSize; p++)
+        {
+            int alpha = useAlpha ? palette[p][3] : 0;
+            colors[p] = _mm_setr_epi16(static_cast<short>(palette[p][0]), static_cast<short>(palette[p][1]), static_cast<short>(palette[p][2]),
+                                       static_cast<short>(alpha), static_cast<short>(palette[p][0]), static_cast<short>(palette[p][1]),
+                                       static_cast<short>(palette[p][2]), static_cast<short>(alpha));
+        }
+
+        uint32_t total = 0;
+        for (int group = 0; group < 4; group++)
+        {
+            __m128i texels = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block.texels[group * 4])), channelMask);
+            __m128i low = _mm_unpacklo_epi8(texels, zero); // Texels 0 and 1
+            __m128i high = _mm_unpackhi_epi8(texels, zero); // Texels 2 and 3
+
+            __m128i best = _mm_set1_epi32(std::numeric_limits<int32_t>::max());
+            __m128i bestIndex = zero;
+            for (int p = 0; p < paletteSize; p++)
+            {
+                __m128i differenceLow = _mm_sub_epi16(low, colors[p]);
+                __m128i differenceHigh = _mm_sub_epi16(high, colors[p]);
+                // r*r + g*g and b*b + a*a for each texel, then the two halves added per texel
+                __m128i sumsLow = _mm_madd_epi16(differenceLow, differenceLow);
+                __m128i sumsHigh = _mm_madd_epi16(differenceHigh, differenceHigh);
+                __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(sumsLow), _mm_castsi128_ps(sumsHigh), _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(sumsLow), _mm_castsi128_ps(sumsHigh), _MM_SHUFFLE(3, 1, 3, 1));
+                __m128i distance = _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+
+                __m128i closer = _mm_cmplt_epi32(distance, best);
+                best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+            }
+
+            alignas(16) int32_t distances[4];
+            alignas(16) int32_t groupIndices[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(distances), best);
+            _mm_store_si128(reinterpret_cast<__m128i *>(groupIndices), bestIndex);
+            for (int i = 0; i < 4; i++)
+            {
+                indices[group * 4 + i] = static_cast<uint8_t>(groupIndices[i]);
+                total += static_cast<uint32_t>(distances[i]);
+            }
+        }
+        return total;
+    }
+#endif
+
+    // Squared distance of every texel to its nearest palette entry; writes the entry's index. The
+    // palette holds RGBA values; alpha is ignored unless useAlpha is set.
+    uint32_t FitIndices(const Block &block, const int (*palette)[4], int paletteSize, bool useAlpha, uint8_t indices[16])
+    {
+#ifdef EGE_SIMD_SSE
+        return FitIndicesSSE(block, palette, paletteSize, useAlpha, indices);
+#else
+        return FitIndicesScalar(block, palette, paletteSize, useAlpha, indices);
+#endif
+    }
+
+    // Mean of the block and the direction its texels spread along most, by power iteration on the
+    // covariance matrix; over RGB, or RGBA when channels is 4
+    void PrincipalAxis(const Block &block, int channels, float mean[4], float axis[4])
+    {
+        float low[4] = {255.0f, 255.0f, 255.0f, 255.0f};
+        float high[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int c = 0; c < 4; c++)
+        {
+            mean[c] = 0.0f;
+            axis[c] = 0.0f;
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                mean[c] += block.texels[i][c] / 16.0f;
+                low[c] = std::min(low[c], static_cast<float>(block.texels[i][c]));
+                high[c] = std::max(high[c], static_cast<float>(block.texels[i][c]));
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            float offset[4];
+            for (int c = 0; c < channels; c++)
+            {
+                offset[c] = block.texels[i][c] - mean[c];
+            }
+            for (int a = 0; a < channels; a++)
+            {
+                for (int b = 0; b < channels; b++)
+                {
+                    covariance[a][b] += offset[a] * offset[b];
+                }
+            }
+        }
+
+        // The bounding box diagonal is a good first guess and rarely orthogonal to the answer
+        float length = 0.0f;
+        for (int c = 0; c < channels; c++)
+        {
+            axis[c] = high[c] - low[c];
+            length += axis[c] * axis[c];
+        }
+        if (length == 0.0f)
+        {
+            return;
+        }
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            length = 0.0f;
+            for (int a = 0; a < channels; a++)
+            {
+                for (int b = 0; b < channels; b++)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length += next[a] * next[a];
+            }
+            if (length == 0.0f)
+            {
+                break;
+            }
+            float scale = 1.0f / std::sqrt(length);
+            for (int c = 0; c < channels; c++)
+            {
+                axis[c] = next[c] * scale;
+            }
+        }
+    }
+
+    // Endpoints at the extremes of the block's projection onto its principal axis
+    void AxisEndpoints(const Block &block, int channels, float first[4], float second[4])
+    {
+        float mean[4], axis[4];
+        PrincipalAxis(block, channels, mean, axis);
+        float minimum = 0.0f, maximum = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < channels; c++)
+            {
+                t += (block.texels[i][c] - mean[c]) * axis[c];
+            }
+            minimum = std::min(minimum, t);
+            maximum = std::max(maximum, t);
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            first[c] = mean[c] + axis[c] * maximum;
+            second[c] = mean[c] + axis[c] * minimum;
+        }
+    }
+
+    // Endpoints minimizing the squared error of the block for fixed indices, where texel i is
+    // weights[indices[i]] of the first endpoint plus the rest of the second; false if degenerate
+    bool LeastSquaresEndpoints(const Block &block, int channels, const uint8_t indices[16], const float *weights, float first[4], float second[4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            float a = weights[indices[i]];
+            float b = 1.0f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < channels; c++)
+            {
+                ax[c] += a * block.texels[i][c];
+                bx[c] += b * block.texels[i][c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        for (int c = 0; c < channels; c++)
+        {
+            first[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+            second[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+        }
+        return true;
+    }
+
+    // BC1 color endpoints are 5:6:5
+    uint16_t To565(const float color[4])
+    {
+        int r = Clamp(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+        int g = Clamp(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+        int b = Clamp(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void From565(uint16_t value, int color[4])
+    {
+        int r = (value >> 11) & 31;
+        int g = (value >> 5) & 63;
+        int b = value & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+        color[3] = 255;
+    }
+
+    // Four-color palette: both endpoints and the two colors a third of the way between them
+    void ColorPalette(uint16_t first, uint16_t second, int palette[4][4])
+    {
+        From565(first, palette[0]);
+        From565(second, palette[1]);
+        for (int c = 0; c < 4; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    // Weight of the first endpoint for each BC1 index
+    const float ColorWeights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+    void EncodeColorBlock(const Block &block, uint8_t *out)
+    {
+        float first[4], second[4];
+        AxisEndpoints(block, 3, first, second);
+
+        uint16_t bestFirst = 0, bestSecond = 0;
+        uint8_t bestIndices[16] = {};
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+        for (int iteration = 0; iteration < 3; iteration++)
+        {
+            uint16_t endpoints[2] = {To565(first), To565(second)};
+            int palette[4][4];
+            ColorPalette(endpoints[0], endpoints[1], palette);
+            uint8_t indices[16];
+            uint32_t error = FitIndices(block, palette, 4, false, indices);
+            if (error >= bestError)
+            {
+                break;
+            }
+            bestError = error;
+            bestFirst = endpoints[0];
+            bestSecond = endpoints[1];
+            std::memcpy(bestIndices, indices, sizeof(indices));
+            if (error == 0 || !LeastSquaresEndpoints(block, 3, indices, ColorWeights, first, second))
+            {
+                break;
+            }
+        }
+
+        // The first endpoint must be the larger one, or the decoder switches to three colors and black
+        uint32_t packed = 0;
+        if (bestFirst != bestSecond)
+        {
+            bool swap = bestFirst < bestSecond;
+            for (int i = 0; i < 16; i++)
+            {
+                packed |= static_cast<uint32_t>(swap ? bestIndices[i] ^ 1 : bestIndices[i]) << (2 * i);
+            }
+            if (swap)
+            {
+                std::swap(bestFirst, bestSecond);
+            }
+        }
+        WriteU16(out, bestFirst);
+        WriteU16(out + 2, bestSecond);
+        WriteU32(out + 4, packed);
+    }
+
+    void DecodeColorBlock(const uint8_t *in, Block &block)
+    {
+        uint16_t first = static_cast<uint16_t>(in[0] | (in[1] << 8));
+        uint16_t second = static_cast<uint16_t>(in[2] | (in[3] << 8));
+        int palette[4][4];
+        ColorPalette(first, second, palette);
+        if (first <= second)
+        {
+            // Three colors and transparent black; never written here, but valid BC1
+            for (int c = 0; c < 4; c++)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        uint32_t indices = ReadU32(in + 4);
+        for (int i = 0; i < 16; i++)
+        {
+            const int *color = palette[(indices >> (2 * i)) & 3];
+            for (int c = 0; c < 3; c++)
+            {
+                block.texels[i][c] = static_cast<uint8_t>(color[c]);
+            }
+            block.texels[i][3] = static_cast<uint8_t>(color[3]);
+        }
+    }
+
+    // Single-channel (BC4) palette. With the first endpoint larger it interpolates eight values,
+    // otherwise six plus 0 and 255.
+    void ChannelPalette(int first, int second, int palette[8])
+    {
+        palette[0] = first;
+        palette[1] = second;
+        if (first > second)
+        {
+            for (int i = 1; i < 7; i++)
+            {
+                palette[i + 1] = ((7 - i) * first + i * second) / 7;
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+            {
+                palette[i + 1] = ((5 - i) * first + i * second) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    uint32_t FitChannelIndices(const uint8_t values[16], const int *palette, int paletteSize, uint8_t indices[16])
+    {
+        uint32_t total = 0;
+#ifdef EGE_SIMD_SSE
+        // All sixteen values at once as unsigned bytes: |value - entry| without widening
+        __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+        __m128i best = _mm_set1_epi8(static_cast<char>(255));
+        __m128i bestIndex = _mm_setzero_si128();
+        for (int p = 0; p < paletteSize; p++)
+        {
+            __m128i entry = _mm_set1_epi8(static_cast<char>(palette[p]));
+            __m128i distance = _mm_or_si128(_mm_subs_epu8(texels, entry), _mm_subs_epu8(entry, texels));
+            __m128i smallest = _mm_min_epu8(distance, best);
+            __m128i closer = _mm_andnot_si128(_mm_cmpeq_epi8(distance, best), _mm_cmpeq_epi8(smallest, distance));
+            best = smallest;
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi8(static_cast<char>(p))), _mm_andnot_si128(closer, bestIndex));
+        }
+        alignas(16) uint8_t distances[16];
+        _mm_store_si128(reinterpret_cast<__m128i *>(distances), best);
+        _mm_store_si128(reinterpret_cast<__m128i *>(indices), bestIndex);
+        for (int i = 0; i < 16; i++)
+        {
+            total += distances[i] * distances[i];
+        }
+#else
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 256;
+            for (int p = 0; p < paletteSize; p++)
+            {
+                int distance = std::abs(values[i] - palette[p]);
+                if (distance < best)
+                {
+                    best = distance;
+                    indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+            total += best * best;
+        }
+#endif
+        return total;
+    }
+
+    void WriteChannelBlock(int first, int second, const uint8_t indices[16], uint8_t *out)
+    {
+        out[0] = static_cast<uint8_t>(first);
+        out[1] = static_cast<uint8_t>(second);
+        uint64_t packed = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            packed |= static_cast<uint64_t>(indices[i]) << (3 * i);
+        }
+        for (int i = 0; i < 6; i++)
+        {
+            out[2 + i] = static_cast<uint8_t>(packed >> (8 * i));
+        }
+    }
+
+    void EncodeChannelBlock(const Block &block, int channel, uint8_t *out)
+    {
+        uint8_t values[16];
+        int low = 255, high = 0;
+        int innerLow = 255, innerHigh = 0; // Ignoring 0 and 255, which the six-value mode has for free
+        for (int i = 0; i < 16; i++)
+        {
+            values[i] = block.texels[i][channel];
+            low = std::min<int>(low, values[i]);
+            high = std::max<int>(high, values[i]);
+            if (values[i] != 0 && values[i] != 255)
+            {
+                innerLow = std::min<int>(innerLow, values[i]);
+                innerHigh = std::max<int>(innerHigh, values[i]);
+            }
+        }
+
+        uint8_t indices[16] = {};
+        if (low == high)
+        {
+            WriteChannelBlock(high, low, indices, out);
+            return;
+        }
+
+        int palette[8];
+        ChannelPalette(high, low, palette);
+        uint32_t error = FitChannelIndices(values, palette, 8, indices);
+
+        // Blocks with hard 0/255 edges, like cutout alpha, often fit the six-value mode better
+        if (error > 0 && (low == 0 || high == 255) && innerLow <= innerHigh)
+        {
+            uint8_t sixIndices[16];
+            ChannelPalette(innerLow, innerHigh, palette);
+            if (FitChannelIndices(values, palette, 8, sixIndices) < error)
+            {
+                WriteChannelBlock(innerLow, innerHigh, sixIndices, out);
+                return;
+            }
+        }
+        WriteChannelBlock(high, low, indices, out);
+    }
+
+    void DecodeChannelBlock(const uint8_t *in, int channel, Block &block)
+    {
+        int palette[8];
+        ChannelPalette(in[0], in[1], palette);
+        uint64_t packed = 0;
+        for (int i = 0; i < 6; i++)
+        {
+            packed |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            block.texels[i][channel] = static_cast<uint8_t>(palette[(packed >> (3 * i)) & 7]);
+        }
+    }
+
+    // BC7 interpolation weights out of 64 for 4-bit and 2-bit indices. Both tables are symmetric, so
+    // swapping a pair of endpoints and mirroring the indices encodes the same colors.
+    const int BC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    const int BC7Weights2[4] = {0, 21, 43, 64};
+
+    int Interpolate(int first, int second, int weight)
+    {
+        return ((64 - weight) * first + weight * second + 32) >> 6;
+    }
+
+    // Bits are numbered from the least significant bit of the first byte
+    class BlockBits
+    {
+    public:
+        explicit BlockBits(uint8_t *bytes) : bytes(bytes), position(0) {}
+
+        void Write(uint32_t value, int count)
+        {
+            for (int i = 0; i < count; i++, position++)
+            {
+                bytes[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (position & 7));
+            }
+        }
+
+        uint32_t Read(int count)
+        {
+            uint32_t value = 0;
+            for (int i = 0; i < count; i++, position++)
+            {
+                value |= static_cast<uint32_t>((bytes[position >> 3] >> (position & 7)) & 1) << i;
+            }
+            return value;
+        }
+
+    private:
+        uint8_t *bytes;
+        int position;
+    };
+
+    // Writes the indices of one line; the first is stored without its top bit, which must be 0
+    void WriteIndices(BlockBits &bits, const uint8_t indices[16], int indexBits)
+    {
+        bits.Write(indices[0], indexBits - 1);
+        for (int i = 1; i < 16; i++)
+        {
+            bits.Write(indices[i], indexBits);
+        }
+    }
+
+    void ReadIndices(BlockBits &bits, uint8_t indices[16], int indexBits)
+    {
+        indices[0] = static_cast<uint8_t>(bits.Read(indexBits - 1));
+        for (int i = 1; i < 16; i++)
+        {
+            indices[i] = static_cast<uint8_t>(bits.Read(indexBits));
+        }
+    }
+
+    // Least squares expects the weight of the first endpoint
+    void FirstEndpointWeights(const int *weights, int count, float *result)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            result[i] = 1.0f - weights[i] / 64.0f;
+        }
+    }
+
+    // Mode 6: one RGBA line, 7-bit endpoints with a shared low bit each, 4-bit indices
+
+    // The 7-bit endpoint and low bit closest to a color
+    void QuantizeMode6Endpoint(const float color[4], int quantized[4], int &lowBit)
+    {
+        float bestError = std::numeric_limits<float>::max();
+        for (int bit = 0; bit < 2; bit++)
+        {
+            int candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; c++)
+            {
+                candidate[c] = Clamp(static_cast<int>(std::lround((color[c] - bit) / 2.0f)), 0, 127);
+                float difference = static_cast<float>(candidate[c] * 2 + bit) - color[c];
+                error += difference * difference;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                lowBit = bit;
+                std::memcpy(quantized, candidate, sizeof(candidate));
+            }
+        }
+    }
+
+    void Mode6Palette(const int endpoints[2][4], const int lowBits[2], int palette[16][4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                palette[i][c] = Interpolate(endpoints[0][c] * 2 + lowBits[0], endpoints[1][c] * 2 + lowBits[1], BC7Weights4[i]);
+            }
+        }
+    }
+
+    // The first index must be below 8
+    void WriteMode6(const int endpoints[2][4], const int lowBits[2], const uint8_t indices[16], uint8_t *out)
+    {
+        std::memset(out, 0, 16);
+        BlockBits bits(out);
+        bits.Write(1u << 6, 7);
+        for (int c = 0; c < 4; c++)
+        {
+            bits.Write(endpoints[0][c], 7);
+            bits.Write(endpoints[1][c], 7);
+        }
+        bits.Write(lowBits[0], 1);
+        bits.Write(lowBits[1], 1);
+        WriteIndices(bits, indices, 4);
+    }
+
+    uint32_t EncodeMode6(const Block &block, uint8_t *out)
+    {
+        float first[4], second[4];
+        AxisEndpoints(block, 4, first, second);
+        float weights[16];
+        FirstEndpointWeights(BC7Weights4, 16, weights);
+
+        int bestEndpoints[2][4] = {};
+        int bestBits[2] = {};
+        uint8_t bestIndices[16] = {};
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+        for (int iteration = 0; iteration < 3; iteration++)
+        {
+            int endpoints[2][4];
+            int lowBits[2];
+            QuantizeMode6Endpoint(first, endpoints[0], lowBits[0]);
+            QuantizeMode6Endpoint(second, endpoints[1], lowBits[1]);
+            int palette[16][4];
+            Mode6Palette(endpoints, lowBits, palette);
+            uint8_t indices[16];
+            uint32_t error = FitIndices(block, palette, 16, true, indices);
+            if (error >= bestError)
+            {
+                break;
+            }
+            bestError = error;
+            std::memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+            std::memcpy(bestBits, lowBits, sizeof(lowBits));
+            std::memcpy(bestIndices, indices, sizeof(indices));
+            if (error == 0 || !LeastSquaresEndpoints(block, 4, indices, weights, first, second))
+            {
+                break;
+            }
+        }
+
+        if (bestIndices[0] >= 8)
+        {
+            std::swap(bestEndpoints[0], bestEndpoints[1]);
+            std::swap(bestBits[0], bestBits[1]);
+            for (uint8_t &index : bestIndices)
+            {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+        WriteMode6(bestEndpoints, bestBits, bestIndices, out);
+        return bestError;
+    }
+
+    // A single color, exactly. Each channel either sits on both endpoints, or they are one above
+    // and one below it, which index 7 (weight 30) rounds back to it. False when a channel at the
+    // edge of the range has the other parity than both low bits allow.
+    bool EncodeMode6Solid(const uint8_t color[4], uint8_t *out)
+    {
+        for (int bit = 0; bit < 2; bit++)
+        {
+            int endpoints[2][4];
+            bool exact = true;
+            for (int c = 0; c < 4 && exact; c++)
+            {
+                int offset = (color[c] & 1) == bit ? 0 : 1;
+                exact = color[c] - offset >= 0 && color[c] + offset <= 255;
+                endpoints[0][c] = (color[c] + offset) >> 1;
+                endpoints[1][c] = (color[c] - offset) >> 1;
+            }
+            if (exact)
+            {
+                int lowBits[2] = {bit, bit};
+                uint8_t indices[16];
+                std::memset(indices, 7, sizeof(indices));
+                WriteMode6(endpoints, lowBits, indices, out);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void DecodeMode6(BlockBits &bits, Block &block)
+    {
+        int endpoints[2][4];
+        for (int c = 0; c < 4; c++)
+        {
+            endpoints[0][c] = static_cast<int>(bits.Read(7));
+            endpoints[1][c] = static_cast<int>(bits.Read(7));
+        }
+        int lowBits[2];
+        lowBits[0] = static_cast<int>(bits.Read(1));
+        lowBits[1] = static_cast<int>(bits.Read(1));
+        int palette[16][4];
+        Mode6Palette(endpoints, lowBits, palette);
+        uint8_t indices[16];
+        ReadIndices(bits, indices, 4);
+        for (int i = 0; i < 16; i++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                block.texels[i][c] = static_cast<uint8_t>(palette[indices[i]][c]);
+            }
+        }
+    }
+
+    // Mode 5: an RGB line with 7-bit endpoints and an alpha line with 8-bit endpoints, 2-bit
+    // indices each. Keeps color intact in blocks where alpha changes independently, e.g. cutouts.
+
+    int Expand7(int value)
+    {
+        return (value << 1) | (value >> 6);
+    }
+
+    void Mode5ColorPalette(const int endpoints[2][3], int palette[4][4])
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                palette[i][c] = Interpolate(Expand7(endpoints[0][c]), Expand7(endpoints[1][c]), BC7Weights2[i]);
+            }
+            palette[i][3] = 255;
+        }
+    }
+
+    void Mode5AlphaPalette(int first, int second, int palette[4])
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            palette[i] = Interpolate(first, second, BC7Weights2[i]);
+        }
+    }
+
+    uint32_t EncodeMode5(const Block &block, uint8_t *out)
+    {
+        float first[4], second[4];
+        AxisEndpoints(block, 3, first, second);
+        float weights[4];
+        FirstEndpointWeights(BC7Weights2, 4, weights);
+
+        int bestColor[2][3] = {};
+        uint8_t bestColorIndices[16] = {};
+        uint32_t bestColorError = std::numeric_limits<uint32_t>::max();
+        for (int iteration = 0; iteration < 3; iteration++)
+        {
+            int endpoints[2][3];
+            for (int c = 0; c < 3; c++)
+            {
+                endpoints[0][c] = Clamp(static_cast<int>(std::lround(first[c] * 127.0f / 255.0f)), 0, 127);
+                endpoints[1][c] = Clamp(static_cast<int>(std::lround(second[c] * 127.0f / 255.0f)), 0, 127);
+            }
+            int palette[4][4];
+            Mode5ColorPalette(endpoints, palette);
+            uint8_t indices[16];
+            uint32_t error = FitIndices(block, palette, 4, false, indices);
+            if (error >= bestColorError)
+            {
+                break;
+            }
+            bestColorError = error;
+            std::memcpy(bestColor, endpoints, sizeof(endpoints));
+            std::memcpy(bestColorIndices, indices, sizeof(indices));
+            if (error == 0 || !LeastSquaresEndpoints(block, 3, indices, weights, first, second))
+            {
+                break;
+            }
+        }
+
+        uint8_t alphas[16];
+        int alphaLow = 255, alphaHigh = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            alphas[i] = block.texels[i][3];
+            alphaLow = std::min<int>(alphaLow, alphas[i]);
+            alphaHigh = std::max<int>(alphaHigh, alphas[i]);
+        }
+        int alphaPalette[4];
+        Mode5AlphaPalette(alphaLow, alphaHigh, alphaPalette);
+        uint8_t alphaIndices[16];
+        uint32_t alphaError = FitChannelIndices(alphas, alphaPalette, 4, alphaIndices);
+
+        if (bestColorIndices[0] >= 2)
+        {
+            std::swap(bestColor[0], bestColor[1]);
+            for (uint8_t &index : bestColorIndices)
+            {
+                index = static_cast<uint8_t>(3 - index);
+            }
+        }
+        if (alphaIndices[0] >= 2)
+        {
+            std::swap(alphaLow, alphaHigh);
+            for (uint8_t &index : alphaIndices)
+            {
+                index = static_cast<uint8_t>(3 - index);
+            }
+        }
+
+        std::memset(out, 0, 16);
+        BlockBits bits(out);
+        bits.Write(1u << 5, 6);
+        bits.Write(0, 2); // No channel rotation
+        for (int c = 0; c < 3; c++)
+        {
+            bits.Write(bestColor[0][c], 7);
+            bits.Write(bestColor[1][c], 7);
+        }
+        bits.Write(alphaLow, 8);
+        bits.Write(alphaHigh, 8);
+        WriteIndices(bits, bestColorIndices, 2);
+        WriteIndices(bits, alphaIndices, 2);
+        return bestColorError + alphaError;
+    }
+
+    void DecodeMode5(BlockBits &bits, Block &block)
+    {
+        int rotation = static_cast<int>(bits.Read(2));
+        int endpoints[2][3];
+        for (int c = 0; c < 3; c++)
+        {
+            endpoints[0][c] = static_cast<int>(bits.Read(7));
+            endpoints[1][c] = static_cast<int>(bits.Read(7));
+        }
+        int alphaFirst = static_cast<int>(bits.Read(8));
+        int alphaSecond = static_cast<int>(bits.Read(8));
+        int palette[4][4];
+        Mode5ColorPalette(endpoints, palette);
+        int alphaPalette[4];
+        Mode5AlphaPalette(alphaFirst, alphaSecond, alphaPalette);
+        uint8_t colorIndices[16], alphaIndices[16];
+        ReadIndices(bits, colorIndices, 2);
+        ReadIndices(bits, alphaIndices, 2);
+        for (int i = 0; i < 16; i++)
+        {
+            uint8_t *texel = block.texels[i];
+            for (int c = 0; c < 3; c++)
+            {
+                texel[c] = static_cast<uint8_t>(palette[colorIndices[i]][c]);
+            }
+            texel[3] = static_cast<uint8_t>(alphaPalette[alphaIndices[i]]);
+            if (rotation > 0)
+            {
+                std::swap(texel[3], texel[rotation - 1]);
+            }
+        }
+    }
+
+    void EncodeBC7Block(const Block &block, uint8_t *out)
+    {
+        bool solid = true;
+        bool varyingAlpha = false;
+        for (int i = 1; i < 16; i++)
+        {
+            solid &= std::memcmp(block.texels[i], block.texels[0], 4) == 0;
+            varyingAlpha |= block.texels[i][3] != block.texels[0][3];
+        }
+        if (solid && EncodeMode6Solid(block.texels[0], out))
+        {
+            return;
+        }
+
+        // Mode 5's 7-bit colors are exact for the solid colors mode 6 misses, such as pure red
+        uint32_t error = EncodeMode6(block, out);
+        if (error > 0 && (varyingAlpha || solid))
+        {
+            uint8_t separate[16];
+            if (EncodeMode5(block, separate) < error)
+            {
+                std::memcpy(out, separate, sizeof(separate));
+            }
+        }
+    }
+
+    void DecodeBC7Block(const uint8_t *in, Block &block)
+    {
+        uint8_t bytes[16];
+        std::memcpy(bytes, in, sizeof(bytes));
+        BlockBits bits(bytes);
+
+        // The mode is the number of zero bits before the first one
+        int mode = 0;
+        while (mode < 8 && bits.Read(1) == 0)
+        {
+            mode++;
+        }
+        if (mode == 5)
+        {
+            DecodeMode5(bits, block);
+        }
+        else if (mode == 6)
+        {
+            DecodeMode6(bits, block);
+        }
+        else
+        {
+            const uint8_t magenta[4] = {255, 0, 255, 255};
+            for (int i = 0; i < 16; i++)
+            {
+                std::memcpy(block.texels[i], magenta, 4);
+            }
+        }
+    }
+
+    float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // RGBA in 0..1 with color premultiplied by alpha, so transparent texels do not bleed into the
+    // levels below
+    struct FloatImage
+    {
+        int width;
+        int height;
+        std::vector<float> texels;
+    };
+
+    // Halves one axis with the weights 1 3 3 1, centered between the two texels each output covers
+    FloatImage DownsampleAxis(const FloatImage &source, bool horizontal, bool wrap)
+    {
+        int sourceSize = horizontal ? source.width : source.height;
+        if (sourceSize == 1)
+        {
+            return source;
+        }
+        FloatImage result;
+        result.width = horizontal ? source.width / 2 : source.width;
+        result.height = horizontal ? source.height : source.height / 2;
+        result.texels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+        const float weights[4] = {0.125f, 0.375f, 0.375f, 0.125f};
+        auto sampleIndex = [&](int index)
+        {
+            return wrap ? (index % sourceSize + sourceSize) % sourceSize : Clamp(index, 0, sourceSize - 1);
+        };
+        for (int y = 0; y < result.height; y++)
+        {
+            for (int x = 0; x < result.width; x++)
+            {
+                float *out = &result.texels[(static_cast<size_t>(y) * result.width + x) * 4];
+                int center = (horizontal ? x : y) * 2;
+                for (int tap = 0; tap < 4; tap++)
+                {
+                    int index = sampleIndex(center - 1 + tap);
+                    int sourceX = horizontal ? index : x;
+                    int sourceY = horizontal ? y : index;
+                    const float *in = &source.texels[(static_cast<size_t>(sourceY) * source.width + sourceX) * 4];
+                    for (int c = 0; c < 4; c++)
+                    {
+                        out[c] += weights[tap] * in[c];
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    MipLevel ToLevel(const FloatImage &image, const MipOptions &options, const uint8_t *linearToSrgb)
+    {
+        MipLevel level;
+        level.width = image.width;
+        level.height = image.height;
+        level.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+        for (size_t i = 0; i < level.pixels.size(); i += 4)
+        {
+            const float *texel = &image.texels[i];
+            float alpha = texel[3];
+            float color[3] = {texel[0], texel[1], texel[2]};
+            if (options.normalMap)
+            {
+                float vector[3] = {color[0] * 2.0f - 1.0f, color[1] * 2.0f - 1.0f, color[2] * 2.0f - 1.0f};
+                float length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+                for (int c = 0; c < 3; c++)
+                {
+                    color[c] = length > 0.0f ? vector[c] / length * 0.5f + 0.5f : 0.5f;
+                }
+            }
+            else if (alpha > 0.0f)
+            {
+                for (float &value : color)
+                {
+                    value /= alpha;
+                }
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                float value = std::min(std::max(color[c], 0.0f), 1.0f);
+                level.pixels[i + c] = options.srgb && !options.normalMap ? linearToSrgb[static_cast<int>(value * 4095.0f + 0.5f)]
+                                                                         : static_cast<uint8_t>(value * 255.0f + 0.5f);
+            }
+            level.pixels[i + 3] = static_cast<uint8_t>(std::min(std::max(alpha, 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+        return level;
+    }
+}
+
+size_t GetBlockSize(BlockFormat format)
+{
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+size_t GetCompressedSize(BlockFormat format, int width, int height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+const char *GetFormatName(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        return "BC1";
+    case BlockFormat::BC3:
+        return "BC3";
+    case BlockFormat::BC5:
+        return "BC5";
+    case BlockFormat::BC7:
+        return "BC7";
+    }
+    return "unknown";
+}
+
+void CompressBlocks(BlockFormat format, const uint8_t *rgba, int width, int height, uint8_t *blocks)
+{
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    size_t blockSize = GetBlockSize(format);
+    Block block;
+    for (int y = 0; y < blocksY; y++)
+    {
+        for (int x = 0; x < blocksX; x++)
+        {
+            LoadBlock(rgba, width, height, x, y, block);
+            uint8_t *out = blocks + (static_cast<size_t>(y) * blocksX + x) * blockSize;
+            switch (format)
+            {
+            case BlockFormat::BC1:
+                EncodeColorBlock(block, out);
+                break;
+            case BlockFormat::BC3:
+                EncodeChannelBlock(block, 3, out);
+                EncodeColorBlock(block, out + 8);
+                break;
+            case BlockFormat::BC5:
+                EncodeChannelBlock(block, 0, out);
+                EncodeChannelBlock(block, 1, out + 8);
+                break;
+            case BlockFormat::BC7:
+                EncodeBC7Block(block, out);
+                break;
+            }
+        }
+    }
+}
+
+void DecompressBlocks(BlockFormat format, const uint8_t *blocks, int width, int height, uint8_t *rgba)
+{
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    size_t blockSize = GetBlockSize(format);
+    for (int y = 0; y < blocksY; y++)
+    {
+        for (int x = 0; x < blocksX; x++)
+        {
+            const uint8_t *in = blocks + (static_cast<size_t>(y) * blocksX + x) * blockSize;
+            Block block = {};
+            switch (format)
+            {
+            case BlockFormat::BC1:
+                DecodeColorBlock(in, block);
+                break;
+            case BlockFormat::BC3:
+                DecodeColorBlock(in + 8, block);
+                DecodeChannelBlock(in, 3, block);
+                break;
+            case BlockFormat::BC5:
+                DecodeChannelBlock(in, 0, block);
+                DecodeChannelBlock(in + 8, 1, block);
+                for (auto &texel : block.texels)
+                {
+                    texel[3] = 255;
+                }
+                break;
+            case BlockFormat::BC7:
+                DecodeBC7Block(in, block);
+                break;
+            }
+            StoreBlock(block, width, height, x, y, rgba);
+        }
+    }
+}
+
+double ComputePSNR(const uint8_t *reference, const uint8_t *decoded, int width, int height, int channelCount)
+{
+    size_t texels = static_cast<size_t>(width) * height;
+    double squaredError = 0.0;
+    for (size_t i = 0; i < texels; i++)
+    {
+        for (int c = 0; c < channelCount; c++)
+        {
+            double difference = static_cast<double>(reference[i * 4 + c]) - decoded[i * 4 + c];
+            squaredError += difference * difference;
+        }
+    }
+    if (squaredError == 0.0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    double meanSquaredError = squaredError / (static_cast<double>(texels) * channelCount);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+std::vector<MipLevel> GenerateMipChain(const uint8_t *rgba, int width, int height, const MipOptions &options)
+{
+    std::vector<MipLevel> levels;
+    levels.push_back({width, height, std::vector<uint8_t>(rgba, rgba + static_cast<size_t>(width) * height * 4)});
+
+    bool srgb = options.srgb && !options.normalMap;
+    float toLinear[256];
+    uint8_t toSrgb[4096];
+    for (int i = 0; i < 256; i++)
+    {
+        toLinear[i] = srgb ? SrgbToLinear(i / 255.0f) : i / 255.0f;
+    }
+    for (int i = 0; i < 4096; i++)
+    {
+        toSrgb[i] = static_cast<uint8_t>(LinearToSrgb(i / 4095.0f) * 255.0f + 0.5f);
+    }
+
+    // Every level is filtered from the one above kept in float, so rounding does not accumulate
+    FloatImage image;
+    image.width = width;
+    image.height = height;
+    image.texels.resize(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < image.texels.size(); i += 4)
+    {
+        float alpha = rgba[i + 3] / 255.0f;
+        float premultiply = options.normalMap ? 1.0f : alpha;
+        for (int c = 0; c < 3; c++)
+        {
+            image.texels[i + c] = toLinear[rgba[i + c]] * premultiply;
+        }
+        image.texels[i + 3] = alpha;
+    }
+
+    while (image.width > 1 || image.height > 1)
+    {
+        image = DownsampleAxis(DownsampleAxis(image, true, options.wrap), false, options.wrap);
+        levels.push_back(ToLevel(image, options, toSrgb));
+    }
+    return levels;
+}
+
+std::vector<CompressedLevel> CompressedTexture::GetLevels() const
+{
+    std::vector<CompressedLevel> views;
+    for (const Level &level : levels)
+    {
+        views.push_back({level.width, level.height, level.blocks.data(), level.blocks.size()});
+    }
+    return views;
+}
+
+BlockFormat ChooseBlockFormat(TextureCompression compression, bool hasAlpha)
+{
+    if (compression == TextureCompression::BC7)
+    {
+        return BlockFormat::BC7;
+    }
+    return hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+}
+
+CompressedTexture CompressTexture(const uint8_t *rgba, int width, int height, BlockFormat format, const MipOptions &options)
+{
+    CompressedTexture texture;
+    texture.format = format;
+    for (MipLevel &level : GenerateMipChain(rgba, width, height, options))
+    {
+        CompressedTexture::Level &compressed = texture.levels.emplace_back();
+        compressed.width = level.width;
+        compressed.height = level.height;
+        compressed.blocks.resize(GetCompressedSize(format, level.width, level.height));
+        CompressBlocks(format, level.pixels.data(), level.width, level.height, compressed.blocks.data());
+    }
+
+    const CompressedTexture::Level &top = texture.levels.front();
+    std::vector<uint8_t> decoded(static_cast<size_t>(width) * height * 4);
+    DecompressBlocks(format, top.blocks.data(), width, height, decoded.data());
+    int channels = format == BlockFormat::BC5 ? 2 : format == BlockFormat::BC1 ? 3 : 4;
+    texture.psnr = ComputePSNR(rgba, decoded.data(), width, height, channels);
+    return texture;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block-compressed formats the texture cooker writes. Every format encodes 4x4 texel blocks;
+// images whose size is not a multiple of 4 are padded by repeating their last row and column.
+enum class BlockFormat : uint32_t
+{
+    BC1 = 1, // RGB, 8 bytes per block; opaque only
+    BC3 = 2, // RGBA, 16 bytes per block: BC1 color plus an interpolated alpha block
+    BC5 = 3, // Two channels (RG), 16 bytes per block; normal maps, the shader rebuilds Z
+    BC7 = 4  // RGBA, 16 bytes per block; higher quality than BC1/BC3 at the BC3 size
+};
+
+// How imported textures are stored on the GPU
+enum class TextureCompression
+{
+    None, // Uncompressed, mip chain generated by the driver at load time
+    BC,   // BC1 for opaque textures, BC3 when they have alpha
+    BC7   // BC7 for everything
+};
+
+size_t GetBlockSize(BlockFormat format);
+size_t GetCompressedSize(BlockFormat format, int width, int height);
+const char *GetFormatName(BlockFormat format);
+
+// Compresses an RGBA8 image, rows tightly packed, into blocks in row-major order. BC5 takes the
+// red and green channels, BC1 ignores alpha.
+void CompressBlocks(BlockFormat format, const uint8_t *rgba, int width, int height, uint8_t *blocks);
+
+// Expands blocks back into an RGBA8 image, for quality checks and for drivers without the format.
+// Channels a format does not store are 0, alpha 255. BC7 decoding covers modes 5 and 6, the ones
+// CompressBlocks writes; blocks in other modes decode to magenta.
+void DecompressBlocks(BlockFormat format, const uint8_t *blocks, int width, int height, uint8_t *rgba);
+
+// Peak signal-to-noise ratio in dB between two RGBA8 images over their first channelCount
+// channels; infinity when they are identical
+double ComputePSNR(const uint8_t *reference, const uint8_t *decoded, int width, int height, int channelCount);
+
+struct MipOptions
+{
+    bool srgb = true;       // Color channels are filtered in linear light; alpha always is linear
+    bool wrap = true;       // The filter wraps around the edges, as repeating textures are sampled
+    bool normalMap = false; // RG(B) hold a unit vector mapped to 0..255, renormalized on every level
+};
+
+struct MipLevel
+{
+    int width;
+    int height;
+    std::vector<uint8_t> pixels; // RGBA8
+};
+
+// The image followed by every level below it down to 1x1, each downsampled from the one above
+// with a separable 4-tap tent filter, which unlike a 2x2 box does not alias as dimensions halve
+std::vector<MipLevel> GenerateMipChain(const uint8_t *rgba, int width, int height, const MipOptions &options = MipOptions());
+
+// View of one level of a compressed texture
+struct CompressedLevel
+{
+    int width;
+    int height;
+    const uint8_t *data;
+    size_t size;
+};
+
+// A compressed image with its full mip chain, as produced by the cooker
+struct CompressedTexture
+{
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<uint8_t> blocks;
+    };
+
+    BlockFormat format = BlockFormat::BC1;
+    std::vector<Level> levels;
+    double psnr = 0.0; // Of the top level against its source, over the channels the format stores
+
+    std::vector<CompressedLevel> GetLevels() const;
+};
+
+// Format for a texture given the compression setting and whether any texel is translucent
+BlockFormat ChooseBlockFormat(TextureCompression compression, bool hasAlpha);
+
+// Builds the mip chain of an RGBA8 image and compresses every level
+CompressedTexture CompressTexture(const uint8_t *rgba, int width, int height, BlockFormat format,
+                                  const MipOptions &options = MipOptions());
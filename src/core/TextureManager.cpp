@@ -0,0 +1,319 @@
+#include "TextureManager.h"
+#include "Hash.h"
+#include "Log.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <filesystem>
+#include "stb_image.h"
+
+struct TextureHandle::Entry
+{
+    TextureManager *owner;
+    GLuint id;
+    int width;
+    int height;
+    size_t bytes;
+    uint64_t contentHash;
+    std::vector<std::string> keys; // The first is the one it was created under
+    std::atomic<uint32_t> references{0};
+};
+
+TextureHandle::TextureHandle(const TextureHandle &other) : entry(other.entry)
+{
+    if (entry)
+    {
+        entry->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TextureHandle::Reset()
+{
+    if (entry && entry->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        entry->owner->Release(entry);
+    }
+    entry = nullptr;
+}
+
+GLuint TextureHandle::GetId() const
+{
+    return entry ? entry->id : 0;
+}
+
+TextureManager::TextureManager() = default; // Here, where Entry is complete
+
+TextureManager::~TextureManager()
+{
+    if (!entries.empty())
+    {
+        LOG_WARN(LogCategory::Render, "{} textures are still referenced at shutdown", entries.size());
+        for (std::unique_ptr<Entry> &entry : entries)
+        {
+            entry.release(); // Handles still point at it
+        }
+    }
+}
+
+std::string TextureManager::NormalizePath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(path, error);
+    return (error ? std::filesystem::path(path) : absolute).lexically_normal().generic_string();
+}
+
+TextureHandle TextureManager::Find(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byKey.find(key);
+    if (it == byKey.end())
+    {
+        return TextureHandle();
+    }
+    // Under the lock, so a concurrent Release sees the revived count and keeps the texture
+    it->second->references.fetch_add(1, std::memory_order_relaxed);
+    stats.sharedHits++;
+    return TextureHandle(it->second);
+}
+
+TextureHandle TextureManager::FindShared(const std::string &key, int width, int height, uint64_t contentHash)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byKey.find(key);
+    Entry *existing = it != byKey.end() ? it->second : nullptr;
+    if (!existing && contentHash != 0)
+    {
+        auto content = byContent.find(contentHash);
+        if (content != byContent.end() && content->second->width == width && content->second->height == height)
+        {
+            // Same image under another name: later lookups by this key find it too
+            existing = content->second;
+            existing->keys.push_back(key);
+            byKey[key] = existing;
+        }
+    }
+    if (!existing)
+    {
+        return TextureHandle();
+    }
+    existing->references.fetch_add(1, std::memory_order_relaxed);
+    stats.sharedHits++;
+    return TextureHandle(existing);
+}
+
+TextureHandle TextureManager::Register(const std::string &key, GLuint id, int width, int height, size_t bytes, uint64_t contentHash)
+{
+    auto entry = std::make_unique<Entry>();
+    entry->owner = this;
+    entry->id = id;
+    entry->width = width;
+    entry->height = height;
+    entry->bytes = bytes;
+    entry->contentHash = contentHash;
+    entry->keys.push_back(key);
+    entry->references.store(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry *created = entry.get();
+    byKey[key] = created;
+    if (contentHash != 0)
+    {
+        byContent.emplace(contentHash, created);
+    }
+    entries.push_back(std::move(entry));
+    stats.textures = entries.size();
+    stats.bytes += created->bytes;
+    stats.peakBytes = std::max(stats.peakBytes, stats.bytes);
+    return TextureHandle(created);
+}
+
+TextureHandle TextureManager::Create(const std::string &key, const TextureDesc &desc, const void *pixels, uint64_t contentHash)
+{
+    TextureHandle shared = FindShared(key, desc.width, desc.height, contentHash);
+    if (shared)
+    {
+        return shared;
+    }
+
+    PROFILE_SCOPE("TextureManager::Upload");
+    GLenum format = desc.channels == 1 ? GL_RED : desc.channels == 3 ? GL_RGB
+                                                                      : GL_RGBA;
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows of RGB and single-channel images are not padded
+    glTexImage2D(GL_TEXTURE_2D, 0, format, desc.width, desc.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (desc.mipmaps)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    GLint wrap = desc.repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Drivers keep RGB as RGBA; a full mip chain adds a third
+    size_t texelBytes = desc.channels == 3 ? 4 : static_cast<size_t>(desc.channels);
+    size_t bytes = static_cast<size_t>(desc.width) * desc.height * texelBytes;
+    if (desc.mipmaps)
+    {
+        bytes += bytes / 3;
+    }
+    return Register(key, id, desc.width, desc.height, bytes, contentHash);
+}
+
+bool TextureManager::IsFormatSupported(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+    case BlockFormat::BC3:
+        return GLEW_EXT_texture_compression_s3tc;
+    case BlockFormat::BC5:
+        return GLEW_VERSION_3_0 || GLEW_ARB_texture_compression_rgtc;
+    case BlockFormat::BC7:
+        return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+    }
+    return false;
+}
+
+TextureHandle TextureManager::CreateCompressed(const std::string &key, BlockFormat format, const std::vector<CompressedLevel> &levels,
+                                               uint64_t contentHash)
+{
+    if (levels.empty())
+    {
+        return TextureHandle();
+    }
+    TextureHandle shared = FindShared(key, levels.front().width, levels.front().height, contentHash);
+    if (shared)
+    {
+        return shared;
+    }
+
+    PROFILE_SCOPE("TextureManager::UploadCompressed");
+    GLenum internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        break;
+    case BlockFormat::BC3:
+        internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        break;
+    case BlockFormat::BC5:
+        internalFormat = GL_COMPRESSED_RG_RGTC2;
+        break;
+    case BlockFormat::BC7:
+        break;
+    }
+    bool supported = IsFormatSupported(format);
+    if (!supported)
+    {
+        LOG_WARN(LogCategory::Render, "{} textures are not supported by this context, {} is uploaded uncompressed", GetFormatName(format), key);
+    }
+
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    size_t bytes = 0;
+    std::vector<uint8_t> decoded;
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        const CompressedLevel &level = levels[i];
+        GLint index = static_cast<GLint>(i);
+        if (supported)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, index, internalFormat, level.width, level.height, 0, static_cast<GLsizei>(level.size), level.data);
+            bytes += level.size;
+        }
+        else
+        {
+            decoded.resize(static_cast<size_t>(level.width) * level.height * 4);
+            DecompressBlocks(format, level.data, level.width, level.height, decoded.data());
+            glTexImage2D(GL_TEXTURE_2D, index, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+            bytes += decoded.size();
+        }
+    }
+
+    // The chain comes with the texture; nothing is generated at load time
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size() - 1));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return Register(key, id, levels.front().width, levels.front().height, bytes, contentHash);
+}
+
+TextureHandle TextureManager::Load(const std::string &path)
+{
+    std::string key = NormalizePath(path);
+    TextureHandle handle = Find(key);
+    if (handle)
+    {
+        return handle;
+    }
+
+    TextureDesc desc;
+    unsigned char *pixels = stbi_load(path.c_str(), &desc.width, &desc.height, &desc.channels, 0);
+    if (!pixels)
+    {
+        LOG_ERROR(LogCategory::Assets, "Texture failed to load at path: {}", path);
+        return TextureHandle();
+    }
+    size_t size = static_cast<size_t>(desc.width) * desc.height * desc.channels;
+    handle = Create(key, desc, pixels, HashBytes(pixels, size));
+    stbi_image_free(pixels);
+    return handle;
+}
+
+void TextureManager::Release(Entry *entry)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Another release may have deleted it already if a lookup revived it in between
+    auto it = std::find_if(entries.begin(), entries.end(), [&](const std::unique_ptr<Entry> &candidate)
+                           { return candidate.get() == entry; });
+    if (it == entries.end() || entry->references.load(std::memory_order_acquire) != 0)
+    {
+        return;
+    }
+
+    for (const std::string &key : entry->keys)
+    {
+        byKey.erase(key);
+    }
+    auto content = byContent.find(entry->contentHash);
+    if (content != byContent.end() && content->second == entry)
+    {
+        byContent.erase(content);
+    }
+    glDeleteTextures(1, &entry->id);
+    stats.bytes -= entry->bytes;
+
+    std::swap(*it, entries.back());
+    entries.pop_back();
+    stats.textures = entries.size();
+}
+
+TextureManager::Stats TextureManager::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::vector<TextureManager::Resident> TextureManager::GetResidentTextures() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Resident> resident;
+    resident.reserve(entries.size());
+    for (const std::unique_ptr<Entry> &entry : entries)
+    {
+        resident.push_back({entry->keys.front(), entry->id, entry->width, entry->height, entry->bytes,
+                            entry->references.load(std::memory_order_relaxed)});
+    }
+    return resident;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <GL/glew.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <entt.hpp>
+#include "TextureCompression.h"
+
+class TextureManager;
+
+// Shared reference to a texture owned by a TextureManager. The GL texture is deleted when the
+// last handle to it is released, which has to happen on the thread owning the GL context.
+class TextureHandle
+{
+public:
+    TextureHandle() : entry(nullptr) {}
+    TextureHandle(const TextureHandle &other);
+    TextureHandle(TextureHandle &&other) noexcept : entry(other.entry) { other.entry = nullptr; }
+    TextureHandle &operator=(TextureHandle other) noexcept
+    {
+        std::swap(entry, other.entry);
+        return *this;
+    }
+    ~TextureHandle() { Reset(); }
+
+    void Reset();
+
+    GLuint GetId() const;
+    bool IsValid() const { return entry != nullptr; }
+    explicit operator bool() const { return entry != nullptr; }
+
+private:
+    friend class TextureManager;
+    struct Entry; // Defined in TextureManager.cpp
+    explicit TextureHandle(Entry *entry) : entry(entry) {}
+    Entry *entry;
+};
+
+struct TextureDesc
+{
+    int width = 0;
+    int height = 0;
+    int channels = 4;     // 1, 3 or 4 bytes per pixel, rows tightly packed
+    bool mipmaps = true;  // Full mip chain with trilinear filtering; otherwise bilinear
+    bool repeat = true;   // Wrap mode; clamped to the edge otherwise
+};
+
+// Every texture the engine uploads, each loaded once and shared by everyone who asks for it.
+//
+// Textures are registered under a key, normally the normalized path of the file they come from.
+// When a caller also passes the hash of the pixels, a texture with the same content is shared even
+// if it arrives under a different key, e.g. the same image copied next to two models. Lookups may
+// run on any thread, so import workers can skip decoding textures that are already resident;
+// creating textures needs the GL context.
+class TextureManager
+{
+public:
+    TextureManager();
+    // Every handle must be gone by now; textures still referenced are leaked rather than deleted
+    // behind their owners' backs
+    ~TextureManager();
+
+    TextureManager(const TextureManager &) = delete;
+    TextureManager &operator=(const TextureManager &) = delete;
+
+    // The texture registered under key, or an empty handle; any thread
+    TextureHandle Find(const std::string &key);
+
+    // Uploads the pixels and registers them under key, unless a texture with that key or, when
+    // contentHash is not 0, that content already exists: that one is returned and the pixels are
+    // not used. GL thread only.
+    TextureHandle Create(const std::string &key, const TextureDesc &desc, const void *pixels, uint64_t contentHash = 0);
+
+    // Same for a block-compressed texture with its mip chain, largest level first. Contexts without
+    // the format get the levels decompressed. GL thread only.
+    TextureHandle CreateCompressed(const std::string &key, BlockFormat format, const std::vector<CompressedLevel> &levels, uint64_t contentHash = 0);
+
+    // Whether the current context samples the format natively
+    static bool IsFormatSupported(BlockFormat format);
+
+    // Decodes an image file with stb_image if it is not resident yet; empty handle on failure. GL thread only.
+    TextureHandle Load(const std::string &path);
+
+    // Key for a file: absolute, normalized, with forward slashes
+    static std::string NormalizePath(const std::string &path);
+
+    struct Stats
+    {
+        size_t textures = 0;
+        size_t bytes = 0;      // Estimated GPU memory, mip chains included; compressed textures at their block size
+        size_t peakBytes = 0;
+        size_t sharedHits = 0; // Requests served by a resident texture instead of a new upload
+    };
+    Stats GetStats() const;
+
+    struct Resident
+    {
+        std::string key;
+        GLuint id;
+        int width;
+        int height;
+        size_t bytes;
+        uint32_t references;
+    };
+    // Every resident texture, for the editor
+    std::vector<Resident> GetResidentTextures() const;
+
+private:
+    friend class TextureHandle;
+    using Entry = TextureHandle::Entry;
+
+    // The texture under key, or one with the same content and size, which then gets key as an alias
+    TextureHandle FindShared(const std::string &key, int width, int height, uint64_t contentHash);
+    // Adds a texture just uploaded, with one reference for the caller
+    TextureHandle Register(const std::string &key, GLuint id, int width, int height, size_t bytes, uint64_t contentHash);
+
+    // Called when the last handle went away; deletes the texture unless a lookup revived it
+    void Release(Entry *entry);
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry *> byKey;
+    std::unordered_map<uint64_t, Entry *> byContent;
+    std::vector<std::unique_ptr<Entry>> entries;
+    Stats stats;
+};
+
+// Texture manager registered in the registry context, or nullptr
+inline TextureManager *FindTextureManager(entt::registry &registry)
+{
+    TextureManager *const *textures = registry.ctx().find<TextureManager *>();
+    return textures ? *textures : nullptr;
+}
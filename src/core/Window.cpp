@@ -1,8 +1,14 @@
 #include "Window.h"
-#include <iostream>
+#include "Log.h"
 
 Window::Window(int width, int height, const char *title, bool borderless)
-    : width(width), height(height), title(title), window(nullptr), borderless(borderless) {}
+    : width(width), height(height), title(title), window(nullptr), borderless(borderless), headless(false), contextApi(ContextApi::Native) {}
+
+void Window::SetHeadless(bool headless, ContextApi contextApi)
+{
+    this->headless = headless;
+    this->contextApi = contextApi;
+}
 
 Window::~Window()
 {
@@ -12,9 +18,14 @@ Window::~Window()
 
 bool Window::Initialize()
 {
+    if (headless && contextApi != ContextApi::Native)
+    {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+
     if (!glfwInit())
     {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
+        LOG_ERROR(LogCategory::Core, "Failed to initialize GLFW");
         return false;
     }
 
@@ -22,7 +33,16 @@ bool Window::Initialize()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    if (borderless)
+    if (headless)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        if (contextApi == ContextApi::EGL)
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        else if (contextApi == ContextApi::OSMesa)
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    }
+
+    if (borderless && !headless)
     {
         const GLFWvidmode *mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
         glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
@@ -39,7 +59,7 @@ bool Window::Initialize()
 
     if (!window)
     {
-        std::cerr << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR(LogCategory::Core, "Failed to create GLFW window");
         glfwTerminate();
         return false;
     }
@@ -1,11 +1,16 @@
 #pragma once
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "EngineOptions.h"
 
 class Window
 {
 public:
     Window(int width, int height, const char *title, bool borderless = false);
+
+    // Headless windows are never shown; with the EGL or OSMesa context API GLFW's null
+    // platform is used so no display server is needed at all
+    void SetHeadless(bool headless, ContextApi contextApi = ContextApi::Native);
     ~Window();
 
     bool Initialize();
@@ -20,4 +25,6 @@ private:
     const char *title;
     GLFWwindow *window;
     bool borderless;
+    bool headless;
+    ContextApi contextApi;
 };
@@ -0,0 +1,173 @@
+#include "CommandBuffer.h"
+#include "RelationshipComponent.h"
+#include "../core/JobSystem.h"
+
+CommandBuffer::CommandBuffer(JobSystem *jobs)
+    : jobs(jobs), streams((jobs ? jobs->GetThreadCount() : 0) + 1)
+{
+}
+
+CommandBuffer::~CommandBuffer() = default;
+
+CommandBuffer::Writer CommandBuffer::GetWriter(uint32_t sortKey)
+{
+    int threadIndex = jobs ? jobs->GetThreadIndex() : -1;
+    if (threadIndex < 0)
+    {
+        uint32_t shared = static_cast<uint32_t>(streams.size() - 1);
+        return Writer(streams[shared], shared, sortKey, std::unique_lock<std::mutex>(sharedMutex));
+    }
+    return Writer(streams[threadIndex], static_cast<uint32_t>(threadIndex), sortKey, std::unique_lock<std::mutex>());
+}
+
+uint64_t CommandBuffer::Writer::NextOrder()
+{
+    return (static_cast<uint64_t>(sortKey) << 32) | stream->sequence++;
+}
+
+PendingEntity CommandBuffer::Writer::Create()
+{
+    stream->creates.push_back(NextOrder());
+    return {streamIndex, static_cast<uint32_t>(stream->creates.size() - 1)};
+}
+
+void CommandBuffer::Writer::Destroy(CommandTarget entity)
+{
+    stream->destroys.push_back({NextOrder(), entity, entt::entity(entt::null)});
+}
+
+void CommandBuffer::Writer::SetParent(CommandTarget child, CommandTarget parent)
+{
+    stream->reparents.push_back({NextOrder(), child, parent});
+}
+
+entt::entity CommandBuffer::Resolve(const CommandTarget &target) const
+{
+    return target.stream == CommandTarget::NotPending ? target.entity : streams[target.stream].created[target.index];
+}
+
+std::vector<const CommandBuffer::EntityCommand *> CommandBuffer::Sorted(std::vector<EntityCommand> Stream::*list) const
+{
+    // Streams are visited in index order, so the stable sort breaks ties between them the same way every time
+    std::vector<const EntityCommand *> sorted;
+    for (const Stream &stream : streams)
+    {
+        for (const EntityCommand &command : stream.*list)
+        {
+            sorted.push_back(&command);
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const EntityCommand *a, const EntityCommand *b)
+                     { return a->order < b->order; });
+    return sorted;
+}
+
+void CommandBuffer::Playback(entt::registry &registry)
+{
+    // Entities are created in command order so their identifiers do not depend on thread timing
+    struct Creation
+    {
+        uint64_t order;
+        uint32_t stream;
+        uint32_t index;
+    };
+    std::vector<Creation> creations;
+    for (uint32_t s = 0; s < streams.size(); s++)
+    {
+        Stream &stream = streams[s];
+        stream.created.assign(stream.creates.size(), entt::null);
+        for (uint32_t i = 0; i < stream.creates.size(); i++)
+        {
+            creations.push_back({stream.creates[i], s, i});
+        }
+    }
+    std::stable_sort(creations.begin(), creations.end(), [](const Creation &a, const Creation &b)
+                     { return a.order < b.order; });
+    for (const Creation &creation : creations)
+    {
+        streams[creation.stream].created[creation.index] = registry.create();
+    }
+
+    // One component type at a time, each in a single pass over its storage. Types are visited by
+    // id rather than in the order the streams first saw them, which depends on timing.
+    std::vector<entt::id_type> types;
+    for (const Stream &stream : streams)
+    {
+        for (const auto &[type, commands] : stream.components)
+        {
+            if (!commands->IsEmpty())
+            {
+                types.push_back(type);
+            }
+        }
+    }
+    std::sort(types.begin(), types.end());
+    types.erase(std::unique(types.begin(), types.end()), types.end());
+
+    std::vector<ComponentCommandsBase *> batches;
+    for (entt::id_type type : types)
+    {
+        batches.clear();
+        for (Stream &stream : streams)
+        {
+            auto found = stream.components.find(type);
+            if (found != stream.components.end() && !found->second->IsEmpty())
+            {
+                batches.push_back(found->second.get());
+            }
+        }
+        batches.front()->Playback(registry, batches, *this);
+    }
+
+    for (const EntityCommand *command : Sorted(&Stream::reparents))
+    {
+        entt::entity child = Resolve(command->target);
+        entt::entity parent = Resolve(command->other);
+        if (registry.valid(child) && (parent == entt::null || registry.valid(parent)))
+        {
+            ::SetParent(registry, child, parent);
+        }
+    }
+
+    for (const EntityCommand *command : Sorted(&Stream::destroys))
+    {
+        entt::entity entity = Resolve(command->target);
+        if (registry.valid(entity))
+        {
+            registry.destroy(entity);
+        }
+    }
+
+    // Keep the allocations for the next round
+    for (Stream &stream : streams)
+    {
+        stream.sequence = 0;
+        stream.creates.clear();
+        stream.created.clear();
+        stream.reparents.clear();
+        stream.destroys.clear();
+        for (auto &[type, commands] : stream.components)
+        {
+            commands->Clear();
+        }
+    }
+}
+
+bool CommandBuffer::IsEmpty() const
+{
+    for (const Stream &stream : streams)
+    {
+        if (!stream.creates.empty() || !stream.reparents.empty() || !stream.destroys.empty())
+        {
+            return false;
+        }
+        for (const auto &[type, commands] : stream.components)
+        {
+            if (!commands->IsEmpty())
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
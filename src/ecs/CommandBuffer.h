@@ -0,0 +1,225 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <entt.hpp>
+
+class JobSystem;
+
+// Entity created through a command buffer; it only exists once the buffer has been played back
+struct PendingEntity
+{
+    uint32_t stream;
+    uint32_t index;
+};
+
+// Entity a command applies to: one that already exists, or one created earlier in the same buffer
+struct CommandTarget
+{
+    static const uint32_t NotPending = ~0u;
+
+    CommandTarget(entt::entity entity) : entity(entity), stream(NotPending), index(0) {}
+    CommandTarget(PendingEntity pending) : entity(entt::null), stream(pending.stream), index(pending.index) {}
+
+    entt::entity entity;
+    uint32_t stream;
+    uint32_t index;
+};
+
+// Structural changes (create, destroy, emplace, remove, reparent) recorded while the registry must
+// not be modified, e.g. from systems running on workers, and applied later on one thread.
+//
+// Every JobSystem thread records into its own stream, so recording takes no lock; threads outside
+// the job system share one stream behind a mutex. Commands carry a sort key chosen by the caller,
+// for example the first index of the chunk being processed. Playback orders them by key and, for
+// equal keys, by recording order, so the result does not depend on which worker ran what as long
+// as each key is only used by one thread at a time.
+//
+// Playback applies all creations first, then the component commands one component type at a
+// time, then reparenting and finally destruction. Commands on entities that no longer exist are
+// skipped.
+class CommandBuffer
+{
+    struct Stream;
+    struct ComponentCommandsBase;
+    template <typename Component>
+    struct ComponentCommands;
+
+public:
+    // Without a job system every writer goes through the shared stream
+    explicit CommandBuffer(JobSystem *jobs = nullptr);
+    ~CommandBuffer();
+
+    CommandBuffer(const CommandBuffer &) = delete;
+    CommandBuffer &operator=(const CommandBuffer &) = delete;
+
+    // Records into the calling thread's stream; keep it for one unit of work, not across jobs
+    class Writer
+    {
+    public:
+        PendingEntity Create();
+        void Destroy(CommandTarget entity);
+        void SetParent(CommandTarget child, CommandTarget parent); // A null parent makes a root
+
+        // Adds the component, or replaces it if the entity already has one
+        template <typename Component, typename... Args>
+        void Emplace(CommandTarget entity, Args &&...args);
+
+        template <typename Component>
+        void Remove(CommandTarget entity);
+
+    private:
+        friend class CommandBuffer;
+        Writer(Stream &stream, uint32_t streamIndex, uint32_t sortKey, std::unique_lock<std::mutex> lock)
+            : stream(&stream), streamIndex(streamIndex), sortKey(sortKey), lock(std::move(lock)) {}
+
+        uint64_t NextOrder();
+        template <typename Component>
+        ComponentCommands<Component> &Commands();
+
+        Stream *stream;
+        uint32_t streamIndex;
+        uint32_t sortKey;
+        std::unique_lock<std::mutex> lock; // Held only for the shared stream
+    };
+
+    Writer GetWriter(uint32_t sortKey = 0);
+
+    // Applies and clears everything recorded so far; no writer may be in use meanwhile
+    void Playback(entt::registry &registry);
+
+    bool IsEmpty() const;
+
+private:
+    // Emplace and remove commands of one component type within one stream
+    struct ComponentCommandsBase
+    {
+        virtual ~ComponentCommandsBase() = default;
+        // Applies the commands of this type from all streams; every entry of batches has this type
+        virtual void Playback(entt::registry &registry, const std::vector<ComponentCommandsBase *> &batches,
+                              const CommandBuffer &buffer) = 0;
+        virtual void Clear() = 0;
+        virtual bool IsEmpty() const = 0;
+    };
+
+    struct EntityCommand
+    {
+        uint64_t order;
+        CommandTarget target;
+        CommandTarget other; // New parent for reparenting
+    };
+
+    struct alignas(64) Stream
+    {
+        uint32_t sequence = 0;
+        std::vector<uint64_t> creates;     // Order of each pending entity
+        std::vector<entt::entity> created; // Filled by playback
+        std::vector<EntityCommand> reparents;
+        std::vector<EntityCommand> destroys;
+        std::unordered_map<entt::id_type, std::unique_ptr<ComponentCommandsBase>> components;
+    };
+
+    entt::entity Resolve(const CommandTarget &target) const;
+    // The given command list of every stream merged in playback order
+    std::vector<const EntityCommand *> Sorted(std::vector<EntityCommand> Stream::*list) const;
+
+    JobSystem *jobs;
+    std::vector<Stream> streams; // One per job system thread, then the shared one
+    std::mutex sharedMutex;
+};
+
+template <typename Component>
+struct CommandBuffer::ComponentCommands : CommandBuffer::ComponentCommandsBase
+{
+    struct Command
+    {
+        uint64_t order;
+        CommandTarget target;
+        std::optional<Component> value; // Empty for removal
+    };
+    std::vector<Command> commands;
+
+    void Playback(entt::registry &registry, const std::vector<ComponentCommandsBase *> &batches,
+                  const CommandBuffer &buffer) override
+    {
+        std::vector<Command *> sorted;
+        for (ComponentCommandsBase *batch : batches)
+        {
+            for (Command &command : static_cast<ComponentCommands *>(batch)->commands)
+            {
+                sorted.push_back(&command);
+            }
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Command *a, const Command *b)
+                         { return a->order < b->order; });
+
+        // One storage lookup for the whole batch
+        auto &storage = registry.storage<Component>();
+        storage.reserve(storage.size() + sorted.size());
+        for (Command *command : sorted)
+        {
+            entt::entity entity = buffer.Resolve(command->target);
+            if (!registry.valid(entity))
+            {
+                continue;
+            }
+            if (!command->value)
+            {
+                storage.remove(entity);
+            }
+            else if (!storage.contains(entity))
+            {
+                storage.emplace(entity, std::move(*command->value));
+            }
+            else if constexpr (std::is_empty_v<Component>)
+            {
+                storage.patch(entity);
+            }
+            else
+            {
+                storage.patch(entity, [&](Component &component)
+                              { component = std::move(*command->value); });
+            }
+        }
+    }
+
+    void Clear() override { commands.clear(); }
+    bool IsEmpty() const override { return commands.empty(); }
+};
+
+template <typename Component>
+CommandBuffer::ComponentCommands<Component> &CommandBuffer::Writer::Commands()
+{
+    std::unique_ptr<ComponentCommandsBase> &commands = stream->components[entt::type_hash<Component>::value()];
+    if (!commands)
+    {
+        commands = std::make_unique<ComponentCommands<Component>>();
+    }
+    return static_cast<ComponentCommands<Component> &>(*commands);
+}
+
+template <typename Component, typename... Args>
+void CommandBuffer::Writer::Emplace(CommandTarget entity, Args &&...args)
+{
+    // Braces for aggregates, as entt does when emplacing
+    if constexpr (std::is_aggregate_v<Component>)
+    {
+        Commands<Component>().commands.push_back({NextOrder(), entity, Component{std::forward<Args>(args)...}});
+    }
+    else
+    {
+        Commands<Component>().commands.push_back({NextOrder(), entity, Component(std::forward<Args>(args)...)});
+    }
+}
+
+template <typename Component>
+void CommandBuffer::Writer::Remove(CommandTarget entity)
+{
+    Commands<Component>().commands.push_back({NextOrder(), entity, std::nullopt});
+}
@@ -0,0 +1,79 @@
+#include "MovementSystem.h"
+#include "ParallelView.h"
+#include "TransformChangeLog.h"
+#include "../core/Log.h"
+#include "../core/Simd.h"
+#include <cstddef>
+
+// The kernels treat position as the first three floats of the component and load a fourth
+static_assert(offsetof(TransformComponent, position) == 0 && sizeof(glm::vec3) == 3 * sizeof(float),
+              "IntegratePositions expects position at the start of TransformComponent");
+static_assert(sizeof(TransformComponent) >= 4 * sizeof(float), "IntegratePositions loads four floats per transform");
+static_assert(entt::component_traits<TransformComponent>::page_size == entt::component_traits<VelocityComponent>::page_size,
+              "Owned storages must share a page size for packed chunks to line up");
+
+void IntegratePositions(TransformComponent *transforms, const VelocityComponent *velocities, size_t count, float deltaTime)
+{
+    size_t i = 0;
+
+#if defined(EGE_SIMD_AVX2)
+    // Two entities per iteration, one per 128-bit lane: position.xyz plus the rotation.x that follows it,
+    // which is blended back unchanged. Loading velocity i + 1 reads into element i + 2, hence the bound.
+    const __m256 step = _mm256_set1_ps(deltaTime);
+    for (; i + 2 < count; i += 2)
+    {
+        float *position0 = &transforms[i].position.x;
+        float *position1 = &transforms[i + 1].position.x;
+        __m256 position = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(position0)), _mm_loadu_ps(position1), 1);
+        __m256 velocity = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&velocities[i].velocity.x)),
+                                               _mm_loadu_ps(&velocities[i + 1].velocity.x), 1);
+        __m256 moved = _mm256_add_ps(position, _mm256_mul_ps(velocity, step));
+        __m256 result = _mm256_blend_ps(position, moved, 0x77);
+        _mm_storeu_ps(position0, _mm256_castps256_ps128(result));
+        _mm_storeu_ps(position1, _mm256_extractf128_ps(result, 1));
+    }
+#elif defined(EGE_SIMD_SSE)
+    // One entity per iteration; the fourth lane is masked so rotation.x is written back bit-exact.
+    // Loading velocity i reads into element i + 1, hence the bound.
+    const __m128 step = _mm_set1_ps(deltaTime);
+    const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    for (; i + 1 < count; i++)
+    {
+        float *target = &transforms[i].position.x;
+        __m128 position = _mm_loadu_ps(target);
+        __m128 velocity = _mm_loadu_ps(&velocities[i].velocity.x);
+        __m128 moved = _mm_add_ps(position, _mm_mul_ps(velocity, step));
+        _mm_storeu_ps(target, _mm_or_ps(_mm_and_ps(xyzMask, moved), _mm_andnot_ps(xyzMask, position)));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        transforms[i].position += velocities[i].velocity * deltaTime;
+    }
+}
+
+void MovementSystem::AssurePools(entt::registry &registry) const
+{
+    // Creating the group sorts both storages, which must not happen while other systems run
+    registry.group<TransformComponent, VelocityComponent>();
+}
+
+void MovementSystem::Tick(entt::registry &registry, float deltaTime)
+{
+    auto group = registry.group<TransformComponent, VelocityComponent>();
+    auto &transforms = *group.storage<TransformComponent>();
+    auto &velocities = *group.storage<VelocityComponent>();
+
+    ParallelChunks<TransformComponent>(FindJobSystem(registry), group, [&](size_t first, size_t last)
+                                       { IntegratePositions(PackedComponents(transforms, first), PackedComponents(velocities, first),
+                                                            last - first, deltaTime); });
+
+    // Workers cannot emit update signals, so the moved entities are published in one go
+    if (TransformChangeLog *changes = registry.ctx().find<TransformChangeLog>())
+    {
+        changes->Append(transforms.data(), group.size());
+    }
+
+    LOG_TRACE(LogCategory::ECS, "Integrated {} moving entities", group.size());
+}
@@ -1,8 +1,8 @@
 #pragma once
 #include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
 #include "System.h"
 #include <entt.hpp>
-#include <iostream>
 
 // Define the TransformComponent to include position, rotation, and scale
 // Ensure TransformComponent is defined
@@ -11,13 +11,29 @@ struct TransformComponent
     glm::vec3 position;
     glm::vec3 rotation;
     glm::vec3 scale;
-    entt::entity parent;
 
+    // Local to the parent set through RelationshipComponent
     TransformComponent(const glm::vec3 &pos = glm::vec3(0.0f),
                        const glm::vec3 &rot = glm::vec3(0.0f),
-                       const glm::vec3 &scl = glm::vec3(1.0f),
-                       entt::entity par = entt::null)
-        : position(pos), rotation(rot), scale(scl), parent(par) {}
+                       const glm::vec3 &scl = glm::vec3(1.0f))
+        : position(pos), rotation(rot), scale(scl) {}
+
+    // Local matrix from position, Euler rotation in degrees and scale: T * Rx * Ry * Rz * S,
+    // written out in closed form instead of multiplying three rotation matrices
+    glm::mat4 GetMatrix() const
+    {
+        glm::vec3 radians = glm::radians(rotation);
+        float cx = glm::cos(radians.x), sx = glm::sin(radians.x);
+        float cy = glm::cos(radians.y), sy = glm::sin(radians.y);
+        float cz = glm::cos(radians.z), sz = glm::sin(radians.z);
+
+        glm::mat4 matrix;
+        matrix[0] = glm::vec4(cy * cz, sx * sy * cz + cx * sz, sx * sz - cx * sy * cz, 0.0f) * scale.x;
+        matrix[1] = glm::vec4(-cy * sz, cx * cz - sx * sy * sz, cx * sy * sz + sx * cz, 0.0f) * scale.y;
+        matrix[2] = glm::vec4(sy, -sx * cy, cx * cy, 0.0f) * scale.z;
+        matrix[3] = glm::vec4(position, 1.0f);
+        return matrix;
+    }
 };
 
 struct VelocityComponent
@@ -26,25 +42,18 @@ struct VelocityComponent
     glm::vec3 velocity;
 };
 
-class MovementSystem : public System
+// Adds velocity * deltaTime to the positions of count entities laid out as parallel arrays.
+// Uses AVX2 or SSE when the build targets them, with a scalar tail.
+void IntegratePositions(TransformComponent *transforms, const VelocityComponent *velocities, size_t count, float deltaTime);
+
+class MovementSystem : public AccessSystem<Reads<VelocityComponent>, Writes<TransformComponent>>
 {
 public:
-    void Tick(entt::registry &registry, float deltaTime) override
-    {
-        // Get a view of entities with both TransformComponent and VelocityComponent
-        auto view = registry.view<TransformComponent, VelocityComponent>();
+    // The group owns both storages, so transforms and velocities of its members are packed in the
+    // same order and can be integrated as plain arrays, chunk by chunk across the job system.
+    void Tick(entt::registry &registry, float deltaTime) override;
 
-        for (auto entity : view)
-        {
-            auto &transform = view.get<TransformComponent>(entity);
-            const auto &velocity = view.get<VelocityComponent>(entity);
+    const char *GetName() const override { return "MovementSystem"; }
 
-            // Update position based on velocity
-            transform.position += velocity.velocity * deltaTime;
-
-            // Debugging output to check positions
-            std::cout << "Entity " << static_cast<uint32_t>(entity) << " Position: "
-                      << transform.position.x << ", " << transform.position.y << ", " << transform.position.z << std::endl;
-        }
-    }
+    void AssurePools(entt::registry &registry) const override;
 };
@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <type_traits>
+#include <entt.hpp>
+#include "../core/JobSystem.h"
+
+// Helpers that split entt views and groups into contiguous index ranges and run them on the
+// JobSystem. Without a job system everything runs inline on the calling thread.
+//
+// The callbacks run concurrently: they may read and write the components of the entity they
+// are given, but must not create or destroy entities, add or remove components, or call
+// patch()/replace() (signals are not thread-safe). Record changes and publish them afterwards,
+// structural ones through a CommandBuffer writer keyed by the chunk's first index.
+
+// Job system registered in the registry context, or nullptr
+inline JobSystem *FindJobSystem(entt::registry &registry)
+{
+    JobSystem *const *jobs = registry.ctx().find<JobSystem *>();
+    return jobs ? *jobs : nullptr;
+}
+
+// Calls func(entity) for every entity of a view or group
+template <typename ViewOrGroup, typename Func>
+void ParallelEach(JobSystem *jobs, const ViewOrGroup &view, Func func, size_t grainSize = 0)
+{
+    // Views iterate their leading storage and filter; groups own a packed range of exact members
+    constexpr bool isView = std::is_pointer_v<decltype(view.handle())>;
+    const entt::entity *entities = nullptr;
+    size_t count = 0;
+    if constexpr (isView)
+    {
+        if (!view.handle())
+        {
+            return;
+        }
+        entities = view.handle()->data();
+        count = view.handle()->size();
+    }
+    else
+    {
+        entities = view.handle().data();
+        count = view.size();
+    }
+
+    auto body = [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            entt::entity entity = entities[i];
+            if constexpr (isView)
+            {
+                if (!view.contains(entity))
+                {
+                    continue;
+                }
+            }
+            func(entity);
+        }
+    };
+
+    if (jobs)
+    {
+        jobs->ParallelFor(0, count, body, grainSize);
+    }
+    else
+    {
+        body(0, count);
+    }
+}
+
+// Calls func(first, last) over the packed range [0, group.size()) of a group that owns
+// Component. Ranges never cross a storage page, so for every owned component the elements at
+// packed indices [first, last) are contiguous in memory; see PackedComponents.
+template <typename Component, typename Group, typename Func>
+void ParallelChunks(JobSystem *jobs, const Group &group, Func func, size_t pagesPerChunk = 0)
+{
+    constexpr size_t pageSize = entt::component_traits<Component>::page_size;
+    static_assert(pageSize > 0, "ParallelChunks needs a component with storage pages");
+
+    size_t count = group.size();
+    size_t pageCount = (count + pageSize - 1) / pageSize;
+    auto body = [&](size_t firstPage, size_t lastPage)
+    {
+        for (size_t page = firstPage; page < lastPage; page++)
+        {
+            func(page * pageSize, std::min(count, (page + 1) * pageSize));
+        }
+    };
+
+    if (jobs)
+    {
+        jobs->ParallelFor(0, pageCount, body, pagesPerChunk);
+    }
+    else
+    {
+        body(0, pageCount);
+    }
+}
+
+// Address of the component at a packed storage index; the following elements up to the end of
+// its page are contiguous
+template <typename Storage>
+auto *PackedComponents(Storage &storage, size_t index)
+{
+    using Component = typename Storage::value_type;
+    constexpr size_t pageSize = entt::component_traits<Component>::page_size;
+    return storage.raw()[index / pageSize] + index % pageSize;
+}
@@ -0,0 +1,116 @@
+#include "RelationshipComponent.h"
+
+namespace
+{
+    // Removes the entity from its parent's child list; its own children stay attached
+    void Unlink(entt::registry &registry, entt::entity entity, RelationshipComponent &relationship)
+    {
+        if (relationship.parent == entt::null)
+        {
+            return;
+        }
+
+        RelationshipComponent &parent = registry.get<RelationshipComponent>(relationship.parent);
+        if (parent.firstChild == entity)
+        {
+            parent.firstChild = relationship.nextSibling;
+        }
+        if (parent.lastChild == entity)
+        {
+            parent.lastChild = relationship.prevSibling;
+        }
+        if (relationship.prevSibling != entt::null)
+        {
+            registry.get<RelationshipComponent>(relationship.prevSibling).nextSibling = relationship.nextSibling;
+        }
+        if (relationship.nextSibling != entt::null)
+        {
+            registry.get<RelationshipComponent>(relationship.nextSibling).prevSibling = relationship.prevSibling;
+        }
+        parent.childCount--;
+
+        relationship.parent = entt::null;
+        relationship.prevSibling = entt::null;
+        relationship.nextSibling = entt::null;
+    }
+}
+
+bool SetParent(entt::registry &registry, entt::entity child, entt::entity parent)
+{
+    if (child == parent || (parent != entt::null && IsDescendantOf(registry, parent, child)))
+    {
+        return false;
+    }
+    if (GetParent(registry, child) == parent)
+    {
+        return true;
+    }
+
+    // Create the parent's component first so no reference is held across an emplace
+    if (parent != entt::null && !registry.all_of<RelationshipComponent>(parent))
+    {
+        registry.emplace<RelationshipComponent>(parent);
+    }
+    RelationshipComponent &relationship = registry.get_or_emplace<RelationshipComponent>(child);
+    Unlink(registry, child, relationship);
+
+    if (parent != entt::null)
+    {
+        RelationshipComponent &parentRelationship = registry.get<RelationshipComponent>(parent);
+        // Append so children keep the order they were attached in
+        if (parentRelationship.lastChild == entt::null)
+        {
+            parentRelationship.firstChild = child;
+        }
+        else
+        {
+            registry.get<RelationshipComponent>(parentRelationship.lastChild).nextSibling = child;
+            relationship.prevSibling = parentRelationship.lastChild;
+        }
+        parentRelationship.lastChild = child;
+        relationship.parent = parent;
+        parentRelationship.childCount++;
+    }
+
+    // Let observers such as the transform hierarchy know the structure changed
+    registry.patch<RelationshipComponent>(child);
+    return true;
+}
+
+entt::entity GetParent(const entt::registry &registry, entt::entity entity)
+{
+    const RelationshipComponent *relationship = registry.try_get<RelationshipComponent>(entity);
+    return relationship ? relationship->parent : entt::null;
+}
+
+bool IsDescendantOf(const entt::registry &registry, entt::entity entity, entt::entity ancestor)
+{
+    for (entt::entity current = GetParent(registry, entity); current != entt::null; current = GetParent(registry, current))
+    {
+        if (current == ancestor)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DetachRelationship(entt::registry &registry, entt::entity entity)
+{
+    RelationshipComponent &relationship = registry.get<RelationshipComponent>(entity);
+    Unlink(registry, entity, relationship);
+
+    entt::entity child = relationship.firstChild;
+    while (child != entt::null)
+    {
+        RelationshipComponent &childRelationship = registry.get<RelationshipComponent>(child);
+        entt::entity next = childRelationship.nextSibling;
+        childRelationship.parent = entt::null;
+        childRelationship.prevSibling = entt::null;
+        childRelationship.nextSibling = entt::null;
+        child = next;
+    }
+    relationship.firstChild = entt::null;
+    relationship.lastChild = entt::null;
+    relationship.childCount = 0;
+}
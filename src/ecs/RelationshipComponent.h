@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <entt.hpp>
+
+// Parent/child links of the scene hierarchy. Children form a doubly linked list through their
+// sibling links, so walking, inserting and removing children never scans the registry, and the
+// parent keeps both ends so appending a child is constant time.
+// Change it only through SetParent(), which keeps both sides of every link consistent.
+struct RelationshipComponent
+{
+    entt::entity parent = entt::null;
+    entt::entity firstChild = entt::null;
+    entt::entity lastChild = entt::null;
+    entt::entity prevSibling = entt::null;
+    entt::entity nextSibling = entt::null;
+    uint32_t childCount = 0;
+};
+
+// Moves child to the end of parent's children, or makes it a root when parent is null.
+// Returns false, leaving the hierarchy untouched, if parent is child itself or one of its descendants.
+bool SetParent(entt::registry &registry, entt::entity child, entt::entity parent);
+
+// Parent of the entity, or null for roots
+entt::entity GetParent(const entt::registry &registry, entt::entity entity);
+
+// True if ancestor is the entity's parent, grandparent, ...
+bool IsDescendantOf(const entt::registry &registry, entt::entity entity, entt::entity ancestor);
+
+// Unlinks the entity from its parent and turns its children into roots. Connected to
+// on_destroy<RelationshipComponent> so destroying an entity never leaves dangling links.
+void DetachRelationship(entt::registry &registry, entt::entity entity);
+
+// Calls func(child) for each direct child in order; func must not reparent the children it visits
+template <typename Func>
+void ForEachChild(const entt::registry &registry, entt::entity entity, Func func)
+{
+    const RelationshipComponent *relationship = registry.try_get<RelationshipComponent>(entity);
+    entt::entity child = relationship ? relationship->firstChild : entt::null;
+    while (child != entt::null)
+    {
+        entt::entity next = registry.get<RelationshipComponent>(child).nextSibling;
+        func(child);
+        child = next;
+    }
+}
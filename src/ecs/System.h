@@ -1,9 +1,106 @@
 #pragma once
 #include <entt.hpp>
+#include <vector>
+
+class CommandBuffer;
+
+// Component types a system touches, used by SystemManager to decide what may run concurrently
+struct SystemAccess
+{
+    std::vector<entt::id_type> reads;
+    std::vector<entt::id_type> writes;
+    bool exclusive = true; // Access unknown: the system runs alone
+
+    // True if running both systems at the same time could race
+    bool ConflictsWith(const SystemAccess &other) const
+    {
+        if (exclusive || other.exclusive)
+        {
+            return true;
+        }
+        for (entt::id_type written : writes)
+        {
+            for (entt::id_type type : other.reads)
+                if (type == written)
+                    return true;
+            for (entt::id_type type : other.writes)
+                if (type == written)
+                    return true;
+        }
+        for (entt::id_type written : other.writes)
+        {
+            for (entt::id_type type : reads)
+                if (type == written)
+                    return true;
+        }
+        return false;
+    }
+};
 
 class System
 {
 public:
     virtual ~System() = default;
     virtual void Tick(entt::registry &registry, float deltaTime) = 0; // Pass registry reference to Tick
+
+    // Names the system's profiler zone; the profiler keeps only the pointer, so return a literal
+    virtual const char *GetName() const { return "System"; }
+
+    // Systems that do not declare their access are treated as touching everything
+    virtual const SystemAccess &GetAccess() const
+    {
+        static const SystemAccess unknown;
+        return unknown;
+    }
+
+    // Creates the storages the system uses; called on the main thread before systems run in parallel,
+    // since creating a storage modifies the registry itself
+    virtual void AssurePools(entt::registry &) const {}
+
+    // Set by SystemManager. Entities and components must not be created or removed during Tick;
+    // record such changes here instead, through commands->GetWriter(sortKey). They are applied
+    // once every system has ticked.
+    void SetCommandBuffer(CommandBuffer *buffer) { commands = buffer; }
+
+protected:
+    CommandBuffer *commands = nullptr;
+};
+
+template <typename... Components>
+struct Reads
+{
+};
+
+template <typename... Components>
+struct Writes
+{
+};
+
+// Base for systems that declare their component access, e.g.
+//   class MovementSystem : public AccessSystem<Reads<VelocityComponent>, Writes<TransformComponent>>
+// Tick must only touch the listed components; systems whose accesses do not conflict run concurrently.
+template <typename ReadList, typename WriteList>
+class AccessSystem;
+
+template <typename... ReadComponents, typename... WriteComponents>
+class AccessSystem<Reads<ReadComponents...>, Writes<WriteComponents...>> : public System
+{
+public:
+    AccessSystem()
+    {
+        access.reads = {entt::type_hash<ReadComponents>::value()...};
+        access.writes = {entt::type_hash<WriteComponents>::value()...};
+        access.exclusive = false;
+    }
+
+    const SystemAccess &GetAccess() const override { return access; }
+
+    void AssurePools(entt::registry &registry) const override
+    {
+        (registry.storage<ReadComponents>(), ...);
+        (registry.storage<WriteComponents>(), ...);
+    }
+
+private:
+    SystemAccess access;
 };
@@ -0,0 +1,109 @@
+#include "SystemManager.h"
+#include "../core/Profiler.h"
+
+void SystemManager::AddSystem(std::shared_ptr<System> system)
+{
+    systems.push_back(system);
+    graphDirty = true;
+}
+
+void SystemManager::BuildGraph()
+{
+    size_t count = systems.size();
+    dependencies.assign(count, std::vector<size_t>());
+    anyParallel = false;
+
+    for (size_t later = 0; later < count; later++)
+    {
+        const SystemAccess &access = systems[later]->GetAccess();
+        for (size_t earlier = 0; earlier < later; earlier++)
+        {
+            if (access.ConflictsWith(systems[earlier]->GetAccess()))
+            {
+                dependencies[later].push_back(earlier);
+            }
+            else
+            {
+                anyParallel = true;
+            }
+        }
+    }
+    graphDirty = false;
+}
+
+void SystemManager::TickAllSystems(entt::registry &registry, float deltaTime)
+{
+    PROFILE_SCOPE("SystemManager::TickAllSystems");
+    if (graphDirty)
+    {
+        BuildGraph();
+    }
+
+    // Storage creation modifies the registry, so it has to happen before any worker runs
+    for (auto &system : systems)
+    {
+        system->AssurePools(registry);
+    }
+
+    JobSystem *const *jobSystem = registry.ctx().find<JobSystem *>();
+
+    // Systems added since the last tick get their command buffer
+    while (commandBuffers.size() < systems.size())
+    {
+        commandBuffers.push_back(std::make_unique<CommandBuffer>(jobSystem ? *jobSystem : nullptr));
+        systems[commandBuffers.size() - 1]->SetCommandBuffer(commandBuffers.back().get());
+    }
+
+    if (!anyParallel || !jobSystem || !*jobSystem)
+    {
+        for (auto &system : systems)
+        {
+            PROFILE_SCOPE(system->GetName());
+            system->Tick(registry, deltaTime);
+        }
+        PlaybackCommands(registry);
+        return;
+    }
+
+    // Each system becomes a job that starts once the systems it conflicts with are done
+    JobSystem &jobs = **jobSystem;
+    handles.resize(systems.size());
+    for (size_t index = 0; index < systems.size(); index++)
+    {
+        waitFor.clear();
+        for (size_t dependency : dependencies[index])
+        {
+            waitFor.push_back(handles[dependency]);
+        }
+        System *system = systems[index].get();
+        handles[index] = jobs.Schedule([system, &registry, deltaTime]
+                                       {
+                                           PROFILE_SCOPE(system->GetName());
+                                           system->Tick(registry, deltaTime);
+                                       },
+                                       waitFor);
+    }
+
+    for (const JobHandle &handle : handles)
+    {
+        jobs.Wait(handle);
+    }
+    handles.clear();
+    waitFor.clear();
+
+    PlaybackCommands(registry);
+}
+
+void SystemManager::PlaybackCommands(entt::registry &registry)
+{
+    PROFILE_SCOPE("SystemManager::PlaybackCommands");
+    // Registration order, so the outcome does not depend on which systems happened to overlap
+    for (auto &buffer : commandBuffers)
+    {
+        buffer->Playback(registry);
+    }
+    if (CommandBuffer *shared = registry.ctx().find<CommandBuffer>())
+    {
+        shared->Playback(registry);
+    }
+}
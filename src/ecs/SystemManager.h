@@ -3,23 +3,45 @@
 #include <memory>
 #include <entt.hpp>
 #include "System.h" // Include the System header file
+#include "CommandBuffer.h"
+#include "../core/JobSystem.h"
 
+// Runs the registered systems once per tick.
+//
+// Systems keep their registration order wherever their component accesses conflict: a system
+// depends on every earlier system it conflicts with. Everything else is free to run at the same
+// time on the JobSystem found in the registry context (registry.ctx().get<JobSystem *>());
+// without one, systems tick serially on the calling thread.
+//
+// Registry signals (on_update etc.) fire on the worker running the system that triggered them.
+//
+// Structural changes go through command buffers: each system records into its own, and after the
+// tick they are played back in registration order, followed by the CommandBuffer in the registry
+// context if there is one (registry.ctx().get<CommandBuffer>(), for the editor and other code).
 class SystemManager
 {
 public:
-    void AddSystem(std::shared_ptr<System> system)
-    {
-        systems.push_back(system);
-    }
-
-    void TickAllSystems(entt::registry &registry, float deltaTime)
-    {
-        for (auto &system : systems)
-        {
-            system->Tick(registry, deltaTime);
-        }
-    }
+    void AddSystem(std::shared_ptr<System> system);
+
+    void TickAllSystems(entt::registry &registry, float deltaTime);
+
+    // Applies everything recorded in the command buffers; TickAllSystems ends with it, call it
+    // directly to apply commands while no systems tick, e.g. while paused
+    void PlaybackCommands(entt::registry &registry);
+
+    size_t GetSystemCount() const { return systems.size(); }
 
 private:
+    void BuildGraph();
+
     std::vector<std::shared_ptr<System>> systems;
+    std::vector<std::unique_ptr<CommandBuffer>> commandBuffers; // One per system, same order
+
+    // Dependency DAG, rebuilt when systems are added
+    std::vector<std::vector<size_t>> dependencies; // Earlier systems each system waits for
+    bool graphDirty = false;
+    bool anyParallel = false; // At least two systems may overlap
+
+    std::vector<JobHandle> handles; // Reused between ticks
+    std::vector<JobHandle> waitFor;
 };
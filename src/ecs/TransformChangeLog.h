@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include <entt.hpp>
+
+// Entities whose TransformComponent was written in bulk without patch(), e.g. by a parallel
+// system that cannot emit signals from its workers. TransformHierarchy registers one in the
+// registry context and marks the listed entities dirty on its next update.
+struct TransformChangeLog
+{
+    std::vector<entt::entity> entities;
+
+    void Append(const entt::entity *first, size_t count)
+    {
+        entities.insert(entities.end(), first, first + count);
+    }
+
+    void Clear() { entities.clear(); }
+};
@@ -0,0 +1,256 @@
+#include "TransformHierarchy.h"
+#include "TransformChangeLog.h"
+#include "RelationshipComponent.h"
+#include "../core/JobSystem.h"
+#include "../core/Profiler.h"
+#include <algorithm>
+#include <gtc/quaternion.hpp>
+
+namespace
+{
+    // Levels smaller than this are not worth splitting into jobs
+    const size_t MinEntitiesPerJob = 1024;
+}
+
+TransformHierarchy::TransformHierarchy(entt::registry &registry)
+    : registry(registry), pass(0), minDirtyDepth(0), anyDirty(true), structureChanged(true)
+{
+    registry.ctx().emplace<TransformChangeLog>();
+    registry.on_construct<TransformComponent>().connect<&TransformHierarchy::OnTransformConstructed>(*this);
+    registry.on_update<TransformComponent>().connect<&TransformHierarchy::OnTransformUpdated>(*this);
+    registry.on_destroy<TransformComponent>().connect<&TransformHierarchy::OnTransformDestroyed>(*this);
+    registry.on_construct<RelationshipComponent>().connect<&TransformHierarchy::OnRelationshipChanged>(*this);
+    registry.on_update<RelationshipComponent>().connect<&TransformHierarchy::OnRelationshipChanged>(*this);
+    registry.on_destroy<RelationshipComponent>().connect<&TransformHierarchy::OnRelationshipChanged>(*this);
+
+    // Entities that existed before the hierarchy was created
+    for (entt::entity entity : registry.view<TransformComponent>(entt::exclude<WorldTransformComponent>))
+    {
+        registry.emplace<WorldTransformComponent>(entity);
+    }
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+    registry.on_construct<TransformComponent>().disconnect<&TransformHierarchy::OnTransformConstructed>(*this);
+    registry.on_update<TransformComponent>().disconnect<&TransformHierarchy::OnTransformUpdated>(*this);
+    registry.on_destroy<TransformComponent>().disconnect<&TransformHierarchy::OnTransformDestroyed>(*this);
+    registry.on_construct<RelationshipComponent>().disconnect<&TransformHierarchy::OnRelationshipChanged>(*this);
+    registry.on_update<RelationshipComponent>().disconnect<&TransformHierarchy::OnRelationshipChanged>(*this);
+    registry.on_destroy<RelationshipComponent>().disconnect<&TransformHierarchy::OnRelationshipChanged>(*this);
+    registry.ctx().erase<TransformChangeLog>();
+}
+
+void TransformHierarchy::OnTransformConstructed(entt::registry &registry, entt::entity entity)
+{
+    registry.emplace_or_replace<WorldTransformComponent>(entity);
+    structureChanged = true;
+}
+
+void TransformHierarchy::OnTransformUpdated(entt::registry &, entt::entity entity)
+{
+    MarkDirty(entity);
+}
+
+void TransformHierarchy::OnTransformDestroyed(entt::registry &registry, entt::entity entity)
+{
+    // Children of the entity become roots on the next rebuild
+    registry.remove<WorldTransformComponent>(entity);
+    structureChanged = true;
+}
+
+void TransformHierarchy::OnRelationshipChanged(entt::registry &, entt::entity)
+{
+    structureChanged = true;
+}
+
+void TransformHierarchy::MarkDirty(entt::entity entity)
+{
+    WorldTransformComponent &world = registry.get<WorldTransformComponent>(entity);
+    world.dirty = true;
+    anyDirty = true;
+    minDirtyDepth = std::min(minDirtyDepth, world.depth);
+}
+
+entt::entity TransformHierarchy::GetTransformParent(entt::entity entity) const
+{
+    // A parent without a transform does not place its children; they count as roots
+    entt::entity parent = GetParent(registry, entity);
+    return parent != entt::null && registry.all_of<WorldTransformComponent>(parent) ? parent : entt::null;
+}
+
+void TransformHierarchy::Assign(entt::entity entity, entt::entity parent, uint32_t depth)
+{
+    WorldTransformComponent &world = registry.get<WorldTransformComponent>(entity);
+    world.dirty |= world.parent != parent;
+    world.parent = parent;
+    world.depth = depth;
+}
+
+void TransformHierarchy::Rebuild()
+{
+    auto &worlds = registry.storage<WorldTransformComponent>();
+
+    // Breadth-first from the roots along the child links, which yields the entities level by level
+    order.clear();
+    levelStarts.assign(1, 0);
+    for (auto [entity, world] : worlds.each())
+    {
+        if (GetTransformParent(entity) == entt::null)
+        {
+            Assign(entity, entt::null, 0);
+            order.push_back(entity);
+        }
+    }
+
+    size_t levelBegin = 0;
+    uint32_t depth = 0;
+    while (levelBegin < order.size())
+    {
+        size_t levelEnd = order.size();
+        levelStarts.push_back(levelEnd);
+        depth++;
+        for (size_t i = levelBegin; i < levelEnd; i++)
+        {
+            entt::entity parent = order[i];
+            ForEachChild(registry, parent, [&](entt::entity child)
+                         {
+                if (registry.all_of<WorldTransformComponent>(child))
+                {
+                    Assign(child, parent, depth);
+                    order.push_back(child);
+                } });
+        }
+        levelBegin = levelEnd;
+    }
+}
+
+bool TransformHierarchy::Update(JobSystem *jobs)
+{
+    PROFILE_SCOPE("TransformHierarchy::Update");
+    changed.clear();
+
+    if (TransformChangeLog *log = registry.ctx().find<TransformChangeLog>())
+    {
+        for (entt::entity entity : log->entities)
+        {
+            if (registry.valid(entity) && registry.all_of<WorldTransformComponent>(entity))
+            {
+                MarkDirty(entity);
+            }
+        }
+        log->Clear();
+    }
+
+    if (structureChanged)
+    {
+        Rebuild();
+        structureChanged = false;
+        anyDirty = true;
+        minDirtyDepth = 0;
+    }
+
+    if (!anyDirty)
+    {
+        return false;
+    }
+
+    pass++;
+    const uint32_t currentPass = pass;
+    auto &worlds = registry.storage<WorldTransformComponent>();
+    auto &transforms = registry.storage<TransformComponent>();
+
+    // An entity is recomputed when it was edited or its parent was recomputed earlier in this pass
+    auto updateRange = [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            entt::entity entity = order[i];
+            WorldTransformComponent &world = worlds.get(entity);
+            const WorldTransformComponent *parent = world.parent != entt::null ? &worlds.get(world.parent) : nullptr;
+            if (!world.dirty && !(parent && parent->updatePass == currentPass))
+            {
+                continue;
+            }
+
+            glm::mat4 local = transforms.get(entity).GetMatrix();
+            world.matrix = parent ? parent->matrix * local : local;
+            if (world.updatePass == 0)
+            {
+                world.previousMatrix = world.matrix; // New entities do not fly in from the origin
+            }
+            world.dirty = false;
+            world.updatePass = currentPass;
+        }
+    };
+
+    for (size_t level = minDirtyDepth; level + 1 < levelStarts.size(); level++)
+    {
+        size_t first = levelStarts[level];
+        size_t last = levelStarts[level + 1];
+        if (jobs)
+        {
+            size_t grainSize = std::max(MinEntitiesPerJob, (last - first) / (jobs->GetThreadCount() * 4));
+            jobs->ParallelFor(first, last, updateRange, grainSize);
+        }
+        else
+        {
+            updateRange(first, last);
+        }
+    }
+
+    for (size_t i = levelStarts[std::min<size_t>(minDirtyDepth, levelStarts.size() - 1)]; i < order.size(); i++)
+    {
+        if (worlds.get(order[i]).updatePass == currentPass)
+        {
+            changed.push_back(order[i]);
+        }
+    }
+
+    moved.insert(moved.end(), changed.begin(), changed.end());
+
+    anyDirty = false;
+    minDirtyDepth = NoDirtyDepth;
+    return !changed.empty();
+}
+
+void TransformHierarchy::SavePreviousMatrices()
+{
+    auto &worlds = registry.storage<WorldTransformComponent>();
+    for (entt::entity entity : moved)
+    {
+        if (worlds.contains(entity))
+        {
+            WorldTransformComponent &world = worlds.get(entity);
+            world.previousMatrix = world.matrix;
+        }
+    }
+    moved.clear();
+}
+
+glm::mat4 InterpolateWorldMatrix(const glm::mat4 &from, const glm::mat4 &to, float alpha)
+{
+    glm::vec3 fromScale(glm::length(glm::vec3(from[0])), glm::length(glm::vec3(from[1])), glm::length(glm::vec3(from[2])));
+    glm::vec3 toScale(glm::length(glm::vec3(to[0])), glm::length(glm::vec3(to[1])), glm::length(glm::vec3(to[2])));
+
+    // A collapsed axis has no rotation to extract; blending the matrices is the best that can be done
+    const float epsilon = 1e-6f;
+    if (glm::min(glm::min(fromScale.x, fromScale.y), fromScale.z) < epsilon ||
+        glm::min(glm::min(toScale.x, toScale.y), toScale.z) < epsilon)
+    {
+        return from + (to - from) * alpha;
+    }
+
+    glm::quat fromRotation = glm::quat_cast(glm::mat3(glm::vec3(from[0]) / fromScale.x, glm::vec3(from[1]) / fromScale.y,
+                                                      glm::vec3(from[2]) / fromScale.z));
+    glm::quat toRotation = glm::quat_cast(glm::mat3(glm::vec3(to[0]) / toScale.x, glm::vec3(to[1]) / toScale.y,
+                                                    glm::vec3(to[2]) / toScale.z));
+    glm::vec3 scale = glm::mix(fromScale, toScale, alpha);
+
+    glm::mat4 result = glm::mat4_cast(glm::slerp(fromRotation, toRotation, alpha));
+    result[0] *= scale.x;
+    result[1] *= scale.y;
+    result[2] *= scale.z;
+    result[3] = glm::vec4(glm::mix(glm::vec3(from[3]), glm::vec3(to[3]), alpha), 1.0f);
+    return result;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm.hpp>
+#include <entt.hpp>
+#include "MovementSystem.h"
+
+class JobSystem;
+
+// Cached world matrix of an entity with a TransformComponent, kept up to date by TransformHierarchy.
+// Everything that places geometry in the world (rendering, culling, the BVH, the gizmo) reads this
+// instead of rebuilding the matrix from the local transform.
+struct WorldTransformComponent
+{
+    glm::mat4 matrix = glm::mat4(1.0f);
+    glm::mat4 previousMatrix = glm::mat4(1.0f); // Matrix before the last simulation step, for render interpolation
+    entt::entity parent = entt::null; // Parent the matrix was composed with; null for roots
+    uint32_t depth = 0;               // Number of ancestors
+    uint32_t updatePass = 0;          // Last TransformHierarchy pass that recomputed the matrix
+    bool dirty = true;                // Local transform changed since the last pass
+};
+
+// World matrix of the entity's parent, or identity for roots
+inline glm::mat4 GetParentWorldMatrix(const entt::registry &registry, entt::entity entity)
+{
+    const WorldTransformComponent *world = registry.try_get<WorldTransformComponent>(entity);
+    const WorldTransformComponent *parent = world && world->parent != entt::null && registry.valid(world->parent)
+                                                ? registry.try_get<WorldTransformComponent>(world->parent)
+                                                : nullptr;
+    return parent ? parent->matrix : glm::mat4(1.0f);
+}
+
+// Blends two world matrices for rendering between simulation steps: translation and scale are
+// interpolated linearly, rotation spherically
+glm::mat4 InterpolateWorldMatrix(const glm::mat4 &from, const glm::mat4 &to, float alpha);
+
+// Maintains WorldTransformComponent for every entity with a TransformComponent, parented through
+// RelationshipComponent.
+//
+// Edits are tracked through the TransformComponent signals (use patch()/replace(), not plain
+// writes) and the TransformChangeLog in the registry context for bulk writers. When the hierarchy
+// changes, the entities are re-ordered breadth-first along the child links. Update() then walks
+// them one depth level at a time so every parent is final before its children read it, and
+// recomputes only dirty entities and the subtrees below them. Entities of a level never depend on
+// each other, so each level is split across the job system.
+class TransformHierarchy
+{
+public:
+    explicit TransformHierarchy(entt::registry &registry);
+    ~TransformHierarchy();
+
+    TransformHierarchy(const TransformHierarchy &) = delete;
+    TransformHierarchy &operator=(const TransformHierarchy &) = delete;
+
+    // Brings every world matrix up to date; returns true if any of them changed
+    bool Update(JobSystem *jobs);
+
+    // Entities whose world matrix was recomputed by the last Update()
+    const std::vector<entt::entity> &GetChangedEntities() const { return changed; }
+
+    // Call before each simulation step: the current matrices of everything that moved since the
+    // last call become the previous ones, the start point of render interpolation
+    void SavePreviousMatrices();
+
+    // True if some entity's previous and current matrix differ, i.e. interpolation has an effect
+    bool HasMotion() const { return !moved.empty(); }
+
+private:
+    static const uint32_t NoDirtyDepth = std::numeric_limits<uint32_t>::max();
+
+    void OnTransformConstructed(entt::registry &registry, entt::entity entity);
+    void OnTransformUpdated(entt::registry &registry, entt::entity entity);
+    void OnTransformDestroyed(entt::registry &registry, entt::entity entity);
+    void OnRelationshipChanged(entt::registry &registry, entt::entity entity);
+    void MarkDirty(entt::entity entity);
+    void Rebuild();
+    void Assign(entt::entity entity, entt::entity parent, uint32_t depth);
+    entt::entity GetTransformParent(entt::entity entity) const;
+
+    entt::registry &registry;
+    std::vector<entt::entity> order;      // Entities sorted by depth
+    std::vector<size_t> levelStarts;      // Offset of each depth level in order, plus the end
+    std::vector<entt::entity> changed;
+    std::vector<entt::entity> moved;      // Changed since the last SavePreviousMatrices()
+    uint32_t pass;
+    uint32_t minDirtyDepth;               // Shallowest level that has to be visited
+    bool anyDirty;
+    bool structureChanged;                // Entities added, removed or reparented
+};
@@ -9,7 +9,11 @@
 #include <nanosvgrast.h>
 #include <GL/gl.h>
 #include <vector>
-#include <iostream>
+#include "../core/Log.h"
+#include "../core/Profiler.h"
+#include <cfloat>
+#include <algorithm>
+#include <cctype>
 #include "../camera/camera.h"
 #include <gtc/type_ptr.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
@@ -18,6 +22,9 @@
 #include <GLFW/glfw3.h>
 #include "../ecs/MovementSystem.h"
 #include "../ecs/NameComponent.h"
+#include "../ecs/RelationshipComponent.h"
+#include "../ecs/CommandBuffer.h"
+#include "../ecs/TransformHierarchy.h"
 #include <json.hpp>
 
 // Icons
@@ -30,37 +37,44 @@
 #include "icons/arrow_up.h"
 #include "icons/import_arrow.h"
 
-GLuint folderIconTextureID;
-GLuint textFileIconTextureID;
-GLuint pngFileIconTextureID;
-GLuint jpgFileIconTextureID;
-GLuint attachmentIconTextureID;
-GLuint arrowUpIconTextureID;
-GLuint importArrowIconTextureID;
-
 void ScrollCallback(GLFWwindow *window, double xoffset, double yoffset)
 {
     GUIManager *guiManager = static_cast<GUIManager *>(glfwGetWindowUserPointer(window));
     guiManager->camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-GLuint LoadTextureFromSVG(const std::string &svgData)
+// Case-insensitive substring test used by the outline search
+static bool ContainsIgnoreCase(const std::string &text, const std::string &pattern)
+{
+    auto it = std::search(text.begin(), text.end(), pattern.begin(), pattern.end(), [](char a, char b)
+                          { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); });
+    return it != text.end() || pattern.empty();
+}
+
+// Rasterizes the SVG once; later requests for the same key share the texture
+TextureHandle LoadTextureFromSVG(TextureManager &textures, const std::string &key, const std::string &svgData)
 {
+    TextureHandle resident = textures.Find(key);
+    if (resident)
+    {
+        return resident;
+    }
+
     // Parse the SVG from the provided data
     NSVGimage *image = nsvgParse((char *)svgData.c_str(), "px", 96.0f);
     if (!image)
     {
-        std::cerr << "Failed to parse SVG data." << std::endl;
-        return 0; // Return 0 on failure
+        LOG_ERROR(LogCategory::Editor, "Failed to parse SVG data.");
+        return TextureHandle();
     }
 
     // Create a rasterizer
     NSVGrasterizer *rast = nsvgCreateRasterizer();
     if (!rast)
     {
-        std::cerr << "Failed to create rasterizer." << std::endl;
+        LOG_ERROR(LogCategory::Editor, "Failed to create rasterizer.");
         nsvgDelete(image);
-        return 0;
+        return TextureHandle();
     }
 
     int width = (int)image->width;
@@ -76,37 +90,30 @@ GLuint LoadTextureFromSVG(const std::string &svgData)
     nsvgDeleteRasterizer(rast);
     nsvgDelete(image);
 
-    // Generate an OpenGL texture
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap.data());
-
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Unbind the texture
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return textureID;
+    // Icons are drawn at their own size, so no mipmaps
+    TextureDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.mipmaps = false;
+    desc.repeat = false;
+    return textures.Create(key, desc, bitmap.data());
 }
 
 void GUIManager::InitializeIcons()
 {
-    folderIconTextureID = LoadTextureFromSVG(folder_icon_svg);
-    textFileIconTextureID = LoadTextureFromSVG(text_icon_svg);
-    pngFileIconTextureID = LoadTextureFromSVG(png_icon_svg);
-    jpgFileIconTextureID = LoadTextureFromSVG(jpg_icon_svg);
-    attachmentIconTextureID = LoadTextureFromSVG(attachment_icon_svg);
-    arrowUpIconTextureID = LoadTextureFromSVG(arrow_up_icon_svg);
-    importArrowIconTextureID = LoadTextureFromSVG(import_arrow_icon_svg);
+    TextureManager &textures = *FindTextureManager(*registry);
+    folderIcon = LoadTextureFromSVG(textures, "icon:folder", folder_icon_svg);
+    textFileIcon = LoadTextureFromSVG(textures, "icon:text", text_icon_svg);
+    pngFileIcon = LoadTextureFromSVG(textures, "icon:png", png_icon_svg);
+    jpgFileIcon = LoadTextureFromSVG(textures, "icon:jpg", jpg_icon_svg);
+    attachmentIcon = LoadTextureFromSVG(textures, "icon:attachment", attachment_icon_svg);
+    arrowUpIcon = LoadTextureFromSVG(textures, "icon:arrow_up", arrow_up_icon_svg);
+    importArrowIcon = LoadTextureFromSVG(textures, "icon:import_arrow", import_arrow_icon_svg);
 }
 
 GUIManager::GUIManager()
-    : camera(glm::vec3(0.0f, 5.0f, 15.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f), firstMouse(true), lastX(400), lastY(300), currentTransformMode(TransformMode::TRANSLATE), objectSelected(false)
+    : camera(glm::vec3(0.0f, 5.0f, 15.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f), firstMouse(true), lastX(400), lastY(300), currentTransformMode(TransformMode::TRANSLATE), objectSelected(false),
+      viewportRenderScale(1.0f), viewportPos(0.0f), viewportSize(0.0f)
 {
     isPlaying = false;
     // Adjust the camera's initial position and orientation to better view the grid
@@ -117,7 +124,7 @@ GUIManager::GUIManager()
 
 GUIManager::~GUIManager()
 {
-    delete scene; // Clean up the scen
+    // The scene is owned and deleted by the Engine
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -129,10 +136,7 @@ void GUIManager::ApplyTransformation(glm::mat4 viewMatrix, glm::mat4 projectionM
     {
         ImGuizmo::SetOrthographic(false);
         ImGuizmo::SetDrawlist();
-
-        ImVec2 windowPos = ImGui::GetWindowPos();
-        ImVec2 windowSize = ImGui::GetWindowSize();
-        ImGuizmo::SetRect(windowPos.x, windowPos.y, windowSize.x, windowSize.y);
+        ImGuizmo::SetRect(viewportPos.x, viewportPos.y, viewportSize.x, viewportSize.y);
 
         ImGuizmo::OPERATION operation = ImGuizmo::TRANSLATE;
         if (currentTransformMode == TransformMode::TRANSLATE)
@@ -145,25 +149,30 @@ void GUIManager::ApplyTransformation(glm::mat4 viewMatrix, glm::mat4 projectionM
         // Accessing the TransformComponent from the registry
         if (registry->valid(selectedEntity))
         {
-            auto &transform = registry->get<TransformComponent>(selectedEntity);
-            selectedObjectTransform = glm::translate(glm::mat4(1.0f), transform.position) *
-                                      glm::rotate(glm::mat4(1.0f), glm::radians(transform.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
-                                      glm::rotate(glm::mat4(1.0f), glm::radians(transform.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
-                                      glm::rotate(glm::mat4(1.0f), glm::radians(transform.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f)) *
-                                      glm::scale(glm::mat4(1.0f), transform.scale);
+            // The gizmo works on the cached world matrix; edits are mapped back into the parent's space
+            const WorldTransformComponent *world = registry->try_get<WorldTransformComponent>(selectedEntity);
+            selectedObjectTransform = world ? world->matrix : registry->get<TransformComponent>(selectedEntity).GetMatrix();
 
             ImGuizmo::Manipulate(glm::value_ptr(viewMatrix), glm::value_ptr(projectionMatrix),
                                  operation, ImGuizmo::LOCAL, glm::value_ptr(selectedObjectTransform));
 
-            // Update the entity's transform component
-            glm::vec3 translation, rotation, scale;
-            ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(selectedObjectTransform),
-                                                  glm::value_ptr(translation),
-                                                  glm::value_ptr(rotation),
-                                                  glm::value_ptr(scale));
-            transform.position = translation;
-            transform.rotation = rotation;
-            transform.scale = scale;
+            if (ImGuizmo::IsUsing())
+            {
+                // Update the entity's transform component
+                glm::mat4 local = glm::inverse(GetParentWorldMatrix(*registry, selectedEntity)) * selectedObjectTransform;
+                glm::vec3 translation, rotation, scale;
+                ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(local),
+                                                      glm::value_ptr(translation),
+                                                      glm::value_ptr(rotation),
+                                                      glm::value_ptr(scale));
+
+                // Patch so the transform hierarchy and the scene BVH pick up the edit
+                registry->patch<TransformComponent>(selectedEntity, [&](TransformComponent &edited)
+                                                    {
+                    edited.position = translation;
+                    edited.rotation = rotation;
+                    edited.scale = scale; });
+            }
         }
     }
 }
@@ -198,17 +207,7 @@ bool GUIManager::Initialize(Window *window)
 
 void GUIManager::NewFrame(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 {
-    int screenWidth, screenHeight;
-    glfwGetFramebufferSize(glfwGetCurrentContext(), &screenWidth, &screenHeight);
-    float aspectRatio = static_cast<float>(screenWidth) / static_cast<float>(screenHeight);
-
-    // Set the viewport to cover the entire window
-    glGetIntegerv(GL_VIEWPORT, viewport);
-
-    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
-
-    // Correct the near and far plane values
-    // glm::mat4 projectionMatrix = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
+    PROFILE_SCOPE("GUIManager::NewFrame");
 
     // Start a new ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
@@ -217,8 +216,6 @@ void GUIManager::NewFrame(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 
     // Editor GUI - Interface for the game engine
     RenderEditorGUI(viewMatrix, projectionMatrix);
-    glViewport(viewport[0], viewport[1], screenWidth, screenHeight);
-    glScissor(scissorBox[0], scissorBox[1], screenWidth, screenHeight);
     // Render ImGui
     ImGui::Render();
 }
@@ -262,6 +259,14 @@ void GUIManager::RenderEditorGUI(glm::mat4 viewMatrix, glm::mat4 projectionMatri
         engine->SetPlaying(false);
     }
 
+    // Imports running in the background, one bar each
+    for (const AssetImporter::Progress &progress : scene->GetImporter().GetProgress())
+    {
+        std::string label = std::filesystem::path(progress.path).filename().string() + ": " + progress.stage;
+        ImGui::SameLine();
+        ImGui::ProgressBar(progress.fraction, ImVec2(200, 0), label.c_str());
+    }
+
     ImGui::End();
 
     // 3. Main area with resizable panels
@@ -353,6 +358,7 @@ void GUIManager::CreateNewProject()
 
         // Notify the user
         ImGui::OpenPopup("Project Created");
+        OpenAssetDatabase(projectDir);
 
         // You can create the scenes directory and main scene file here as well
         std::filesystem::create_directory(projectDir + "/scenes");
@@ -367,11 +373,11 @@ void GUIManager::CreateNewProject()
     }
     else if (result == NFD_CANCEL)
     {
-        std::cout << "User canceled." << std::endl;
+        LOG_DEBUG(LogCategory::Editor, "User canceled.");
     }
     else
     {
-        std::cerr << "Error: " << NFD_GetError() << std::endl;
+        LOG_ERROR(LogCategory::Editor, "File dialog error: {}", NFD_GetError());
     }
 }
 
@@ -395,25 +401,28 @@ void GUIManager::OpenProject()
             file >> projectJson;
             file.close();
 
+            // Cooked assets first, so the scene's models load from the cache
+            OpenAssetDatabase(std::filesystem::path(projectFilePath).parent_path().string());
+
             // Open the main scene specified in the .ege file
             std::string mainScenePath = projectJson["main_scene"];
-            LoadScene(mainScenePath); // Implement this function to load the scene
+            LoadScene(mainScenePath);
 
             // Notify the user
             ImGui::OpenPopup("Project Loaded");
         }
         else
         {
-            std::cerr << "Failed to open project file." << std::endl;
+            LOG_ERROR(LogCategory::Editor, "Failed to open project file.");
         }
     }
     else if (result == NFD_CANCEL)
     {
-        std::cout << "User canceled." << std::endl;
+        LOG_DEBUG(LogCategory::Editor, "User canceled.");
     }
     else
     {
-        std::cerr << "Error: " << NFD_GetError() << std::endl;
+        LOG_ERROR(LogCategory::Editor, "File dialog error: {}", NFD_GetError());
     }
 }
 
@@ -424,11 +433,58 @@ void GUIManager::SaveProject()
     // This could involve writing any unsaved changes to scenes, objects, etc.
 }
 
+void GUIManager::OpenAssetDatabase(const std::string &projectDirectory)
+{
+    assetDatabase = std::make_unique<AssetDatabase>(projectDirectory);
+    scene->GetImporter().SetImportedCallback([this](const std::string &path, bool succeeded)
+                                             {
+                                                 if (assetDatabase)
+                                                 {
+                                                     assetDatabase->OnImported(path, succeeded);
+                                                 } });
+
+    // Only what changed goes through Assimp again; everything else is loaded from the cache on use
+    std::vector<std::string> outdated = assetDatabase->FindOutdated();
+    for (const std::string &source : outdated)
+    {
+        AssetImportOptions options;
+        options.cookedPath = assetDatabase->GetCookedPath(source);
+        options.textureCacheDirectory = assetDatabase->GetCacheDirectory();
+        options.cookOnly = true;
+        if (!options.cookedPath.empty())
+        {
+            scene->GetImporter().ImportAsync(source, options);
+        }
+    }
+    size_t removed = assetDatabase->RemoveUnusedCookedFiles();
+    LOG_INFO(LogCategory::Assets, "Project assets: {} to re-cook, {} unused cooked files removed", outdated.size(), removed);
+}
+
 // Function to load a scene from a file path
 void GUIManager::LoadScene(const std::string &scenePath)
 {
-    // Implement logic to load the scene from the .escn file
-    // This would include reading the file and creating objects, components, etc.
+    // Scene paths and the models they reference are relative to the project
+    std::filesystem::path projectDirectory = assetDatabase ? assetDatabase->GetProjectDirectory() : std::string();
+    std::ifstream file(projectDirectory / scenePath);
+    nlohmann::json sceneJson = nlohmann::json::parse(file, nullptr, false);
+    if (!file.is_open() || !sceneJson.is_object())
+    {
+        LOG_ERROR(LogCategory::Editor, "Failed to load scene: {}", scenePath);
+        return;
+    }
+
+    // Objects that name a model are imported like models added by hand, so unchanged ones load
+    // from the project's cooked files
+    size_t models = 0;
+    for (const nlohmann::json &object : sceneJson.value("objects", nlohmann::json::array()))
+    {
+        if (object.is_object() && object.contains("model") && object["model"].is_string())
+        {
+            AddAssetToScene((projectDirectory / object["model"].get<std::string>()).string());
+            models++;
+        }
+    }
+    LOG_INFO(LogCategory::Editor, "Scene loaded: {} ({} models)", scenePath, models);
 }
 
 void GUIManager::RenderOutlinePanel()
@@ -437,64 +493,228 @@ void GUIManager::RenderOutlinePanel()
     {
         ImGui::Text("Outline");
 
-        // Render all entities in the scene
-        registry->view<TransformComponent>().each([&](auto entity, TransformComponent &transform)
-                                                  {
-            if (transform.parent == entt::null) // Check if the entity is at the root
+        ImGui::SetNextItemWidth(-1.0f);
+        if (ImGui::InputTextWithHint("##OutlineFilter", "Search", outlineFilter, sizeof(outlineFilter)))
+        {
+            outlineRowsDirty = true;
+        }
+
+        if (outlineRowsDirty || outlineRevision != scene->GetHierarchyRevision())
+        {
+            RebuildOutlineRows();
+        }
+
+        // Only the rows inside the scrolled region are submitted to ImGui
+        ImGui::BeginChild("OutlineRows", ImVec2(0, 0), false);
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(outlineRows.size()));
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
             {
-                RenderEntityNode(entity, transform);
-            } });
+                RenderOutlineRow(outlineRows[row]);
+            }
+        }
+        clipper.End();
+
+        // Dropping below the tree detaches the entity from its parent
+        ImVec2 freeSpace = ImGui::GetContentRegionAvail();
+        ImGui::Dummy(ImVec2(std::max(freeSpace.x, 1.0f), std::max(freeSpace.y, ImGui::GetTextLineHeight())));
+        if (ImGui::BeginDragDropTarget())
+        {
+            if (const ImGuiPayload *payload = ImGui::AcceptDragDropPayload("REORDER_ENTITY"))
+            {
+                pendingReparent = {*(const entt::entity *)payload->Data, entt::null};
+            }
+            ImGui::EndDragDropTarget();
+        }
+        ImGui::EndChild();
     }
     ImGui::EndChild();
+
+    // Applied after the rows were drawn so the list does not change while it is being walked
+    if (pendingReparent.entity != entt::null)
+    {
+        if (registry->valid(pendingReparent.entity) &&
+            (pendingReparent.parent == entt::null || registry->valid(pendingReparent.parent)) &&
+            !SetParent(*registry, pendingReparent.entity, pendingReparent.parent))
+        {
+            LOG_WARN(LogCategory::Editor, "Cannot parent an entity to itself or one of its descendants");
+        }
+        pendingReparent = PendingReparent();
+    }
 }
 
-void GUIManager::RenderEntityNode(entt::entity entity, TransformComponent &transform)
+void GUIManager::RebuildOutlineRows()
 {
-    // Ensure NameComponent exists before accessing it
-    if (registry->all_of<NameComponent>(entity))
-    {
-        auto &name = registry->get<NameComponent>(entity).name;
+    outlineRowsDirty = false;
+    outlineRevision = scene->GetHierarchyRevision();
+    outlineRows.clear();
 
-        ImGuiTreeNodeFlags flags = ((selectedEntity == entity) ? ImGuiTreeNodeFlags_Selected : 0);
-        flags |= ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth;
+    std::string filter = outlineFilter;
+    if (!filter.empty())
+    {
+        // Typing more characters only narrows the previous matches, so rescan those alone
+        bool narrowing = !outlineFilterText.empty() && filter.find(outlineFilterText) != std::string::npos &&
+                         outlineFilterRevision == outlineRevision;
+        std::vector<entt::entity> candidates;
+        if (narrowing)
+        {
+            candidates.swap(outlineMatches);
+        }
+        else
+        {
+            auto named = registry->view<TransformComponent, NameComponent>();
+            candidates.assign(named.begin(), named.end());
+        }
 
-        bool opened = ImGui::TreeNodeEx((void *)(intptr_t)entity, flags, name.c_str());
+        outlineMatches.clear();
+        for (entt::entity entity : candidates)
+        {
+            if (registry->valid(entity) && ContainsIgnoreCase(registry->get<NameComponent>(entity).name, filter))
+            {
+                outlineMatches.push_back(entity);
+                outlineRows.push_back({entity, 0});
+            }
+        }
+        outlineFilterText = filter;
+        outlineFilterRevision = outlineRevision;
+        return;
+    }
+    outlineFilterText.clear();
+    outlineMatches.clear();
 
-        if (ImGui::IsItemClicked())
+    // Depth-first over the expanded part of the hierarchy; collapsed subtrees are never visited
+    std::vector<OutlineRow> stack;
+    for (entt::entity entity : registry->view<TransformComponent>())
+    {
+        if (GetParent(*registry, entity) == entt::null)
         {
-            selectedEntity = entity;
+            stack.push_back({entity, 0});
         }
+    }
+    std::reverse(stack.begin(), stack.end());
 
-        if (ImGui::BeginDragDropSource())
+    std::vector<entt::entity> children;
+    while (!stack.empty())
+    {
+        OutlineRow row = stack.back();
+        stack.pop_back();
+
+        // Unnamed entities are hidden together with their subtree
+        if (!registry->all_of<NameComponent>(row.entity))
         {
-            ImGui::SetDragDropPayload("REORDER_ENTITY", &entity, sizeof(entt::entity));
-            ImGui::Text("Reparent %s", name.c_str());
-            ImGui::EndDragDropSource();
+            continue;
         }
+        outlineRows.push_back(row);
 
-        if (ImGui::BeginDragDropTarget())
+        if (expandedEntities.count(row.entity))
         {
-            if (const ImGuiPayload *payload = ImGui::AcceptDragDropPayload("REORDER_ENTITY"))
+            children.clear();
+            ForEachChild(*registry, row.entity, [&](entt::entity child)
+                         { children.push_back(child); });
+            for (auto it = children.rbegin(); it != children.rend(); ++it)
             {
-                entt::entity droppedEntity = *(const entt::entity *)payload->Data;
-                registry->get<TransformComponent>(droppedEntity).parent = entity;
+                stack.push_back({*it, row.depth + 1});
             }
-            ImGui::EndDragDropTarget();
         }
+    }
+}
 
+void GUIManager::RenderOutlineRow(const OutlineRow &row)
+{
+    entt::entity entity = row.entity;
+    if (!registry->valid(entity) || !registry->all_of<NameComponent>(entity))
+    {
+        return;
+    }
+
+    auto &name = registry->get<NameComponent>(entity).name;
+    const RelationshipComponent *relationship = registry->try_get<RelationshipComponent>(entity);
+    bool hasChildren = relationship && relationship->childCount > 0;
+    bool expanded = expandedEntities.count(entity) > 0;
+
+    // Rows are flat, so the tree's indentation is applied by hand and nodes never push onto the ID stack
+    float indent = row.depth * ImGui::GetStyle().IndentSpacing;
+    if (indent > 0.0f)
+    {
+        ImGui::Indent(indent);
+    }
+
+    ImGuiTreeNodeFlags flags = ((selectedEntity == entity) ? ImGuiTreeNodeFlags_Selected : 0);
+    flags |= ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    if (!hasChildren || outlineFilter[0] != '\0')
+    {
+        flags |= ImGuiTreeNodeFlags_Leaf;
+    }
+
+    ImGui::SetNextItemOpen(expanded);
+    bool opened = ImGui::TreeNodeEx((void *)(intptr_t)entity, flags, "%s", name.c_str());
+    if (hasChildren && opened != expanded)
+    {
         if (opened)
         {
-            // Render children
-            registry->view<TransformComponent>().each([&](auto childEntity, TransformComponent &childTransform)
-                                                      {
-                if (childTransform.parent == entity) {
-                    RenderEntityNode(childEntity, childTransform);
-                } });
+            expandedEntities.insert(entity);
+        }
+        else
+        {
+            expandedEntities.erase(entity);
+        }
+        outlineRowsDirty = true;
+    }
 
-            ImGui::TreePop();
+    if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen())
+    {
+        selectedEntity = entity;
+    }
+
+    // Recorded rather than applied: the registry may only change at the simulation's sync point
+    if (ImGui::BeginPopupContextItem())
+    {
+        CommandBuffer *commands = registry->ctx().find<CommandBuffer>();
+        if (ImGui::MenuItem("Create Child", nullptr, false, commands != nullptr))
+        {
+            CommandBuffer::Writer writer = commands->GetWriter();
+            PendingEntity child = writer.Create();
+            writer.Emplace<TransformComponent>(child);
+            writer.Emplace<NameComponent>(child, "Entity");
+            writer.SetParent(child, entity);
+            expandedEntities.insert(entity);
+            outlineRowsDirty = true;
         }
+        if (ImGui::MenuItem("Delete", nullptr, false, commands != nullptr))
+        {
+            commands->GetWriter().Destroy(entity);
+            if (selectedEntity == entity)
+            {
+                selectedEntity = entt::null;
+            }
+        }
+        ImGui::EndPopup();
+    }
+
+    if (ImGui::BeginDragDropSource())
+    {
+        ImGui::SetDragDropPayload("REORDER_ENTITY", &entity, sizeof(entt::entity));
+        ImGui::Text("Reparent %s", name.c_str());
+        ImGui::EndDragDropSource();
+    }
+
+    if (ImGui::BeginDragDropTarget())
+    {
+        if (const ImGuiPayload *payload = ImGui::AcceptDragDropPayload("REORDER_ENTITY"))
+        {
+            pendingReparent = {*(const entt::entity *)payload->Data, entity};
+        }
+        ImGui::EndDragDropTarget();
+    }
+
+    if (indent > 0.0f)
+    {
+        ImGui::Unindent(indent);
     }
 }
+
 void GUIManager::RenderMainEditorPanel(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 {
     ImGui::BeginChild("Main Editor", ImVec2(0, 0), true);
@@ -517,28 +737,40 @@ void GUIManager::RenderMainEditorPanel(glm::mat4 viewMatrix, glm::mat4 projectio
                 {
                     currentTransformMode = TransformMode::SCALE;
                 } // Render the transform buttons
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120.0f);
+                ImGui::SliderFloat("Render scale", &viewportRenderScale, 0.5f, 1.0f, "%.2f");
+
+                const RenderStats &stats = renderer->GetStats();
+                ImGui::Text("Draws: %u / %u  Culled: %u  State changes: %u (skipped %u)", stats.drawCalls, stats.submitted,
+                            stats.culled, stats.StateChanges(), stats.redundantSkipped);
 
-                // Ensure the grid is rendered within the ImGui window
-                Render3DGrid(viewMatrix, projectionMatrix);
+                // The viewport fills the rest of the tab; grid, gizmo and picking all share its rectangle
+                ImVec2 imagePos = ImGui::GetCursorScreenPos();
+                ImVec2 imageSize = ImGui::GetContentRegionAvail();
+                viewportPos = glm::vec2(imagePos.x, imagePos.y);
+                viewportSize = glm::vec2(std::max(imageSize.x, 1.0f), std::max(imageSize.y, 1.0f));
 
-                // Debug: Check if the scene is being rendered
-                std::cout << "Rendering Scene" << std::endl;
+                // Project with the panel's aspect ratio rather than the window's
+                glm::mat4 viewportProjection = camera.GetProjectionMatrix(viewportSize.x, viewportSize.y);
 
-                ImVec2 windowPos = ImGui::GetWindowPos();
-                ImVec2 windowSize = ImGui::GetWindowSize();
-                // Set the viewport to the current ImGui window size and position
-                glViewport(static_cast<GLsizei>(windowPos.x), static_cast<GLsizei>(windowPos.y),
-                           static_cast<GLsizei>(windowSize.x), static_cast<GLsizei>(windowSize.y));
+                RenderSceneViewport(viewMatrix, viewportProjection);
 
-                // Set the scissor box to match the current ImGui window
-                glScissor(static_cast<GLsizei>(windowPos.x), static_cast<GLsizei>(windowPos.y),
-                          static_cast<GLsizei>(windowSize.x), static_cast<GLsizei>(windowSize.y));
+                // GL textures start at the bottom row, so flip V
+                ImGui::Image((ImTextureID)(intptr_t)viewportFramebuffer.GetColorTexture(), ImVec2(viewportSize.x, viewportSize.y),
+                             ImVec2(0, 1), ImVec2(1, 0));
+                bool viewportHovered = ImGui::IsItemHovered();
 
-                // Render the scene
-                renderer->Render(scene, viewMatrix, projectionMatrix);
+                Render3DGrid(viewMatrix, viewportProjection);
 
                 // Apply transformations to the selected object
-                ApplyTransformation(viewMatrix, projectionMatrix);
+                ApplyTransformation(viewMatrix, viewportProjection);
+
+                // Click in the viewport (but not on the gizmo) to select what is under the cursor
+                if (viewportHovered && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !ImGuizmo::IsOver())
+                {
+                    PickEntity(viewMatrix, viewportProjection);
+                }
 
                 ImGui::EndTabItem();
             }
@@ -555,12 +787,60 @@ void GUIManager::RenderMainEditorPanel(glm::mat4 viewMatrix, glm::mat4 projectio
                 }
                 ImGui::EndTabItem();
             }
+
+            if (ImGui::BeginTabItem("Profiler"))
+            {
+                RenderProfilerPanel();
+                ImGui::EndTabItem();
+            }
+
+            if (ImGui::BeginTabItem("Textures"))
+            {
+                RenderTexturesPanel();
+                ImGui::EndTabItem();
+            }
             ImGui::EndTabBar();
         }
     }
     ImGui::EndChild();
 }
 
+void GUIManager::RenderSceneViewport(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
+    int width = std::max(1, static_cast<int>(viewportSize.x * viewportRenderScale));
+    int height = std::max(1, static_cast<int>(viewportSize.y * viewportRenderScale));
+    bool resized = viewportFramebuffer.Resize(width, height);
+
+    // Drawn later by DrawFrame; ImGui only records the texture, not its contents. Scene changes
+    // are checked there too, once the snapshot holds the edits made while building the editor.
+    viewportState.visible = true;
+    if (!resized && viewMatrix == viewportState.viewMatrix && projectionMatrix == viewportState.projectionMatrix)
+    {
+        return;
+    }
+    viewportState.viewMatrix = viewMatrix;
+    viewportState.projectionMatrix = projectionMatrix;
+    viewportState.pending = true;
+}
+
+void GUIManager::PickEntity(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
+    // Same rectangle the gizmo and grid are laid out in
+    ImVec2 mouse = ImGui::GetMousePos();
+
+    float ndcX = 2.0f * (mouse.x - viewportPos.x) / viewportSize.x - 1.0f;
+    float ndcY = 1.0f - 2.0f * (mouse.y - viewportPos.y) / viewportSize.y;
+
+    glm::mat4 inverseViewProjection = glm::inverse(projectionMatrix * viewMatrix);
+    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+    RaycastHit hit;
+    selectedEntity = scene->Pick(origin, direction, hit) ? hit.entity : entt::null;
+}
+
 void GUIManager::RenderDetailsPanel()
 {
     ImGui::BeginChild("Details", ImVec2(0, 0), true);
@@ -572,6 +852,159 @@ void GUIManager::RenderDetailsPanel()
     ImGui::EndChild();
 }
 
+void GUIManager::RenderTexturesPanel()
+{
+    TextureManager &textures = *FindTextureManager(*registry);
+    TextureManager::Stats stats = textures.GetStats();
+    ImGui::Text("%zu textures, %.1f MB (peak %.1f MB), %zu requests shared a resident texture", stats.textures,
+                stats.bytes / (1024.0 * 1024.0), stats.peakBytes / (1024.0 * 1024.0), stats.sharedHits);
+
+    if (ImGui::BeginTable("ResidentTextures", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, 32.0f);
+        ImGui::TableSetupColumn("Texture");
+        ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 90.0f);
+        ImGui::TableSetupColumn("Memory", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+        ImGui::TableSetupColumn("References", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+        ImGui::TableHeadersRow();
+
+        for (const TextureManager::Resident &texture : textures.GetResidentTextures())
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Image((void *)(intptr_t)texture.id, ImVec2(24.0f, 24.0f));
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(texture.key.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%d x %d", texture.width, texture.height);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f MB", texture.bytes / (1024.0 * 1024.0));
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", texture.references);
+        }
+        ImGui::EndTable();
+    }
+}
+
+void GUIManager::RenderProfilerPanel()
+{
+#if !EGE_PROFILE
+    ImGui::TextDisabled("Profiling is compiled out; build with EGE_PROFILE=1 to enable it.");
+#else
+    bool paused = Profiler::IsPaused();
+    if (ImGui::Checkbox("Pause", &paused))
+    {
+        Profiler::SetPaused(paused);
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160.0f);
+    ImGui::SliderInt("Frames", &profilerFrameCount, 1, static_cast<int>(Profiler::GetHistorySize()));
+    ImGui::SameLine();
+    if (ImGui::Button("Save Trace"))
+    {
+        Profiler::WriteChromeTrace("profile_trace.json");
+    }
+
+    const std::deque<ProfileFrame> &frames = Profiler::GetFrames();
+    if (frames.empty())
+    {
+        ImGui::Text("No frames recorded yet.");
+        return;
+    }
+
+    profilerFrameTimes.clear();
+    float slowest = 0.0f;
+    for (const ProfileFrame &frame : frames)
+    {
+        profilerFrameTimes.push_back(static_cast<float>(frame.end - frame.start) / 1e6f);
+        slowest = std::max(slowest, profilerFrameTimes.back());
+    }
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "Frame: %.2f ms (max %.2f)", profilerFrameTimes.back(), slowest);
+    ImGui::PlotLines("##FrameTimes", profilerFrameTimes.data(), static_cast<int>(profilerFrameTimes.size()), 0, overlay, 0.0f,
+                     FLT_MAX, ImVec2(-1.0f, 50.0f));
+
+    size_t firstFrame = frames.size() - std::min<size_t>(profilerFrameCount, frames.size());
+    int64_t begin = frames[firstFrame].start;
+    double span = static_cast<double>(std::max<int64_t>(frames.back().end - begin, 1));
+
+    // One lane per thread that recorded zones, as deep as its deepest zone
+    std::vector<std::string> threadNames = Profiler::GetThreadNames();
+    std::vector<int> laneDepth(threadNames.size(), -1);
+    for (size_t i = firstFrame; i < frames.size(); i++)
+    {
+        for (const ProfileFrame::Zone &zone : frames[i].zones)
+        {
+            laneDepth[zone.thread] = std::max<int>(laneDepth[zone.thread], zone.depth);
+        }
+    }
+
+    ImGui::BeginChild("FlameGraph");
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+
+    std::vector<float> laneTop(threadNames.size(), 0.0f);
+    float y = origin.y;
+    for (size_t thread = 0; thread < threadNames.size(); thread++)
+    {
+        if (laneDepth[thread] < 0)
+        {
+            continue;
+        }
+        drawList->AddText(ImVec2(origin.x, y), IM_COL32(200, 200, 200, 255), threadNames[thread].c_str());
+        laneTop[thread] = y + rowHeight;
+        y += rowHeight * (laneDepth[thread] + 2) + 4.0f;
+    }
+
+    auto toX = [&](int64_t time)
+    {
+        return origin.x + static_cast<float>(static_cast<double>(time - begin) / span * width);
+    };
+
+    for (size_t i = firstFrame; i < frames.size(); i++)
+    {
+        float x = toX(frames[i].start);
+        drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, y), IM_COL32(120, 120, 120, 255));
+    }
+
+    ImVec2 mouse = ImGui::GetMousePos();
+    const ProfileFrame::Zone *hovered = nullptr;
+    for (size_t i = firstFrame; i < frames.size(); i++)
+    {
+        for (const ProfileFrame::Zone &zone : frames[i].zones)
+        {
+            float x0 = std::max(toX(zone.start), origin.x);
+            float x1 = std::max(std::min(toX(zone.end), origin.x + width), x0 + 1.0f);
+            float y0 = laneTop[zone.thread] + zone.depth * rowHeight;
+            float y1 = y0 + rowHeight - 1.0f;
+
+            // Same name, same colour across frames and threads
+            float hue = static_cast<float>(std::hash<const void *>()(zone.name) % 360) / 360.0f;
+            drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), ImColor::HSV(hue, 0.45f, 0.75f));
+            if (x1 - x0 > 20.0f)
+            {
+                ImVec4 clip(x0, y0, x1 - 2.0f, y1);
+                drawList->AddText(nullptr, 0.0f, ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32(0, 0, 0, 255), zone.name, nullptr, 0.0f, &clip);
+            }
+            if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1)
+            {
+                hovered = &zone;
+            }
+        }
+    }
+
+    ImGui::Dummy(ImVec2(width, y - origin.y));
+    if (hovered && ImGui::IsWindowHovered())
+    {
+        ImGui::SetTooltip("%s\n%.3f ms", hovered->name, static_cast<double>(hovered->end - hovered->start) / 1e6);
+    }
+    ImGui::EndChild();
+#endif
+}
+
 void GUIManager::RenderApplicationGUI()
 {
     // Application GUI - This is where the game itself would be rendered
@@ -582,16 +1015,12 @@ void GUIManager::RenderApplicationGUI()
 void GUIManager::Render3DGrid(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
 {
     ImGuizmo::SetDrawlist();
-    ImVec2 windowPos = ImGui::GetWindowPos();
-    ImVec2 windowSize = ImGui::GetWindowSize();
-    ImGuizmo::SetRect(windowPos.x, windowPos.y, windowSize.x, windowSize.y);
+    ImGuizmo::SetRect(viewportPos.x, viewportPos.y, viewportSize.x, viewportSize.y);
 
     glm::mat4 identity = glm::mat4(1.0f);
 
     ImGuizmo::BeginFrame();
-    glDisable(GL_DEPTH_TEST);
     ImGuizmo::DrawGrid(glm::value_ptr(viewMatrix), glm::value_ptr(projectionMatrix), glm::value_ptr(identity), 100.0f);
-    glEnable(GL_DEPTH_TEST);
 }
 
 void GUIManager::ProcessInput(GLFWwindow *window, float deltaTime)
@@ -637,14 +1066,30 @@ void GUIManager::ProcessInput(GLFWwindow *window, float deltaTime)
     }
 }
 
-void GUIManager::Render(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+void GUIManager::BuildFrame(glm::mat4 viewMatrix, glm::mat4 projectionMatrix, const RenderSnapshot &snapshot)
+{
+    frameSnapshot = &snapshot;
+    NewFrame(viewMatrix, projectionMatrix); // This will call RenderEditorGUI
+}
+
+void GUIManager::DrawFrame()
 {
+    PROFILE_SCOPE("GUIManager::DrawFrame");
+
+    // The last image is still valid unless the camera, the scene or the target size changed
+    if (viewportState.visible && (viewportState.pending || frameSnapshot->sceneRevision != viewportState.sceneRevision))
+    {
+        viewportFramebuffer.Bind();
+        renderer->Render(*frameSnapshot, viewportState.viewMatrix, viewportState.projectionMatrix);
+        viewportFramebuffer.Unbind();
+        viewportState.sceneRevision = frameSnapshot->sceneRevision;
+    }
+    viewportState.pending = false;
+    viewportState.visible = false;
+
     // Clear the framebuffer before drawing anything
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Render the 3D content (like the red cube)
-    NewFrame(viewMatrix, projectionMatrix); // This will call RenderEditorGUI, which renders the cube
-
     // Render the ImGui interface
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
@@ -675,14 +1120,14 @@ void GUIManager::RenderSources()
 
     if (!directoryStack.empty())
     {
-        if (ImGui::ImageButton((void *)(intptr_t)arrowUpIconTextureID, ImVec2(16.0f, 16.0f), ImVec2(0, 0), ImVec2(1, 1), 0, ImVec4(0, 0, 0, 0)))
+        if (ImGui::ImageButton((void *)(intptr_t)arrowUpIcon.GetId(), ImVec2(16.0f, 16.0f), ImVec2(0, 0), ImVec2(1, 1), 0, ImVec4(0, 0, 0, 0)))
         {
             currentDirectory = directoryStack.back();
             directoryStack.pop_back();
         }
     }
 
-    if (ImGui::ImageButton((void *)(intptr_t)importArrowIconTextureID, ImVec2(32.0f, 32.0f), ImVec2(0, 0), ImVec2(1, 1), 0, ImVec4(0, 0, 0, 0)))
+    if (ImGui::ImageButton((void *)(intptr_t)importArrowIcon.GetId(), ImVec2(32.0f, 32.0f), ImVec2(0, 0), ImVec2(1, 1), 0, ImVec4(0, 0, 0, 0)))
     {
         ImportAsset();
     }
@@ -707,26 +1152,26 @@ void GUIManager::RenderSources()
 
     for (const auto &item : items)
     {
-        GLuint iconTextureID = attachmentIconTextureID;
+        GLuint iconTextureID = attachmentIcon.GetId();
 
         if (item.is_directory())
         {
-            iconTextureID = folderIconTextureID;
+            iconTextureID = folderIcon.GetId();
         }
         else
         {
             std::string extension = item.path().extension().string();
             if (extension == ".txt")
             {
-                iconTextureID = textFileIconTextureID;
+                iconTextureID = textFileIcon.GetId();
             }
             else if (extension == ".png")
             {
-                iconTextureID = pngFileIconTextureID;
+                iconTextureID = pngFileIcon.GetId();
             }
             else if (extension == ".jpg" || extension == ".jpeg")
             {
-                iconTextureID = jpgFileIconTextureID;
+                iconTextureID = jpgFileIcon.GetId();
             }
         }
 
@@ -766,34 +1211,43 @@ void GUIManager::ImportAsset()
         std::string assetPath(reinterpret_cast<char *>(outPath));
         free(outPath); // Free memory allocated by NFD
 
-        AddAssetToScene(outPath);
+        AddAssetToScene(assetPath);
     }
     else if (result == NFD_CANCEL)
     {
-        std::cout << "User canceled file dialog." << std::endl;
+        LOG_DEBUG(LogCategory::Editor, "User canceled file dialog.");
     }
     else
     {
-        std::cerr << "Error: " << NFD_GetError() << std::endl;
+        LOG_ERROR(LogCategory::Editor, "File dialog error: {}", NFD_GetError());
     }
 }
 
 void GUIManager::AddAssetToScene(const std::string &assetPath)
 {
-    // Use Assimp to load the model
-    Assimp::Importer importer;
-    const aiScene *scene = importer.ReadFile(assetPath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    // Models that were already imported only need new instances of their meshes
+    if (scene->InstantiateModel(assetPath))
     {
-        std::cerr << "Error::Assimp:: " << importer.GetErrorString() << std::endl;
+        LOG_INFO(LogCategory::Assets, "Asset instanced: {}", assetPath);
         return;
     }
 
-    // Process the Assimp scene and add it to our Scene class
-    this->scene->ProcessAssimpScene(scene);
+    // Within a project the database picks the cooked file, so unchanged models skip Assimp
+    AssetImportOptions options;
+    if (assetDatabase)
+    {
+        options.textureCacheDirectory = assetDatabase->GetCacheDirectory();
+        if (std::filesystem::path(assetPath).extension() != ".emesh")
+        {
+            options.cookedPath = assetDatabase->GetCookedPath(assetPath);
+        }
+    }
 
-    std::cout << "Asset imported: " << assetPath << std::endl;
+    // The meshes appear over the next frames; the importer logs when the model is complete
+    if (!scene->GetImporter().ImportAsync(assetPath, options))
+    {
+        LOG_INFO(LogCategory::Assets, "Asset is already being imported: {}", assetPath);
+    }
 }
 
 // Create a new folder in the current working directory
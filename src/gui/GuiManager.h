@@ -3,11 +3,15 @@
 #include "../core/Window.h"
 #include "../camera/camera.h"
 #include "../core/Renderer.h"
+#include "../core/Framebuffer.h"
 #include "../scene/Scene.h"
+#include "../scene/AssetDatabase.h"
 #include "../ecs/MovementSystem.h"
 // GUIManager.h
+#include <memory>
 #include <string>
 #include <vector>
+#include <unordered_set>
 #include <glm.hpp>
 
 #include <assimp/Importer.hpp>
@@ -33,7 +37,12 @@ public:
 
     bool Initialize(Window *window);
     void NewFrame(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
-    void Render(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
+    // Builds the editor for this frame; the Scene tab draws snapshot, which may be captured again
+    // with the editor's edits before DrawFrame. Touches the registry, so no simulation step may
+    // run meanwhile.
+    void BuildFrame(glm::mat4 viewMatrix, glm::mat4 projectionMatrix, const RenderSnapshot &snapshot);
+    // Renders the Scene tab if it needs it, then the editor. Reads only the snapshot.
+    void DrawFrame();
     void ProcessInput(GLFWwindow *window, float deltaTime);
     Camera camera;
     bool firstMouse;
@@ -57,8 +66,22 @@ private:
     std::vector<Asset> assets;
     std::string selectedAsset;
     bool isPlaying;
-    GLint viewport[4];
-    GLint scissorBox[4];
+
+    // Scene tab viewport: rendered offscreen at renderScale * panel size and shown as an image
+    struct ViewportState
+    {
+        glm::mat4 viewMatrix = glm::mat4(0.0f);
+        glm::mat4 projectionMatrix = glm::mat4(0.0f);
+        uint64_t sceneRevision = 0;
+        bool pending = false; // The camera or size changed; DrawFrame redraws
+        bool visible = false; // The Scene tab was shown this frame
+    };
+    const RenderSnapshot *frameSnapshot = nullptr;
+    Framebuffer viewportFramebuffer;
+    ViewportState viewportState;
+    float viewportRenderScale;
+    glm::vec2 viewportPos;
+    glm::vec2 viewportSize;
     int screenWidth;
     int screenHeight;
     void RenderEditorGUI(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
@@ -71,13 +94,59 @@ private:
     void CreateFolder();
     void CreatePlayerController();
     void RenderMainEditorPanel(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
+    void RenderSceneViewport(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
     void RenderDetailsPanel();
+    void RenderProfilerPanel();
+    void RenderTexturesPanel(); // Resident textures and their memory
+    void PickEntity(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
     void Render3DGrid(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
     void OpenProject();
     void CreateNewProject();
     void SaveProject();
     void LoadScene(const std::string &scenePath);
+    // Opens the project's asset database and re-cooks, in the background, every source that
+    // changed since it was last cooked
+    void OpenAssetDatabase(const std::string &projectDirectory);
+    std::unique_ptr<AssetDatabase> assetDatabase; // Null until a project is open
     bool contentDrawerOpen;
     void ApplyTransformation(glm::mat4 viewMatrix, glm::mat4 projectionMatrix); // Add this method
-    void RenderEntityNode(entt::entity entity, TransformComponent &transform);
+
+    // Outline: the expanded hierarchy (or the filter matches) flattened into rows, rebuilt only when
+    // the hierarchy, the expansion state or the filter changes, and drawn through a list clipper
+    struct OutlineRow
+    {
+        entt::entity entity;
+        uint32_t depth;
+    };
+    void RebuildOutlineRows();
+    void RenderOutlineRow(const OutlineRow &row);
+    std::vector<OutlineRow> outlineRows;
+    std::unordered_set<entt::entity> expandedEntities;
+    uint64_t outlineRevision = 0;
+    bool outlineRowsDirty = true;
+    char outlineFilter[128] = "";
+    std::string outlineFilterText;            // Filter the current matches were computed for
+    std::vector<entt::entity> outlineMatches;
+    uint64_t outlineFilterRevision = 0;
+
+    // Outline drag-and-drop, applied once the tree has been drawn; a null parent makes a root
+    struct PendingReparent
+    {
+        entt::entity entity = entt::null;
+        entt::entity parent = entt::null;
+    };
+    PendingReparent pendingReparent;
+
+    // Content browser icons, shared through the texture manager
+    TextureHandle folderIcon;
+    TextureHandle textFileIcon;
+    TextureHandle pngFileIcon;
+    TextureHandle jpgFileIcon;
+    TextureHandle attachmentIcon;
+    TextureHandle arrowUpIcon;
+    TextureHandle importArrowIcon;
+
+    // Profiler tab: flame graph over the last profilerFrameCount frames
+    int profilerFrameCount = 1;
+    std::vector<float> profilerFrameTimes;
 };
@@ -0,0 +1,11 @@
+// NanoSVG's implementation for builds without the prebuilt nanosvg libraries, which only exist for
+// Windows (include/nanosvg/lib); the Windows build links those instead.
+#ifndef _WIN32
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#define NANOSVG_IMPLEMENTATION
+#include <nanosvg.h>
+#define NANOSVGRAST_IMPLEMENTATION
+#include <nanosvgrast.h>
+#endif
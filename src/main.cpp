@@ -1,10 +1,16 @@
 #include "core/Engine.h"
 
-int main()
+int main(int argc, char **argv)
 {
+    EngineOptions options;
+    if (!ParseCommandLine(argc, argv, options))
+    {
+        return -1;
+    }
+
     Engine engine;
 
-    if (!engine.Initialize())
+    if (!engine.Initialize(options))
     {
         return -1;
     }
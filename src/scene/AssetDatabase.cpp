@@ -0,0 +1,356 @@
+#include "AssetDatabase.h"
+#include "AssetImporter.h"
+#include "CookedMesh.h"
+#include "../core/Hash.h"
+#include "../core/Log.h"
+#include "../core/MappedFile.h"
+#include "../core/Profiler.h"
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+#include <json.hpp>
+
+namespace
+{
+    std::string ToHex(uint64_t value)
+    {
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016" PRIx64, value);
+        return text;
+    }
+
+    uint64_t FromHex(const std::string &text)
+    {
+        return std::strtoull(text.c_str(), nullptr, 16);
+    }
+
+    // Typed field readers: json::value() throws on a value of the wrong type, these fall back
+    std::string StringField(const nlohmann::json &entry, const char *key)
+    {
+        auto it = entry.find(key);
+        return it != entry.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    template <typename T>
+    T IntegerField(const nlohmann::json &entry, const char *key)
+    {
+        auto it = entry.find(key);
+        return it != entry.end() && it->is_number_integer() ? it->get<T>() : T(0);
+    }
+
+    // Every entry under key is an object, or key is absent
+    bool IsObjectOfObjects(const nlohmann::json &database, const char *key)
+    {
+        auto it = database.find(key);
+        if (it == database.end())
+        {
+            return true;
+        }
+        if (!it->is_object())
+        {
+            return false;
+        }
+        for (const nlohmann::json &entry : *it)
+        {
+            if (!entry.is_object())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool HasValidDependencies(const nlohmann::json &sources)
+    {
+        for (const nlohmann::json &entry : sources)
+        {
+            auto dependencies = entry.find("dependencies");
+            if (dependencies == entry.end())
+            {
+                continue;
+            }
+            if (!dependencies->is_array())
+            {
+                return false;
+            }
+            for (const nlohmann::json &dependency : *dependencies)
+            {
+                if (!dependency.is_object())
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+AssetDatabase::AssetDatabase(const std::string &projectDirectory)
+    : projectDirectory(projectDirectory)
+{
+    std::filesystem::path library = std::filesystem::path(projectDirectory) / "Library";
+    databasePath = (library / "AssetDatabase.json").string();
+    cacheDirectory = (library / "Cooked").string();
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    if (error)
+    {
+        LOG_ERROR(LogCategory::Assets, "Could not create the cooked asset cache {}: {}", cacheDirectory, error.message());
+    }
+
+    std::ifstream file(databasePath);
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    // Anything that is not the shape Save writes is ignored as a whole, so a damaged file costs a
+    // reimport instead of taking the editor down
+    nlohmann::json database = nlohmann::json::parse(file, nullptr, false);
+    if (database.is_discarded() || !database.is_object() || IntegerField<int>(database, "version") != 1 ||
+        !IsObjectOfObjects(database, "files") || !IsObjectOfObjects(database, "sources") ||
+        !HasValidDependencies(database.value("sources", nlohmann::json::object())))
+    {
+        LOG_WARN(LogCategory::Assets, "Ignoring unreadable asset database {}", databasePath);
+        return;
+    }
+
+    for (auto &[key, entry] : database["files"].items())
+    {
+        FileState &state = files[key];
+        state.size = IntegerField<uint64_t>(entry, "size");
+        state.time = IntegerField<int64_t>(entry, "time");
+        state.hash = FromHex(StringField(entry, "hash"));
+    }
+    for (auto &[key, entry] : database["sources"].items())
+    {
+        Record &record = records[key];
+        record.contentHash = FromHex(StringField(entry, "content"));
+        record.settingsHash = FromHex(StringField(entry, "settings"));
+        record.cooked = StringField(entry, "cooked");
+        for (const nlohmann::json &dependency : entry.value("dependencies", nlohmann::json::array()))
+        {
+            record.dependencies.push_back({StringField(dependency, "path"), FromHex(StringField(dependency, "hash"))});
+        }
+    }
+    LOG_INFO(LogCategory::Assets, "Asset database loaded: {} sources", records.size());
+}
+
+bool AssetDatabase::Save() const
+{
+    nlohmann::json database;
+    database["version"] = 1;
+    database["files"] = nlohmann::json::object();
+    database["sources"] = nlohmann::json::object();
+    for (const auto &[key, state] : files)
+    {
+        database["files"][key] = {{"size", state.size}, {"time", state.time}, {"hash", ToHex(state.hash)}};
+    }
+    for (const auto &[key, record] : records)
+    {
+        nlohmann::json dependencies = nlohmann::json::array();
+        for (const Dependency &dependency : record.dependencies)
+        {
+            dependencies.push_back({{"path", dependency.path}, {"hash", ToHex(dependency.hash)}});
+        }
+        database["sources"][key] = {{"content", ToHex(record.contentHash)},
+                                    {"settings", ToHex(record.settingsHash)},
+                                    {"cooked", record.cooked},
+                                    {"dependencies", dependencies}};
+    }
+
+    std::ofstream file(databasePath);
+    if (!file.is_open())
+    {
+        LOG_ERROR(LogCategory::Assets, "Could not write the asset database {}", databasePath);
+        return false;
+    }
+    file << database.dump(2);
+    return true;
+}
+
+std::string AssetDatabase::ToKey(const std::string &path) const
+{
+    std::filesystem::path absolute = std::filesystem::absolute(path).lexically_normal();
+    std::filesystem::path relative = absolute.lexically_relative(std::filesystem::absolute(projectDirectory).lexically_normal());
+    if (relative.empty() || *relative.begin() == "..")
+    {
+        return absolute.generic_string();
+    }
+    return relative.generic_string();
+}
+
+std::string AssetDatabase::ToPath(const std::string &key) const
+{
+    std::filesystem::path path(key);
+    return path.is_absolute() ? path.string() : (std::filesystem::path(projectDirectory) / path).string();
+}
+
+bool AssetDatabase::Hash(const std::string &key, uint64_t &hash)
+{
+    std::string path = ToPath(key);
+    uint64_t size;
+    int64_t time;
+    if (!GetSourceStamp(path, size, time))
+    {
+        return false;
+    }
+
+    FileState &state = files[key];
+    if (state.size != size || state.time != time || state.hash == 0)
+    {
+        PROFILE_SCOPE("AssetDatabase::Hash");
+        MappedFile file;
+        if (!file.Open(path))
+        {
+            return false;
+        }
+        state.size = size;
+        state.time = time;
+        state.hash = HashBytes(file.GetData(), file.GetSize());
+    }
+    hash = state.hash;
+    return true;
+}
+
+std::string AssetDatabase::GetCookedPath(const std::string &sourcePath)
+{
+    std::string key = ToKey(sourcePath);
+    uint64_t contentHash;
+    if (!Hash(key, contentHash))
+    {
+        return std::string();
+    }
+
+    // Same content cooked with the same settings gives the same file, whatever the source is called
+    uint64_t settingsHash = AssetImporter::GetSettingsHash();
+    const uint64_t identity[] = {contentHash, settingsHash};
+
+    Record &record = records[key];
+    record.contentHash = contentHash;
+    record.settingsHash = settingsHash;
+    record.cooked = ToHex(HashBytes(identity, sizeof(identity))) + ".emesh";
+    return (std::filesystem::path(cacheDirectory) / record.cooked).string();
+}
+
+void AssetDatabase::OnImported(const std::string &sourcePath, bool succeeded)
+{
+    auto it = records.find(ToKey(sourcePath));
+    if (it == records.end())
+    {
+        return; // Not imported through the database
+    }
+    Record &record = it->second;
+    if (!succeeded)
+    {
+        // Nothing usable was cooked; the next import tries again
+        record.cooked.clear();
+        Save();
+        return;
+    }
+
+    // The cooked model names the textures it needs, relative to the source
+    record.dependencies.clear();
+    CookedModel cooked;
+    if (cooked.Load((std::filesystem::path(cacheDirectory) / record.cooked).string()))
+    {
+        std::filesystem::path directory = std::filesystem::path(sourcePath).parent_path();
+        for (size_t i = 0; i < cooked.GetTextureCount(); i++)
+        {
+            std::string dependency = ToKey((directory / std::string(cooked.GetTexturePath(i))).string());
+            uint64_t hash = 0;
+            Hash(dependency, hash); // A missing texture keeps hash 0 and counts as changed once it appears
+            record.dependencies.push_back({dependency, hash});
+        }
+    }
+    Save();
+}
+
+std::vector<std::string> AssetDatabase::FindOutdated()
+{
+    PROFILE_SCOPE("AssetDatabase::FindOutdated");
+
+    uint64_t settingsHash = AssetImporter::GetSettingsHash();
+    std::vector<std::string> outdated;
+    for (auto &[key, record] : records)
+    {
+        uint64_t hash;
+        bool changed = !Hash(key, hash) || hash != record.contentHash || record.settingsHash != settingsHash || record.cooked.empty() ||
+                       !std::filesystem::exists(std::filesystem::path(cacheDirectory) / record.cooked);
+        for (size_t i = 0; i < record.dependencies.size() && !changed; i++)
+        {
+            uint64_t dependencyHash = 0;
+            Hash(record.dependencies[i].path, dependencyHash);
+            changed = dependencyHash != record.dependencies[i].hash;
+        }
+        if (changed)
+        {
+            outdated.push_back(ToPath(key));
+        }
+    }
+    return outdated;
+}
+
+std::vector<std::string> AssetDatabase::GetDependencies(const std::string &sourcePath) const
+{
+    std::vector<std::string> dependencies;
+    auto it = records.find(ToKey(sourcePath));
+    if (it != records.end())
+    {
+        for (const Dependency &dependency : it->second.dependencies)
+        {
+            dependencies.push_back(ToPath(dependency.path));
+        }
+    }
+    return dependencies;
+}
+
+std::vector<std::string> AssetDatabase::GetDependents(const std::string &dependencyPath) const
+{
+    std::string dependencyKey = ToKey(dependencyPath);
+    std::vector<std::string> dependents;
+    for (const auto &[key, record] : records)
+    {
+        for (const Dependency &dependency : record.dependencies)
+        {
+            if (dependency.path == dependencyKey)
+            {
+                dependents.push_back(ToPath(key));
+                break;
+            }
+        }
+    }
+    return dependents;
+}
+
+size_t AssetDatabase::RemoveUnusedCookedFiles()
+{
+    // Cooked models by name; cooked textures start with the content hash of their image
+    std::unordered_set<std::string> used;
+    std::unordered_set<std::string> usedTextures;
+    for (const auto &[key, record] : records)
+    {
+        used.insert(record.cooked);
+        for (const Dependency &dependency : record.dependencies)
+        {
+            usedTextures.insert(ToHex(dependency.hash));
+        }
+    }
+
+    size_t removed = 0;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(cacheDirectory, error))
+    {
+        std::string name = entry.path().filename().string();
+        std::string extension = entry.path().extension().string();
+        bool unused = (extension == ".emesh" && used.count(name) == 0) || (extension == ".etex" && usedTextures.count(name.substr(0, 16)) == 0);
+        if (unused && std::filesystem::remove(entry.path(), error))
+        {
+            removed++;
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Remembers what was cooked for the sources of a project, so a model is only imported with Assimp
+// again when something that decides its cooked output changed.
+//
+// Cooked files are content-addressed: each is named after the hash of its source's content and
+// the import settings, and kept in <project>/Library/Cooked, next to the cooked textures, which
+// are named after the content of their images. The database itself is
+// <project>/Library/AssetDatabase.json. For every source it records the content hash it was cooked
+// from, and the textures the cooked model references with their hashes, which forms the
+// dependency graph between models and textures. Files are only hashed again once their size or
+// write time changed.
+class AssetDatabase
+{
+public:
+    // Loads the database of the project if it has one
+    explicit AssetDatabase(const std::string &projectDirectory);
+
+    bool Save() const;
+
+    // Cooked file the source is imported through; it exists if the source was cooked before with
+    // the same content and settings. Registers the source. Empty if the source cannot be read.
+    std::string GetCookedPath(const std::string &sourcePath);
+
+    // Call once an import of the source completed: records the textures of its cooked model as
+    // dependencies and saves the database
+    void OnImported(const std::string &sourcePath, bool succeeded);
+
+    // Sources whose content, import settings or dependencies changed since they were cooked, or
+    // whose cooked file is gone
+    std::vector<std::string> FindOutdated();
+
+    // Textures a source's cooked model references, as recorded at its last import
+    std::vector<std::string> GetDependencies(const std::string &sourcePath) const;
+    // Sources referencing the texture
+    std::vector<std::string> GetDependents(const std::string &dependencyPath) const;
+
+    // Deletes cooked models no source maps to any more, and cooked textures of images no source
+    // references; returns how many were removed
+    size_t RemoveUnusedCookedFiles();
+
+    const std::string &GetProjectDirectory() const { return projectDirectory; }
+    const std::string &GetCacheDirectory() const { return cacheDirectory; }
+
+private:
+    struct FileState
+    {
+        uint64_t size = 0;
+        int64_t time = 0;
+        uint64_t hash = 0;
+    };
+
+    struct Dependency
+    {
+        std::string path; // Project-relative where possible
+        uint64_t hash;    // Content when the source was last imported
+    };
+
+    struct Record
+    {
+        uint64_t contentHash = 0;
+        uint64_t settingsHash = 0;
+        std::string cooked; // File name in the cache directory
+        std::vector<Dependency> dependencies;
+    };
+
+    // Paths are stored relative to the project where possible, so a moved project keeps its cache
+    std::string ToKey(const std::string &path) const;
+    std::string ToPath(const std::string &key) const;
+
+    // Content hash of the file, reusing the last one while size and write time are unchanged
+    bool Hash(const std::string &key, uint64_t &hash);
+
+    std::string projectDirectory;
+    std::string databasePath;
+    std::string cacheDirectory;
+    std::unordered_map<std::string, Record> records; // Sources by key
+    std::unordered_map<std::string, FileState> files; // Sources and dependencies by key
+};
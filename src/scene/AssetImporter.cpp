@@ -0,0 +1,800 @@
+#include "AssetImporter.h"
+#include "Scene.h"
+#include "Mesh.h"
+#include "CookedMesh.h"
+#include "CookedTexture.h"
+#include "../core/Hash.h"
+#include "../core/Log.h"
+#include "../core/MappedFile.h"
+#include "../core/Profiler.h"
+#include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <unordered_map>
+
+namespace
+{
+    const unsigned int PostProcessSteps = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+    enum class ImportStage
+    {
+        Parsing,
+        Converting,
+        Uploading, // Worker finished; the main thread uploads what is left
+        Failed
+    };
+
+    struct ImportedTexture
+    {
+        std::string name; // As the material names it, relative to the model
+        std::string path; // Resolved for loading
+        std::string key;  // In the texture manager
+        std::string type;
+        uint64_t contentHash = 0; // Of the image file, or of the embedded data
+
+        // Whichever form the worker produced, released after upload
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        unsigned char *pixels = nullptr;       // Uncompressed, stbi allocation
+        CompressedTexture compressed;          // Compressed by this import
+        std::unique_ptr<CookedTexture> cooked; // Mapped from an earlier cook
+        TextureHandle handle; // Found resident by the worker or created by the upload
+        std::atomic<bool> decoded{false};
+        bool uploaded = false;
+    };
+
+    struct ImportedMesh
+    {
+        std::string name;
+        unsigned int source; // Index into aiScene::mMeshes
+        uint32_t material;   // Index into the import's materials
+        MeshBounds bounds;
+
+        // Converted meshes own their arrays; cooked ones point into the mapped file
+        std::vector<Vertex> vertexStorage;
+        std::vector<unsigned int> indexStorage;
+        const Vertex *vertices = nullptr;
+        size_t vertexCount = 0;
+        const unsigned int *indices = nullptr;
+        size_t indexCount = 0;
+        std::atomic<bool> converted{false};
+    };
+
+    // Forwards Assimp's parse progress and aborts the parse when the import is cancelled
+    class ParseProgress : public Assimp::ProgressHandler
+    {
+    public:
+        ParseProgress(std::atomic<float> &fraction, const std::atomic<bool> &cancelled)
+            : fraction(fraction), cancelled(cancelled) {}
+
+        bool Update(float percentage) override
+        {
+            if (percentage >= 0.0f)
+            {
+                fraction.store(percentage, std::memory_order_relaxed);
+            }
+            return !cancelled.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<float> &fraction;
+        const std::atomic<bool> &cancelled;
+    };
+
+    void ConvertMesh(const aiMesh *mesh, ImportedMesh &imported)
+    {
+        imported.vertexStorage.resize(mesh->mNumVertices);
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+        {
+            Vertex &vertex = imported.vertexStorage[i];
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            vertex.Normal = mesh->mNormals ? glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z) : glm::vec3(0.0f);
+            vertex.TexCoords = mesh->mTextureCoords[0] ? glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y) : glm::vec2(0.0f);
+        }
+
+        imported.indexStorage.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+        {
+            const aiFace &face = mesh->mFaces[i];
+            imported.indexStorage.insert(imported.indexStorage.end(), face.mIndices, face.mIndices + face.mNumIndices);
+        }
+
+        // Bounds are computed once here and transformed to world space when culling
+        imported.bounds = MeshBounds::FromVertices(imported.vertexStorage);
+
+        imported.vertices = imported.vertexStorage.data();
+        imported.vertexCount = imported.vertexStorage.size();
+        imported.indices = imported.indexStorage.data();
+        imported.indexCount = imported.indexStorage.size();
+    }
+
+    // Decodes an image to 8-bit texels; channels 0 keeps the image's own channel count. Embedded
+    // textures are either an image file in memory or raw BGRA texels.
+    unsigned char *DecodeImage(const aiTexture *embedded, const uint8_t *data, size_t size, int channels, ImportedTexture &texture)
+    {
+        if (embedded && embedded->mHeight > 0)
+        {
+            texture.width = static_cast<int>(embedded->mWidth);
+            texture.height = static_cast<int>(embedded->mHeight);
+            texture.channels = 4;
+            size_t count = static_cast<size_t>(texture.width) * texture.height;
+            unsigned char *pixels = static_cast<unsigned char *>(STBI_MALLOC(count * 4));
+            for (size_t i = 0; i < count; i++)
+            {
+                const aiTexel &texel = embedded->pcData[i];
+                unsigned char *pixel = pixels + i * 4;
+                pixel[0] = texel.r;
+                pixel[1] = texel.g;
+                pixel[2] = texel.b;
+                pixel[3] = texel.a;
+            }
+            return pixels;
+        }
+
+        unsigned char *pixels = stbi_load_from_memory(data, static_cast<int>(size), &texture.width, &texture.height, &texture.channels, channels);
+        if (pixels && channels != 0)
+        {
+            texture.channels = channels;
+        }
+        return pixels;
+    }
+
+    // Worker side of a texture: reuses its cooked file when it matches the image, otherwise decodes
+    // the image and, unless compression is off, compresses it and writes the cooked file. scene is
+    // null for cooked models, which never reference embedded textures.
+    void PrepareTexture(const aiScene *scene, const AssetImportOptions &options, TextureCompression compression, ImportedTexture &texture)
+    {
+        // "*N" names a texture embedded in the model file
+        const aiTexture *embedded = scene ? scene->GetEmbeddedTexture(texture.path.c_str()) : nullptr;
+        MappedFile file;
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+        if (embedded)
+        {
+            data = reinterpret_cast<const uint8_t *>(embedded->pcData);
+            size = embedded->mHeight > 0 ? static_cast<size_t>(embedded->mWidth) * embedded->mHeight * sizeof(aiTexel) : embedded->mWidth;
+        }
+        else if (file.Open(texture.path))
+        {
+            data = file.GetData();
+            size = file.GetSize();
+        }
+        else
+        {
+            LOG_ERROR(LogCategory::Assets, "Texture failed to load at path: {}", texture.path);
+            return;
+        }
+        texture.contentHash = HashBytes(data, size);
+
+        // Embedded textures are compressed on every import; the model file is their only copy
+        std::string cookedPath;
+        if (compression != TextureCompression::None && !embedded)
+        {
+            cookedPath = options.textureCacheDirectory.empty()
+                             ? texture.path + ".etex"
+                             : (std::filesystem::path(options.textureCacheDirectory) / GetCookedTextureName(texture.contentHash, compression)).string();
+            auto cooked = std::make_unique<CookedTexture>();
+            if (cooked->Load(cookedPath) && cooked->IsCookedFrom(texture.contentHash) &&
+                (compression == TextureCompression::BC7) == (cooked->GetFormat() == BlockFormat::BC7))
+            {
+                if (!options.cookOnly)
+                {
+                    texture.cooked = std::move(cooked);
+                }
+                return;
+            }
+        }
+
+        unsigned char *pixels = DecodeImage(embedded, data, size, compression == TextureCompression::None ? 0 : 4, texture);
+        if (!pixels)
+        {
+            LOG_ERROR(LogCategory::Assets, "Texture failed to load at path: {}", texture.path);
+            return;
+        }
+        if (compression == TextureCompression::None)
+        {
+            texture.pixels = pixels;
+            return;
+        }
+
+        bool hasAlpha = false;
+        size_t texels = static_cast<size_t>(texture.width) * texture.height;
+        for (size_t i = 0; i < texels && !hasAlpha; i++)
+        {
+            hasAlpha = pixels[i * 4 + 3] != 255;
+        }
+        BlockFormat format = ChooseBlockFormat(compression, hasAlpha);
+        {
+            PROFILE_SCOPE("AssetImporter::CompressTexture");
+            texture.compressed = CompressTexture(pixels, texture.width, texture.height, format);
+        }
+        stbi_image_free(pixels);
+        LOG_INFO(LogCategory::Assets, "Compressed {} to {}, {} levels, PSNR {} dB", texture.path, GetFormatName(format),
+                 texture.compressed.levels.size(), texture.compressed.psnr);
+
+        if (!cookedPath.empty() && !WriteCookedTexture(cookedPath, texture.compressed, texture.contentHash))
+        {
+            LOG_WARN(LogCategory::Assets, "Could not write cooked texture: {}", cookedPath);
+        }
+        if (options.cookOnly)
+        {
+            texture.compressed = CompressedTexture();
+        }
+    }
+}
+
+struct AssetImporter::Import
+{
+    std::string path;
+    AssetImportOptions options;
+    JobHandle job;
+    std::atomic<ImportStage> stage{ImportStage::Parsing};
+    std::atomic<float> parseProgress{0.0f};
+    TextureCompression compression; // Fixed when the import starts
+    std::atomic<bool> cancelled{false};
+    std::atomic<size_t> itemsDone{0}; // Meshes converted plus textures decoded
+
+    // Written by the worker before it leaves the Parsing stage, fixed in size afterwards
+    std::unique_ptr<Assimp::Importer> importer;
+    std::unique_ptr<CookedModel> cooked; // Mapped while its meshes are uploaded
+    std::deque<ImportedTexture> textures;
+    std::deque<ImportedMesh> meshes;
+    std::vector<std::vector<uint32_t>> materials; // Texture indices of each material
+
+    // Main thread only
+    size_t nextMesh = 0; // Meshes are uploaded in file order
+    std::vector<std::shared_ptr<Mesh>> uploaded;
+};
+
+AssetImporter::AssetImporter(Scene &scene, JobSystem *jobs, TextureManager *textures)
+    : scene(scene), jobs(jobs), textures(textures), textureCompression(TextureCompression::BC), failed(false)
+{
+    if (!textures)
+    {
+        ownTextures = std::make_unique<TextureManager>();
+        this->textures = ownTextures.get();
+    }
+}
+
+AssetImporter::~AssetImporter()
+{
+    for (auto &import : imports)
+    {
+        import->cancelled = true;
+    }
+    for (auto &import : imports)
+    {
+        if (jobs)
+        {
+            jobs->Wait(import->job);
+        }
+        for (ImportedTexture &texture : import->textures)
+        {
+            stbi_image_free(texture.pixels);
+        }
+    }
+}
+
+bool AssetImporter::ImportAsync(const std::string &path, const AssetImportOptions &options)
+{
+    for (const auto &import : imports)
+    {
+        if (import->path != path)
+        {
+            continue;
+        }
+        // The running import's options are read by its worker, so a cook cannot be turned into a
+        // full import in place; the full one follows it instead
+        if (!import->options.cookOnly || options.cookOnly)
+        {
+            return false;
+        }
+        for (const auto &request : queued)
+        {
+            if (request.first == path)
+            {
+                return false;
+            }
+        }
+        queued.emplace_back(path, options);
+        return true;
+    }
+
+    imports.push_back(std::make_unique<Import>());
+    Import &import = *imports.back();
+    import.path = path;
+    import.options = options;
+    import.compression = textureCompression;
+    if (jobs)
+    {
+        // Parsing can take seconds; Background keeps it off the main thread even while it waits
+        import.job = jobs->Schedule([this, &import]
+                                    { Run(import); }, {}, JobAffinity::Background);
+    }
+    else
+    {
+        Run(import);
+    }
+    return true;
+}
+
+void AssetImporter::Run(Import &import)
+{
+    PROFILE_SCOPE("AssetImporter::Run");
+
+    bool cooked = LoadCooked(import);
+    bool isCookedFile = std::filesystem::path(import.path).extension() == ".emesh";
+    const aiScene *scene = cooked || isCookedFile ? nullptr : Parse(import);
+    if (!cooked && !scene)
+    {
+        import.stage.store(ImportStage::Failed, std::memory_order_release);
+        return;
+    }
+    import.stage.store(ImportStage::Converting, std::memory_order_release);
+
+    // Textures first: meshes are only uploaded once their textures are. Cooked meshes need no
+    // work. When only cooking, textures matter only if they are cooked too.
+    bool cookTextures = import.compression != TextureCompression::None;
+    size_t textureCount = import.options.cookOnly && !cookTextures ? 0 : import.textures.size();
+    size_t meshCount = cooked ? 0 : import.meshes.size();
+    auto convert = [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last && !import.cancelled.load(std::memory_order_relaxed); i++)
+        {
+            if (i < textureCount)
+            {
+                // Textures shared with models loaded earlier are neither decoded nor uploaded again
+                PROFILE_SCOPE("AssetImporter::PrepareTexture");
+                ImportedTexture &texture = import.textures[i];
+                if (!import.options.cookOnly)
+                {
+                    texture.handle = textures->Find(texture.key);
+                }
+                if (!texture.handle)
+                {
+                    PrepareTexture(scene, import.options, import.compression, texture);
+                }
+                texture.decoded.store(true, std::memory_order_release);
+            }
+            else
+            {
+                PROFILE_SCOPE("AssetImporter::ConvertMesh");
+                ImportedMesh &mesh = import.meshes[i - textureCount];
+                ConvertMesh(scene->mMeshes[mesh.source], mesh);
+                mesh.converted.store(true, std::memory_order_release);
+            }
+            import.itemsDone.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    if (jobs)
+    {
+        jobs->ParallelFor(0, textureCount + meshCount, convert, 1);
+    }
+    else
+    {
+        convert(0, textureCount + meshCount);
+    }
+
+    if (!cooked && !import.cancelled.load(std::memory_order_relaxed))
+    {
+        Cook(import);
+    }
+
+    // The CPU copies are all that is needed from here on
+    import.importer.reset();
+    import.stage.store(ImportStage::Uploading, std::memory_order_release);
+}
+
+const aiScene *AssetImporter::Parse(Import &import)
+{
+    const aiScene *scene = nullptr;
+    {
+        PROFILE_SCOPE("AssetImporter::Parse");
+        import.importer = std::make_unique<Assimp::Importer>();
+        import.importer->SetProgressHandler(new ParseProgress(import.parseProgress, import.cancelled)); // Owned by the importer
+        scene = import.importer->ReadFile(import.path, PostProcessSteps);
+    }
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        LOG_ERROR(LogCategory::Assets, "Assimp: {}", import.importer->GetErrorString());
+        import.importer.reset();
+        return nullptr;
+    }
+
+    // Meshes in the order the node tree references them; textures are shared between meshes and
+    // resolved next to the model file
+    std::filesystem::path directory = std::filesystem::path(import.path).parent_path();
+    std::unordered_map<std::string, uint32_t> textureIndices;
+    std::unordered_map<unsigned int, uint32_t> materialIndices;
+    std::vector<const aiNode *> nodes = {scene->mRootNode};
+    while (!nodes.empty())
+    {
+        const aiNode *node = nodes.back();
+        nodes.pop_back();
+        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        {
+            const aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+            ImportedMesh &imported = import.meshes.emplace_back();
+            imported.source = node->mMeshes[i];
+            imported.name = mesh->mName.length > 0 ? mesh->mName.C_Str() : "Mesh";
+
+            auto [materialIndex, newMaterial] = materialIndices.emplace(mesh->mMaterialIndex, static_cast<uint32_t>(import.materials.size()));
+            imported.material = materialIndex->second;
+            if (!newMaterial)
+            {
+                continue;
+            }
+
+            std::vector<uint32_t> &materialTextures = import.materials.emplace_back();
+            const aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+            for (unsigned int t = 0; t < material->GetTextureCount(aiTextureType_DIFFUSE); t++)
+            {
+                aiString name;
+                material->GetTexture(aiTextureType_DIFFUSE, t, &name);
+                auto [found, inserted] = textureIndices.emplace(name.C_Str(), static_cast<uint32_t>(import.textures.size()));
+                if (inserted)
+                {
+                    ImportedTexture &texture = import.textures.emplace_back();
+                    texture.name = name.C_Str();
+                    texture.path = name.data[0] == '*' ? texture.name : (directory / texture.name).string();
+                    texture.key = name.data[0] == '*' ? TextureManager::NormalizePath(import.path) + texture.name : TextureManager::NormalizePath(texture.path);
+                    texture.type = "texture_diffuse";
+                }
+                materialTextures.push_back(found->second);
+            }
+        }
+        // Children pushed in reverse so they are visited in order
+        for (unsigned int i = node->mNumChildren; i-- > 0;)
+        {
+            nodes.push_back(node->mChildren[i]);
+        }
+    }
+    return scene;
+}
+
+bool AssetImporter::LoadCooked(Import &import)
+{
+    PROFILE_SCOPE("AssetImporter::LoadCooked");
+
+    // A cooked file can be opened directly. A given one was checked by the caller; the one next
+    // to a model is only used while it matches the model.
+    std::string cookedPath = import.options.cookedPath;
+    bool isCookedFile = std::filesystem::path(import.path).extension() == ".emesh";
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    bool checkSource = false;
+    if (isCookedFile)
+    {
+        cookedPath = import.path;
+    }
+    else if (cookedPath.empty())
+    {
+        cookedPath = GetCookedPath(import.path);
+        checkSource = true;
+        if (!GetSourceStamp(import.path, sourceSize, sourceTime))
+        {
+            return false;
+        }
+    }
+    if (!std::filesystem::exists(cookedPath))
+    {
+        if (isCookedFile)
+        {
+            LOG_ERROR(LogCategory::Assets, "Cooked model not found: {}", cookedPath);
+        }
+        return false;
+    }
+
+    import.cooked = std::make_unique<CookedModel>();
+    if (!import.cooked->Load(cookedPath) || (checkSource && !import.cooked->IsCookedFrom(sourceSize, sourceTime)))
+    {
+        if (isCookedFile)
+        {
+            LOG_ERROR(LogCategory::Assets, "Not a valid cooked model: {}", cookedPath);
+        }
+        else
+        {
+            LOG_INFO(LogCategory::Assets, "Cooked model is out of date or unreadable, reimporting: {}", cookedPath);
+        }
+        import.cooked.reset();
+        return false;
+    }
+
+    // Texture paths are relative to the model, wherever the cooked file is kept
+    const CookedModel &cooked = *import.cooked;
+    std::filesystem::path directory = std::filesystem::path(import.path).parent_path();
+    for (size_t i = 0; i < cooked.GetTextureCount(); i++)
+    {
+        ImportedTexture &texture = import.textures.emplace_back();
+        texture.name = std::string(cooked.GetTexturePath(i));
+        texture.path = (directory / texture.name).string();
+        texture.key = TextureManager::NormalizePath(texture.path);
+        texture.type = std::string(cooked.GetTextureType(i));
+    }
+    for (size_t i = 0; i < cooked.GetMaterialCount(); i++)
+    {
+        import.materials.push_back(cooked.GetMaterialTextures(i));
+    }
+    for (size_t i = 0; i < cooked.GetSubmeshCount(); i++)
+    {
+        CookedModel::Submesh submesh = cooked.GetSubmesh(i);
+        ImportedMesh &imported = import.meshes.emplace_back();
+        imported.name = std::string(submesh.name);
+        imported.source = static_cast<unsigned int>(i);
+        imported.material = submesh.material;
+        imported.bounds = submesh.bounds;
+        imported.vertices = submesh.vertices;
+        imported.vertexCount = submesh.vertexCount;
+        imported.indices = submesh.indices;
+        imported.indexCount = submesh.indexCount;
+        imported.converted.store(true, std::memory_order_release);
+    }
+    return true;
+}
+
+void AssetImporter::Cook(Import &import)
+{
+    PROFILE_SCOPE("AssetImporter::Cook");
+
+    CookedModelDesc model;
+    for (const ImportedTexture &texture : import.textures)
+    {
+        // Embedded textures live in the model file, which a cooked load never opens
+        if (texture.name.empty() || texture.name[0] == '*')
+        {
+            return;
+        }
+        model.textures.push_back({texture.name, texture.type});
+    }
+    if (!GetSourceStamp(import.path, model.sourceSize, model.sourceTime))
+    {
+        return;
+    }
+    model.materials = import.materials;
+    for (const ImportedMesh &mesh : import.meshes)
+    {
+        model.submeshes.push_back({mesh.name, mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount, mesh.bounds, mesh.material});
+    }
+
+    std::string cookedPath = import.options.cookedPath.empty() ? GetCookedPath(import.path) : import.options.cookedPath;
+    if (WriteCookedModel(cookedPath, model))
+    {
+        LOG_INFO(LogCategory::Assets, "Cooked {}", cookedPath);
+    }
+    else
+    {
+        LOG_WARN(LogCategory::Assets, "Could not write cooked model: {}", cookedPath);
+    }
+}
+
+bool AssetImporter::Upload(Import &import, int64_t &budget, bool &uploadedAny)
+{
+    auto hasBudget = [&]()
+    {
+        return budget > 0 || !uploadedAny;
+    };
+
+    for (ImportedTexture &texture : import.textures)
+    {
+        if (!hasBudget())
+        {
+            return false;
+        }
+        if (texture.uploaded || !texture.decoded.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        if (!texture.handle)
+        {
+            PROFILE_SCOPE("AssetImporter::UploadTexture");
+            std::vector<CompressedLevel> levels = texture.cooked ? texture.cooked->GetLevels() : texture.compressed.GetLevels();
+            if (!levels.empty())
+            {
+                BlockFormat format = texture.cooked ? texture.cooked->GetFormat() : texture.compressed.format;
+                texture.handle = textures->CreateCompressed(texture.key, format, levels, texture.contentHash);
+                for (const CompressedLevel &level : levels)
+                {
+                    budget -= static_cast<int64_t>(level.size);
+                }
+                uploadedAny = true;
+            }
+            else if (texture.pixels)
+            {
+                TextureDesc desc;
+                desc.width = texture.width;
+                desc.height = texture.height;
+                desc.channels = texture.channels;
+                texture.handle = textures->Create(texture.key, desc, texture.pixels, texture.contentHash);
+                budget -= static_cast<int64_t>(texture.width) * texture.height * texture.channels;
+                uploadedAny = true;
+            }
+        }
+        stbi_image_free(texture.pixels);
+        texture.pixels = nullptr;
+        texture.compressed = CompressedTexture();
+        texture.cooked.reset();
+        texture.uploaded = true;
+    }
+
+    while (import.nextMesh < import.meshes.size() && hasBudget())
+    {
+        ImportedMesh &imported = import.meshes[import.nextMesh];
+        if (!imported.converted.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        std::vector<Texture> meshTextures;
+        for (uint32_t index : import.materials[imported.material])
+        {
+            const ImportedTexture &texture = import.textures[index];
+            if (!texture.uploaded)
+            {
+                return false;
+            }
+            if (texture.handle)
+            {
+                meshTextures.push_back({texture.handle, texture.type, texture.path});
+            }
+        }
+
+        PROFILE_SCOPE("AssetImporter::UploadMesh");
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(imported.vertices, imported.vertexCount, imported.indices, imported.indexCount,
+                                                            meshTextures, imported.bounds);
+        budget -= static_cast<int64_t>(imported.vertexCount * sizeof(Vertex) + imported.indexCount * sizeof(unsigned int));
+        uploadedAny = true;
+
+        scene.AddMesh(mesh);
+        if (import.options.instantiate)
+        {
+            scene.InstantiateMesh(mesh, imported.name);
+        }
+        import.uploaded.push_back(mesh);
+
+        // The GPU has its own copy now, but until the worker is done it may still be cooking from
+        // the CPU arrays; those are then released with the import
+        if (import.stage.load(std::memory_order_acquire) == ImportStage::Uploading)
+        {
+            imported.vertexStorage = std::vector<Vertex>();
+            imported.indexStorage = std::vector<unsigned int>();
+        }
+        import.nextMesh++;
+    }
+
+    return import.nextMesh == import.meshes.size() && import.stage.load(std::memory_order_acquire) == ImportStage::Uploading;
+}
+
+void AssetImporter::Update(size_t uploadBudget)
+{
+    PROFILE_SCOPE("AssetImporter::Update");
+
+    int64_t budget = static_cast<int64_t>(std::min<size_t>(uploadBudget, INT64_MAX));
+    bool uploadedAny = false;
+    for (size_t i = 0; i < imports.size();)
+    {
+        Import &import = *imports[i];
+        ImportStage stage = import.stage.load(std::memory_order_acquire);
+        bool done = false;
+        bool succeeded = false;
+        if (stage == ImportStage::Failed)
+        {
+            failed = true;
+            done = true;
+        }
+        else if (import.options.cookOnly)
+        {
+            done = succeeded = stage == ImportStage::Uploading;
+        }
+        else if (stage != ImportStage::Parsing && Upload(import, budget, uploadedAny))
+        {
+            scene.AddModel(import.path, import.uploaded);
+            LOG_INFO(LogCategory::Assets, "Asset imported: {} ({} meshes)", import.path, import.uploaded.size());
+            done = succeeded = true;
+        }
+
+        if (done)
+        {
+            if (jobs)
+            {
+                jobs->Wait(import.job); // Run may still be on its way out
+            }
+            std::string path = import.path;
+            imports.erase(imports.begin() + i);
+            if (onImported)
+            {
+                onImported(path, succeeded);
+            }
+
+            // Appended behind the imports still to be visited, so it is checked this frame too
+            for (size_t q = 0; q < queued.size(); q++)
+            {
+                if (queued[q].first == path)
+                {
+                    AssetImportOptions options = queued[q].second;
+                    queued.erase(queued.begin() + q);
+                    ImportAsync(path, options);
+                    break;
+                }
+            }
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+bool AssetImporter::Finish()
+{
+    // Finishing an import can start one that was queued behind it
+    while (!imports.empty())
+    {
+        for (auto &import : imports)
+        {
+            if (jobs)
+            {
+                jobs->Wait(import->job);
+            }
+        }
+        Update(SIZE_MAX);
+    }
+
+    bool succeeded = !failed;
+    failed = false;
+    return succeeded;
+}
+
+bool AssetImporter::IsImporting(const std::string &path) const
+{
+    for (const auto &import : imports)
+    {
+        if (import->path == path)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<AssetImporter::Progress> AssetImporter::GetProgress() const
+{
+    std::vector<Progress> progress;
+    for (const auto &import : imports)
+    {
+        switch (import->stage.load(std::memory_order_acquire))
+        {
+        case ImportStage::Parsing:
+            progress.push_back({import->path, "Parsing", import->parseProgress.load(std::memory_order_relaxed)});
+            break;
+        case ImportStage::Converting:
+        {
+            size_t total = import->textures.size() + import->meshes.size();
+            float fraction = total > 0 ? static_cast<float>(import->itemsDone.load(std::memory_order_relaxed)) / total : 1.0f;
+            progress.push_back({import->path, "Converting", fraction});
+            break;
+        }
+        case ImportStage::Uploading:
+        {
+            float fraction = import->meshes.empty() ? 1.0f : static_cast<float>(import->nextMesh) / import->meshes.size();
+            progress.push_back({import->path, "Uploading", fraction});
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return progress;
+}
+
+uint64_t AssetImporter::GetSettingsHash()
+{
+    const uint64_t settings[] = {PostProcessSteps, EmeshVersion, sizeof(Vertex)};
+    return HashBytes(settings, sizeof(settings));
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../core/JobSystem.h"
+#include "../core/TextureManager.h"
+
+class Scene;
+struct aiScene;
+
+struct AssetImportOptions
+{
+    // Cooked file to read or write. Empty uses the one next to the model, trusted only while the
+    // model's size and write time match; a given path was already checked by the caller, e.g. the
+    // asset database against the model's content.
+    std::string cookedPath;
+    // Cooked textures are kept here, named after the content of their images. Empty keeps each
+    // next to its image with ".etex" appended.
+    std::string textureCacheDirectory;
+    bool instantiate = true; // Create an entity per mesh as soon as it is uploaded
+    bool cookOnly = false;   // Only bring the cooked files up to date; nothing is uploaded
+};
+
+// Imports model files in the background.
+//
+// A worker parses the file with Assimp, then the meshes are converted to vertex arrays and the
+// textures decoded in parallel on the job system. The converted meshes are written to a cooked
+// .emesh file next to the model, which later imports map instead of parsing the model again.
+// Textures are block-compressed with their mip chains and cooked to .etex files the same way.
+// Only the GL uploads happen on the main thread, in Update(), which stops once the frame's upload
+// budget is spent. Each mesh gets its entity as soon as it is on the GPU, so large models fill in
+// over a few frames instead of freezing the editor.
+class AssetImporter
+{
+public:
+    // Without a job system imports run on the calling thread inside ImportAsync. Textures are shared
+    // through the given manager, or one of the importer's own without it.
+    AssetImporter(Scene &scene, JobSystem *jobs, TextureManager *textures);
+    ~AssetImporter();
+
+    AssetImporter(const AssetImporter &) = delete;
+    AssetImporter &operator=(const AssetImporter &) = delete;
+
+    // Starts importing the file; false if it is already being imported. A full import of a file
+    // that is only being cooked starts as soon as the cook is done, from the fresh cooked files.
+    bool ImportAsync(const std::string &path, const AssetImportOptions &options = AssetImportOptions());
+
+    // Main thread, once per frame while the registry may be modified. Uploads converted textures
+    // and meshes until uploadBudget bytes went to the GPU, but always at least one item, and
+    // registers finished models with the scene for instancing.
+    void Update(size_t uploadBudget);
+
+    // Blocks until every pending import is uploaded; false if any import since the last call failed
+    bool Finish();
+
+    bool IsImporting(const std::string &path) const;
+
+    // Called on the main thread whenever an import completes or fails
+    void SetImportedCallback(std::function<void(const std::string &path, bool succeeded)> callback) { onImported = std::move(callback); }
+
+    // Identifies everything besides the model's content that decides the cooked output: the
+    // Assimp post-processing steps, the cooked format version and the vertex layout
+    static uint64_t GetSettingsHash();
+
+    // Applies to imports started afterwards; BC by default
+    void SetTextureCompression(TextureCompression compression) { textureCompression = compression; }
+
+    bool IsBusy() const { return !imports.empty(); }
+
+    struct Progress
+    {
+        std::string path;
+        const char *stage;
+        float fraction; // Within the stage, 0..1
+    };
+    std::vector<Progress> GetProgress() const;
+
+private:
+    struct Import;
+
+    void Run(Import &import); // Worker side: parse or map, convert, decode
+
+    // Reads the model with Assimp and lists its meshes, materials and textures; null on failure
+    const aiScene *Parse(Import &import);
+
+    // Maps the model's cooked file instead, if there is one that matches it
+    bool LoadCooked(Import &import);
+
+    // Writes the converted meshes to the cooked file so the next import skips Assimp
+    void Cook(Import &import);
+
+    // Uploads what is ready within budget; true once the whole model is on the GPU
+    bool Upload(Import &import, int64_t &budget, bool &uploadedAny);
+
+    Scene &scene;
+    JobSystem *jobs;
+    TextureManager *textures;
+    std::unique_ptr<TextureManager> ownTextures;
+    TextureCompression textureCompression;
+    std::vector<std::unique_ptr<Import>> imports;
+    std::vector<std::pair<std::string, AssetImportOptions>> queued; // Waiting for a cook-only import of the same file
+    bool failed; // An import failed since the last Finish()
+    std::function<void(const std::string &, bool)> onImported;
+};
@@ -0,0 +1,620 @@
+#include "BVH.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace
+{
+    const int SAHBins = 12;
+    const float FatMargin = 0.1f; // Fraction of the box size added on each side of a leaf
+
+    AABB Union(const AABB &a, const AABB &b)
+    {
+        return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+    }
+
+    float SurfaceArea(const AABB &box)
+    {
+        glm::vec3 size = glm::max(box.max - box.min, glm::vec3(0.0f));
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool Encloses(const AABB &outer, const AABB &inner)
+    {
+        return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+    }
+
+    bool Overlaps(const AABB &a, const AABB &b)
+    {
+        return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+    }
+
+    AABB Fatten(const AABB &box)
+    {
+        glm::vec3 margin = (box.max - box.min) * FatMargin + glm::vec3(0.01f);
+        return {box.min - margin, box.max + margin};
+    }
+
+    float DistanceSquared(const AABB &box, const glm::vec3 &point)
+    {
+        glm::vec3 closest = glm::clamp(point, box.min, box.max);
+        glm::vec3 offset = point - closest;
+        return glm::dot(offset, offset);
+    }
+
+    // Slab test; returns the entry distance or a negative value on a miss
+    float IntersectRay(const AABB &box, const glm::vec3 &origin, const glm::vec3 &inverseDirection, float maxDistance)
+    {
+        glm::vec3 t0 = (box.min - origin) * inverseDirection;
+        glm::vec3 t1 = (box.max - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return entry <= exit ? entry : -1.0f;
+    }
+
+    enum class FrustumResult
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    FrustumResult TestFrustum(const Frustum &frustum, const AABB &box)
+    {
+        glm::vec3 center = box.GetCenter();
+        glm::vec3 extents = box.GetExtents();
+        FrustumResult result = FrustumResult::Inside;
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+            if (distance < -radius)
+            {
+                return FrustumResult::Outside;
+            }
+            if (distance < radius)
+            {
+                result = FrustumResult::Intersecting;
+            }
+        }
+        return result;
+    }
+}
+
+SceneBVH::SceneBVH() : root(Null) {}
+
+void SceneBVH::Clear()
+{
+    nodes.clear();
+    freeNodes.clear();
+    leaves.clear();
+    root = Null;
+}
+
+int SceneBVH::AllocateNode()
+{
+    if (!freeNodes.empty())
+    {
+        int index = freeNodes.back();
+        freeNodes.pop_back();
+        nodes[index] = Node();
+        return index;
+    }
+    nodes.emplace_back();
+    return static_cast<int>(nodes.size() - 1);
+}
+
+void SceneBVH::FreeNode(int index)
+{
+    nodes[index].entity = entt::null;
+    freeNodes.push_back(index);
+}
+
+void SceneBVH::Build(const std::vector<std::pair<entt::entity, AABB>> &items)
+{
+    Clear();
+    if (items.empty())
+    {
+        return;
+    }
+
+    nodes.reserve(items.size() * 2);
+    std::vector<int> leafNodes;
+    leafNodes.reserve(items.size());
+    for (const auto &item : items)
+    {
+        int leaf = AllocateNode();
+        nodes[leaf].box = Fatten(item.second);
+        nodes[leaf].tight = item.second;
+        nodes[leaf].entity = item.first;
+        leaves[item.first] = leaf;
+        leafNodes.push_back(leaf);
+    }
+
+    root = BuildRange(leafNodes, 0, leafNodes.size());
+    nodes[root].parent = Null;
+}
+
+int SceneBVH::BuildRange(std::vector<int> &leafNodes, size_t begin, size_t end)
+{
+    size_t count = end - begin;
+    if (count == 1)
+    {
+        return leafNodes[begin];
+    }
+
+    // Split along the axis where the leaf centroids are spread the most
+    AABB centroidBounds = {nodes[leafNodes[begin]].box.GetCenter(), nodes[leafNodes[begin]].box.GetCenter()};
+    for (size_t i = begin; i < end; i++)
+    {
+        glm::vec3 center = nodes[leafNodes[i]].box.GetCenter();
+        centroidBounds.min = glm::min(centroidBounds.min, center);
+        centroidBounds.max = glm::max(centroidBounds.max, center);
+    }
+    glm::vec3 spread = centroidBounds.max - centroidBounds.min;
+    int axis = (spread.x > spread.y && spread.x > spread.z) ? 0 : (spread.y > spread.z ? 1 : 2);
+
+    size_t middle = begin + count / 2;
+    if (spread[axis] > 0.0f)
+    {
+        // Bin centroids and pick the plane with the lowest surface area heuristic cost
+        struct Bin
+        {
+            AABB box;
+            size_t count = 0;
+        } bins[SAHBins];
+
+        float scale = SAHBins / spread[axis];
+        auto binOf = [&](int leaf)
+        {
+            int bin = static_cast<int>((nodes[leaf].box.GetCenter()[axis] - centroidBounds.min[axis]) * scale);
+            return std::min(bin, SAHBins - 1);
+        };
+
+        for (size_t i = begin; i < end; i++)
+        {
+            Bin &bin = bins[binOf(leafNodes[i])];
+            bin.box = bin.count == 0 ? nodes[leafNodes[i]].box : Union(bin.box, nodes[leafNodes[i]].box);
+            bin.count++;
+        }
+
+        float rightArea[SAHBins];
+        size_t rightCount[SAHBins];
+        AABB accumulated;
+        size_t accumulatedCount = 0;
+        for (int i = SAHBins - 1; i > 0; i--)
+        {
+            if (bins[i].count > 0)
+            {
+                accumulated = accumulatedCount == 0 ? bins[i].box : Union(accumulated, bins[i].box);
+                accumulatedCount += bins[i].count;
+            }
+            rightArea[i] = accumulatedCount > 0 ? SurfaceArea(accumulated) : 0.0f;
+            rightCount[i] = accumulatedCount;
+        }
+
+        float bestCost = std::numeric_limits<float>::max();
+        int bestSplit = -1;
+        accumulatedCount = 0;
+        for (int i = 0; i < SAHBins - 1; i++)
+        {
+            if (bins[i].count > 0)
+            {
+                accumulated = accumulatedCount == 0 ? bins[i].box : Union(accumulated, bins[i].box);
+                accumulatedCount += bins[i].count;
+            }
+            if (accumulatedCount == 0 || rightCount[i + 1] == 0)
+            {
+                continue;
+            }
+            float cost = SurfaceArea(accumulated) * accumulatedCount + rightArea[i + 1] * rightCount[i + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        if (bestSplit >= 0)
+        {
+            auto split = std::partition(leafNodes.begin() + begin, leafNodes.begin() + end,
+                                        [&](int leaf)
+                                        { return binOf(leaf) <= bestSplit; });
+            middle = static_cast<size_t>(split - leafNodes.begin());
+        }
+    }
+
+    // Degenerate distributions fall back to a median split
+    if (middle == begin || middle == end)
+    {
+        middle = begin + count / 2;
+        std::nth_element(leafNodes.begin() + begin, leafNodes.begin() + middle, leafNodes.begin() + end,
+                         [&](int a, int b)
+                         { return nodes[a].box.GetCenter()[axis] < nodes[b].box.GetCenter()[axis]; });
+    }
+
+    int left = BuildRange(leafNodes, begin, middle);
+    int right = BuildRange(leafNodes, middle, end);
+
+    int node = AllocateNode();
+    nodes[node].left = left;
+    nodes[node].right = right;
+    nodes[node].box = Union(nodes[left].box, nodes[right].box);
+    nodes[left].parent = node;
+    nodes[right].parent = node;
+    return node;
+}
+
+void SceneBVH::Update(entt::entity entity, const AABB &box)
+{
+    auto it = leaves.find(entity);
+    if (it == leaves.end())
+    {
+        int leaf = AllocateNode();
+        nodes[leaf].box = Fatten(box);
+        nodes[leaf].tight = box;
+        nodes[leaf].entity = entity;
+        leaves[entity] = leaf;
+        InsertLeaf(leaf);
+        return;
+    }
+
+    int leaf = it->second;
+    nodes[leaf].tight = box;
+    if (Encloses(nodes[leaf].box, box))
+    {
+        return; // Still inside the fat box, nothing to do
+    }
+
+    AABB fat = Fatten(box);
+    if (Overlaps(nodes[leaf].box, box))
+    {
+        // Moved a little: keep the tree shape and grow/shrink the ancestors in place
+        nodes[leaf].box = fat;
+        RefitAncestors(nodes[leaf].parent);
+    }
+    else
+    {
+        // Moved away: find it a better place in the tree
+        RemoveLeaf(leaf);
+        nodes[leaf].box = fat;
+        InsertLeaf(leaf);
+    }
+}
+
+void SceneBVH::Remove(entt::entity entity)
+{
+    auto it = leaves.find(entity);
+    if (it == leaves.end())
+    {
+        return;
+    }
+    RemoveLeaf(it->second);
+    FreeNode(it->second);
+    leaves.erase(it);
+}
+
+void SceneBVH::InsertLeaf(int leaf)
+{
+    if (root == Null)
+    {
+        root = leaf;
+        nodes[root].parent = Null;
+        return;
+    }
+
+    // Descend towards the sibling that grows the tree's surface area the least
+    AABB leafBox = nodes[leaf].box; // A copy: allocating the new parent may move the nodes
+    int index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        const Node &node = nodes[index];
+        float area = SurfaceArea(node.box);
+        float combinedArea = SurfaceArea(Union(node.box, leafBox));
+
+        // Cost of pairing with this node directly, and the growth pushed onto descendants
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto childCost = [&](int child)
+        {
+            float grown = SurfaceArea(Union(nodes[child].box, leafBox));
+            return nodes[child].IsLeaf() ? grown + inheritanceCost
+                                         : grown - SurfaceArea(nodes[child].box) + inheritanceCost;
+        };
+
+        float leftCost = childCost(node.left);
+        float rightCost = childCost(node.right);
+        if (cost < leftCost && cost < rightCost)
+        {
+            break;
+        }
+        index = leftCost < rightCost ? node.left : node.right;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = Union(nodes[sibling].box, leafBox);
+    nodes[newParent].left = sibling;
+    nodes[newParent].right = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == Null)
+    {
+        root = newParent;
+    }
+    else if (nodes[oldParent].left == sibling)
+    {
+        nodes[oldParent].left = newParent;
+    }
+    else
+    {
+        nodes[oldParent].right = newParent;
+    }
+
+    RefitAncestors(oldParent);
+}
+
+void SceneBVH::RemoveLeaf(int leaf)
+{
+    if (leaf == root)
+    {
+        root = Null;
+        return;
+    }
+
+    // The leaf's sibling takes the place of their shared parent
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    if (grandParent == Null)
+    {
+        root = sibling;
+        nodes[sibling].parent = Null;
+    }
+    else
+    {
+        if (nodes[grandParent].left == parent)
+        {
+            nodes[grandParent].left = sibling;
+        }
+        else
+        {
+            nodes[grandParent].right = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        RefitAncestors(grandParent);
+    }
+
+    FreeNode(parent);
+    nodes[leaf].parent = Null;
+}
+
+void SceneBVH::RefitAncestors(int index)
+{
+    while (index != Null)
+    {
+        Node &node = nodes[index];
+        node.box = Union(nodes[node.left].box, nodes[node.right].box);
+        index = node.parent;
+    }
+}
+
+void SceneBVH::QueryFrustum(const Frustum &frustum, std::vector<entt::entity> &results) const
+{
+    if (root == Null)
+    {
+        return;
+    }
+
+    // Each stack entry remembers whether its parent was already known to be fully inside
+    std::vector<std::pair<int, bool>> stack = {{root, false}};
+    while (!stack.empty())
+    {
+        auto [index, inside] = stack.back();
+        stack.pop_back();
+        const Node &node = nodes[index];
+
+        if (!inside)
+        {
+            FrustumResult result = TestFrustum(frustum, node.QueryBox());
+            if (result == FrustumResult::Outside)
+            {
+                continue;
+            }
+            inside = result == FrustumResult::Inside;
+        }
+
+        if (node.IsLeaf())
+        {
+            results.push_back(node.entity);
+        }
+        else
+        {
+            stack.push_back({node.left, inside});
+            stack.push_back({node.right, inside});
+        }
+    }
+}
+
+void SceneBVH::QueryOverlap(const AABB &box, std::vector<entt::entity> &results) const
+{
+    if (root == Null)
+    {
+        return;
+    }
+
+    std::vector<int> stack = {root};
+    while (!stack.empty())
+    {
+        int index = stack.back();
+        stack.pop_back();
+        const Node &node = nodes[index];
+        if (!Overlaps(node.QueryBox(), box))
+        {
+            continue;
+        }
+
+        if (node.IsLeaf())
+        {
+            results.push_back(node.entity);
+        }
+        else
+        {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+}
+
+bool SceneBVH::Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RaycastHit &hit,
+                       const std::function<bool(entt::entity, float &)> &filter) const
+{
+    if (root == Null)
+    {
+        return false;
+    }
+
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float closest = maxDistance;
+    bool found = false;
+
+    std::vector<std::pair<int, float>> stack;
+    float rootEntry = IntersectRay(nodes[root].QueryBox(), origin, inverseDirection, closest);
+    if (rootEntry >= 0.0f)
+    {
+        stack.push_back({root, rootEntry});
+    }
+
+    while (!stack.empty())
+    {
+        auto [index, entry] = stack.back();
+        stack.pop_back();
+        if (entry > closest)
+        {
+            continue; // Something nearer was found since this node was pushed
+        }
+
+        const Node &node = nodes[index];
+        if (node.IsLeaf())
+        {
+            float distance = entry;
+            if (!filter || filter(node.entity, distance))
+            {
+                if (distance <= closest)
+                {
+                    closest = distance;
+                    hit.entity = node.entity;
+                    hit.distance = distance;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so the far one is more likely to be pruned. A leaf's entry
+        // is taken from its exact box, so it is the hit distance too.
+        float leftEntry = IntersectRay(nodes[node.left].QueryBox(), origin, inverseDirection, closest);
+        float rightEntry = IntersectRay(nodes[node.right].QueryBox(), origin, inverseDirection, closest);
+        bool leftFirst = leftEntry >= 0.0f && (rightEntry < 0.0f || leftEntry <= rightEntry);
+        if (leftFirst)
+        {
+            if (rightEntry >= 0.0f)
+                stack.push_back({node.right, rightEntry});
+            stack.push_back({node.left, leftEntry});
+        }
+        else
+        {
+            if (leftEntry >= 0.0f)
+                stack.push_back({node.left, leftEntry});
+            if (rightEntry >= 0.0f)
+                stack.push_back({node.right, rightEntry});
+        }
+    }
+
+    return found;
+}
+
+void SceneBVH::QueryNearest(const glm::vec3 &point, size_t k, std::vector<entt::entity> &results) const
+{
+    if (root == Null || k == 0)
+    {
+        return;
+    }
+
+    using Candidate = std::pair<float, int>;
+
+    // Best-first: nodes come out of the open list nearest first; the k best leaves so far
+    // are kept in a max-heap so the worst of them bounds the search. Leaves are measured by
+    // their exact boxes, so they come out in true distance order.
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> open;
+    std::priority_queue<Candidate> best;
+    open.push({DistanceSquared(nodes[root].QueryBox(), point), root});
+
+    while (!open.empty())
+    {
+        Candidate current = open.top();
+        open.pop();
+        if (best.size() == k && current.first > best.top().first)
+        {
+            break;
+        }
+
+        const Node &node = nodes[current.second];
+        if (node.IsLeaf())
+        {
+            best.push(current);
+            if (best.size() > k)
+            {
+                best.pop();
+            }
+            continue;
+        }
+
+        open.push({DistanceSquared(nodes[node.left].QueryBox(), point), node.left});
+        open.push({DistanceSquared(nodes[node.right].QueryBox(), point), node.right});
+    }
+
+    size_t first = results.size();
+    while (!best.empty())
+    {
+        results.push_back(nodes[best.top().second].entity);
+        best.pop();
+    }
+    std::reverse(results.begin() + first, results.end());
+}
+
+float SceneBVH::GetSAHCost() const
+{
+    if (root == Null)
+    {
+        return 0.0f;
+    }
+
+    float rootArea = SurfaceArea(nodes[root].box);
+    if (rootArea <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    float total = 0.0f;
+    std::vector<int> stack = {root};
+    while (!stack.empty())
+    {
+        const Node &node = nodes[stack.back()];
+        stack.pop_back();
+        if (!node.IsLeaf())
+        {
+            total += SurfaceArea(node.box);
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+    return total / rootArea;
+}
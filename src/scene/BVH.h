@@ -0,0 +1,85 @@
+#pragma once
+#include <glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <entt.hpp>
+#include "Bounds.h"
+#include "../core/FrustumCuller.h"
+
+struct RaycastHit
+{
+    entt::entity entity = entt::null;
+    float distance = 0.0f; // Distance along the ray to the entry point of the entity's box
+};
+
+// Dynamic bounding volume hierarchy over entity bounds.
+//
+// Build() creates a tree with a binned surface-area heuristic. Afterwards entities are
+// kept current one by one: leaves store a slightly enlarged ("fat") box so small motions
+// need no work, moderate motions refit the leaf's ancestors in place, and anything that
+// leaves its old neighbourhood is removed and re-inserted at the cheapest position.
+// Traversal uses the fat boxes, but every leaf also keeps the entity's exact box, and
+// queries test that one, so results never include entities that only the margin touches.
+class SceneBVH
+{
+public:
+    SceneBVH();
+
+    void Clear();
+
+    // Replaces the whole tree with a fresh SAH build
+    void Build(const std::vector<std::pair<entt::entity, AABB>> &items);
+
+    // Adds or moves an entity
+    void Update(entt::entity entity, const AABB &box);
+    void Remove(entt::entity entity);
+    bool Contains(entt::entity entity) const { return leaves.count(entity) != 0; }
+
+    void QueryFrustum(const Frustum &frustum, std::vector<entt::entity> &results) const;
+    void QueryOverlap(const AABB &box, std::vector<entt::entity> &results) const;
+
+    // Closest entity whose box is hit by the ray. The optional filter can refine a
+    // candidate (e.g. with a triangle test) by returning false or shortening the distance.
+    bool Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RaycastHit &hit,
+                 const std::function<bool(entt::entity, float &)> &filter = nullptr) const;
+
+    // Up to k entities ordered by the distance from point to their boxes
+    void QueryNearest(const glm::vec3 &point, size_t k, std::vector<entt::entity> &results) const;
+
+    size_t Size() const { return leaves.size(); }
+
+    // Sum of internal node surface areas relative to the root, a measure of tree quality
+    float GetSAHCost() const;
+
+private:
+    static const int Null = -1;
+
+    struct Node
+    {
+        AABB box;   // Fat for leaves, the union of the children otherwise
+        AABB tight; // Leaves: the entity's exact box
+        int parent = Null;
+        int left = Null;
+        int right = Null;
+        entt::entity entity = entt::null;
+
+        bool IsLeaf() const { return left == Null; }
+        // Box a query tests against this node
+        const AABB &QueryBox() const { return IsLeaf() ? tight : box; }
+    };
+
+    int AllocateNode();
+    void FreeNode(int index);
+    int BuildRange(std::vector<int> &leafNodes, size_t begin, size_t end);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    void RefitAncestors(int index);
+
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    std::unordered_map<entt::entity, int> leaves;
+    int root;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Axis-aligned bounding box
+struct AABB
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+    // Box that contains this box after transformation (Arvo's method)
+    AABB Transformed(const glm::mat4 &matrix) const
+    {
+        glm::vec3 center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+        glm::vec3 extents = GetExtents();
+        glm::vec3 worldExtents(0.0f);
+        for (int column = 0; column < 3; column++)
+        {
+            worldExtents += glm::abs(glm::vec3(matrix[column])) * extents[column];
+        }
+        return {center - worldExtents, center + worldExtents};
+    }
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // Sphere that contains this sphere after transformation; non-uniform scale uses the largest axis
+    BoundingSphere Transformed(const glm::mat4 &matrix) const
+    {
+        float scale = std::max(glm::length(glm::vec3(matrix[0])),
+                               std::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+        return {glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * scale};
+    }
+};
+
+// Local-space bounds of a mesh, computed once at import
+struct MeshBounds
+{
+    AABB box;
+    BoundingSphere sphere;
+
+    // Box from the min/max corner, sphere centred on the box with the farthest vertex as radius
+    template <typename VertexT>
+    static MeshBounds FromVertices(const std::vector<VertexT> &vertices)
+    {
+        MeshBounds bounds;
+        if (vertices.empty())
+        {
+            return bounds;
+        }
+
+        bounds.box.min = bounds.box.max = vertices[0].Position;
+        for (const VertexT &vertex : vertices)
+        {
+            bounds.box.min = glm::min(bounds.box.min, vertex.Position);
+            bounds.box.max = glm::max(bounds.box.max, vertex.Position);
+        }
+
+        bounds.sphere.center = bounds.box.GetCenter();
+        float radiusSquared = 0.0f;
+        for (const VertexT &vertex : vertices)
+        {
+            glm::vec3 offset = vertex.Position - bounds.sphere.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        bounds.sphere.radius = std::sqrt(radiusSquared);
+        return bounds;
+    }
+};
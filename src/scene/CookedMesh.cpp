@@ -0,0 +1,320 @@
+#include "CookedMesh.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+static_assert(sizeof(unsigned int) == sizeof(uint32_t), "Indices are stored as 32-bit values");
+
+namespace
+{
+    uint64_t Align(uint64_t offset)
+    {
+        return (offset + EmeshAlignment - 1) & ~static_cast<uint64_t>(EmeshAlignment - 1);
+    }
+
+    // Whether count elements of the given size starting at offset lie inside the file
+    bool InFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+    {
+        return offset % EmeshAlignment == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    }
+
+    // first + count <= total without overflowing
+    bool InRange(uint64_t first, uint64_t count, uint64_t total)
+    {
+        return first <= total && count <= total - first;
+    }
+}
+
+bool WriteCookedModel(const std::string &path, const CookedModelDesc &model)
+{
+    EmeshHeader header = {};
+    header.magic = EmeshMagic;
+    header.version = EmeshVersion;
+    header.vertexSize = sizeof(Vertex);
+    header.submeshCount = static_cast<uint32_t>(model.submeshes.size());
+    header.materialCount = static_cast<uint32_t>(model.materials.size());
+    header.textureCount = static_cast<uint32_t>(model.textures.size());
+    header.sourceSize = model.sourceSize;
+    header.sourceTime = model.sourceTime;
+
+    std::string strings;
+    auto addString = [&](const std::string &text, uint32_t &offset, uint32_t &length)
+    {
+        offset = static_cast<uint32_t>(strings.size());
+        length = static_cast<uint32_t>(text.size());
+        strings += text;
+    };
+
+    // Tables first, so the layout below is known before anything is written
+    std::vector<EmeshSubmesh> submeshes(model.submeshes.size());
+    for (size_t i = 0; i < model.submeshes.size(); i++)
+    {
+        const CookedModelDesc::Submesh &source = model.submeshes[i];
+        EmeshSubmesh &submesh = submeshes[i];
+        submesh = {};
+        submesh.firstVertex = header.vertexCount;
+        submesh.vertexCount = source.vertexCount;
+        submesh.firstIndex = header.indexCount;
+        submesh.indexCount = source.indexCount;
+        submesh.material = source.material;
+        addString(source.name, submesh.nameOffset, submesh.nameLength);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            submesh.boxMin[axis] = source.bounds.box.min[axis];
+            submesh.boxMax[axis] = source.bounds.box.max[axis];
+            submesh.sphereCenter[axis] = source.bounds.sphere.center[axis];
+        }
+        submesh.sphereRadius = source.bounds.sphere.radius;
+        header.vertexCount += source.vertexCount;
+        header.indexCount += source.indexCount;
+    }
+
+    std::vector<EmeshMaterial> materials;
+    std::vector<uint32_t> materialTextures;
+    for (const std::vector<uint32_t> &textures : model.materials)
+    {
+        materials.push_back({static_cast<uint32_t>(materialTextures.size()), static_cast<uint32_t>(textures.size())});
+        materialTextures.insert(materialTextures.end(), textures.begin(), textures.end());
+    }
+    header.materialTextureCount = static_cast<uint32_t>(materialTextures.size());
+
+    std::vector<EmeshTexture> textures(model.textures.size());
+    for (size_t i = 0; i < model.textures.size(); i++)
+    {
+        addString(model.textures[i].path, textures[i].pathOffset, textures[i].pathLength);
+        addString(model.textures[i].type, textures[i].typeOffset, textures[i].typeLength);
+    }
+
+    uint64_t offset = Align(sizeof(EmeshHeader));
+    auto place = [&](uint64_t &sectionOffset, uint64_t size)
+    {
+        sectionOffset = offset;
+        offset = Align(offset + size);
+    };
+    place(header.submeshOffset, submeshes.size() * sizeof(EmeshSubmesh));
+    place(header.materialOffset, materials.size() * sizeof(EmeshMaterial));
+    place(header.materialTextureOffset, materialTextures.size() * sizeof(uint32_t));
+    place(header.textureOffset, textures.size() * sizeof(EmeshTexture));
+    place(header.stringOffset, strings.size());
+    header.stringSize = strings.size();
+    place(header.vertexOffset, header.vertexCount * sizeof(Vertex));
+    place(header.indexOffset, header.indexCount * sizeof(uint32_t));
+    header.fileSize = offset;
+
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return false;
+        }
+
+        uint64_t written = 0;
+        auto write = [&](const void *data, uint64_t size)
+        {
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        auto pad = [&]()
+        {
+            static const char zeros[EmeshAlignment] = {};
+            write(zeros, Align(written) - written);
+        };
+
+        write(&header, sizeof(header));
+        pad();
+        write(submeshes.data(), submeshes.size() * sizeof(EmeshSubmesh));
+        pad();
+        write(materials.data(), materials.size() * sizeof(EmeshMaterial));
+        pad();
+        write(materialTextures.data(), materialTextures.size() * sizeof(uint32_t));
+        pad();
+        write(textures.data(), textures.size() * sizeof(EmeshTexture));
+        pad();
+        write(strings.data(), strings.size());
+        pad();
+        for (const CookedModelDesc::Submesh &submesh : model.submeshes)
+        {
+            write(submesh.vertices, submesh.vertexCount * sizeof(Vertex));
+        }
+        pad();
+        for (const CookedModelDesc::Submesh &submesh : model.submeshes)
+        {
+            write(submesh.indices, submesh.indexCount * sizeof(uint32_t));
+        }
+        pad();
+
+        if (!out || written != header.fileSize)
+        {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::string GetCookedPath(const std::string &modelPath)
+{
+    return modelPath + ".emesh";
+}
+
+bool GetSourceStamp(const std::string &path, uint64_t &size, int64_t &time)
+{
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return false;
+    }
+    time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    return !error;
+}
+
+bool CookedModel::Load(const std::string &path)
+{
+    header = nullptr;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+
+    header = reinterpret_cast<const EmeshHeader *>(file.GetData());
+    if (!Validate())
+    {
+        header = nullptr;
+        file.Close();
+        return false;
+    }
+    return true;
+}
+
+bool CookedModel::Validate() const
+{
+    uint64_t size = file.GetSize();
+    if (size < sizeof(EmeshHeader) || header->magic != EmeshMagic || header->version != EmeshVersion ||
+        header->vertexSize != sizeof(Vertex) || header->fileSize != size)
+    {
+        return false;
+    }
+
+    if (!InFile(header->submeshOffset, header->submeshCount, sizeof(EmeshSubmesh), size) ||
+        !InFile(header->materialOffset, header->materialCount, sizeof(EmeshMaterial), size) ||
+        !InFile(header->materialTextureOffset, header->materialTextureCount, sizeof(uint32_t), size) ||
+        !InFile(header->textureOffset, header->textureCount, sizeof(EmeshTexture), size) ||
+        !InFile(header->stringOffset, header->stringSize, 1, size) ||
+        !InFile(header->vertexOffset, header->vertexCount, sizeof(Vertex), size) ||
+        !InFile(header->indexOffset, header->indexCount, sizeof(uint32_t), size))
+    {
+        return false;
+    }
+
+    // The tables reference each other by index, so a damaged file could point anywhere
+    const EmeshSubmesh *submeshes = Section<EmeshSubmesh>(header->submeshOffset);
+    for (uint32_t i = 0; i < header->submeshCount; i++)
+    {
+        const EmeshSubmesh &submesh = submeshes[i];
+        if (!InRange(submesh.firstVertex, submesh.vertexCount, header->vertexCount) ||
+            !InRange(submesh.firstIndex, submesh.indexCount, header->indexCount) ||
+            !InRange(submesh.nameOffset, submesh.nameLength, header->stringSize) ||
+            submesh.material >= header->materialCount)
+        {
+            return false;
+        }
+
+        // Indices go to the GPU as they are; one past the submesh's vertices would read out of bounds
+        const uint32_t *indices = Section<uint32_t>(header->indexOffset) + submesh.firstIndex;
+        for (uint64_t i = 0; i < submesh.indexCount; i++)
+        {
+            if (indices[i] >= submesh.vertexCount)
+            {
+                return false;
+            }
+        }
+    }
+
+    const EmeshMaterial *materials = Section<EmeshMaterial>(header->materialOffset);
+    const uint32_t *materialTextures = Section<uint32_t>(header->materialTextureOffset);
+    for (uint32_t i = 0; i < header->materialCount; i++)
+    {
+        if (!InRange(materials[i].firstTexture, materials[i].textureCount, header->materialTextureCount))
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->materialTextureCount; i++)
+    {
+        if (materialTextures[i] >= header->textureCount)
+        {
+            return false;
+        }
+    }
+
+    const EmeshTexture *textures = Section<EmeshTexture>(header->textureOffset);
+    for (uint32_t i = 0; i < header->textureCount; i++)
+    {
+        if (!InRange(textures[i].pathOffset, textures[i].pathLength, header->stringSize) ||
+            !InRange(textures[i].typeOffset, textures[i].typeLength, header->stringSize))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CookedModel::IsCookedFrom(uint64_t sourceSize, int64_t sourceTime) const
+{
+    return header && header->sourceSize == sourceSize && header->sourceTime == sourceTime;
+}
+
+std::string_view CookedModel::String(uint32_t offset, uint32_t length) const
+{
+    return std::string_view(Section<char>(header->stringOffset) + offset, length);
+}
+
+CookedModel::Submesh CookedModel::GetSubmesh(size_t index) const
+{
+    const EmeshSubmesh &submesh = Section<EmeshSubmesh>(header->submeshOffset)[index];
+
+    Submesh result;
+    result.name = String(submesh.nameOffset, submesh.nameLength);
+    result.vertices = Section<Vertex>(header->vertexOffset) + submesh.firstVertex;
+    result.vertexCount = static_cast<size_t>(submesh.vertexCount);
+    result.indices = Section<unsigned int>(header->indexOffset) + submesh.firstIndex;
+    result.indexCount = static_cast<size_t>(submesh.indexCount);
+    result.bounds.box.min = glm::vec3(submesh.boxMin[0], submesh.boxMin[1], submesh.boxMin[2]);
+    result.bounds.box.max = glm::vec3(submesh.boxMax[0], submesh.boxMax[1], submesh.boxMax[2]);
+    result.bounds.sphere.center = glm::vec3(submesh.sphereCenter[0], submesh.sphereCenter[1], submesh.sphereCenter[2]);
+    result.bounds.sphere.radius = submesh.sphereRadius;
+    result.material = submesh.material;
+    return result;
+}
+
+std::vector<uint32_t> CookedModel::GetMaterialTextures(size_t material) const
+{
+    const EmeshMaterial &entry = Section<EmeshMaterial>(header->materialOffset)[material];
+    const uint32_t *first = Section<uint32_t>(header->materialTextureOffset) + entry.firstTexture;
+    return std::vector<uint32_t>(first, first + entry.textureCount);
+}
+
+std::string_view CookedModel::GetTexturePath(size_t texture) const
+{
+    const EmeshTexture &entry = Section<EmeshTexture>(header->textureOffset)[texture];
+    return String(entry.pathOffset, entry.pathLength);
+}
+
+std::string_view CookedModel::GetTextureType(size_t texture) const
+{
+    const EmeshTexture &entry = Section<EmeshTexture>(header->textureOffset)[texture];
+    return String(entry.typeOffset, entry.typeLength);
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Mesh.h"
+#include "../core/MappedFile.h"
+
+// Cooked model file (.emesh): the meshes of an imported model in the exact layout the GPU buffers
+// use, so a later load maps the file and uploads from the mapping without parsing or converting.
+//
+//   EmeshHeader
+//   EmeshSubmesh[submeshCount]
+//   EmeshMaterial[materialCount]
+//   uint32_t materialTextures[]  Texture indices, each material owns a range
+//   EmeshTexture[textureCount]
+//   char strings[]               Names and paths, not terminated
+//   Vertex vertices[]            Interleaved, every submesh in turn
+//   uint32_t indices[]           Relative to the submesh's first vertex
+//
+// Every section starts on a 16-byte boundary. Offsets are in bytes from the start of the file,
+// values are little-endian. Texture paths are relative to the directory of the model the file was
+// cooked from, which for a file next to its model is the file's own directory.
+
+const uint32_t EmeshMagic = 0x48534D45; // "EMSH"
+const uint32_t EmeshVersion = 1;
+const uint32_t EmeshAlignment = 16;
+
+struct EmeshHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexSize; // sizeof(Vertex) when written; files with another layout are rejected
+    uint32_t submeshCount;
+    uint32_t materialCount;
+    uint32_t materialTextureCount;
+    uint32_t textureCount;
+    uint32_t reserved;
+    uint64_t sourceSize; // Size and write time of the model the file was cooked from
+    int64_t sourceTime;
+    uint64_t fileSize;
+    uint64_t submeshOffset;
+    uint64_t materialOffset;
+    uint64_t materialTextureOffset;
+    uint64_t textureOffset;
+    uint64_t stringOffset;
+    uint64_t stringSize;
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+};
+
+struct EmeshSubmesh
+{
+    uint64_t firstVertex;
+    uint64_t vertexCount;
+    uint64_t firstIndex;
+    uint64_t indexCount;
+    uint32_t nameOffset; // Into the string section
+    uint32_t nameLength;
+    uint32_t material;
+    uint32_t reserved;
+    float boxMin[3];
+    float boxMax[3];
+    float sphereCenter[3];
+    float sphereRadius;
+};
+
+struct EmeshMaterial
+{
+    uint32_t firstTexture; // Into the material texture indices
+    uint32_t textureCount;
+};
+
+struct EmeshTexture
+{
+    uint32_t pathOffset; // Into the string section
+    uint32_t pathLength;
+    uint32_t typeOffset;
+    uint32_t typeLength;
+};
+
+// Everything WriteCookedModel needs, pointing into the importer's own arrays
+struct CookedModelDesc
+{
+    struct Submesh
+    {
+        std::string name;
+        const Vertex *vertices;
+        size_t vertexCount;
+        const unsigned int *indices;
+        size_t indexCount;
+        MeshBounds bounds;
+        uint32_t material;
+    };
+    struct Texture
+    {
+        std::string path; // Relative to the model's directory
+        std::string type;
+    };
+
+    std::vector<Submesh> submeshes;
+    std::vector<std::vector<uint32_t>> materials; // Texture indices of each material
+    std::vector<Texture> textures;
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+};
+
+// Writes through a temporary file that replaces path once complete, so readers never see a partial file
+bool WriteCookedModel(const std::string &path, const CookedModelDesc &model);
+
+// Where the cooked copy of a model lives: next to it, with ".emesh" appended
+std::string GetCookedPath(const std::string &modelPath);
+
+// Size and write time of a file, recorded in cooked files to notice edited sources
+bool GetSourceStamp(const std::string &path, uint64_t &size, int64_t &time);
+
+// A mapped .emesh file. Every view it returns points into the mapping and stays valid until the
+// model is destroyed or loads another file.
+class CookedModel
+{
+public:
+    // Maps the file and checks the header and every table against the file size, and every index
+    // against its submesh's vertices; false if it is missing, malformed or from another format version
+    bool Load(const std::string &path);
+
+    bool IsCookedFrom(uint64_t sourceSize, int64_t sourceTime) const;
+
+    struct Submesh
+    {
+        std::string_view name;
+        const Vertex *vertices;
+        size_t vertexCount;
+        const unsigned int *indices;
+        size_t indexCount;
+        MeshBounds bounds;
+        uint32_t material;
+    };
+    size_t GetSubmeshCount() const { return header ? header->submeshCount : 0; }
+    Submesh GetSubmesh(size_t index) const;
+
+    size_t GetMaterialCount() const { return header ? header->materialCount : 0; }
+    // Texture indices of the material
+    std::vector<uint32_t> GetMaterialTextures(size_t material) const;
+
+    size_t GetTextureCount() const { return header ? header->textureCount : 0; }
+    std::string_view GetTexturePath(size_t texture) const;
+    std::string_view GetTextureType(size_t texture) const;
+
+private:
+    template <typename T>
+    const T *Section(uint64_t offset) const { return reinterpret_cast<const T *>(file.GetData() + offset); }
+    std::string_view String(uint32_t offset, uint32_t length) const;
+    bool Validate() const;
+
+    MappedFile file;
+    const EmeshHeader *header = nullptr;
+};
@@ -0,0 +1,163 @@
+#include "CookedTexture.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+    uint64_t Align(uint64_t offset)
+    {
+        return (offset + EtexAlignment - 1) & ~static_cast<uint64_t>(EtexAlignment - 1);
+    }
+}
+
+bool WriteCookedTexture(const std::string &path, const CompressedTexture &texture, uint64_t sourceHash)
+{
+    if (texture.levels.empty())
+    {
+        return false;
+    }
+
+    EtexHeader header = {};
+    header.magic = EtexMagic;
+    header.version = EtexVersion;
+    header.format = static_cast<uint32_t>(texture.format);
+    header.levelCount = static_cast<uint32_t>(texture.levels.size());
+    header.width = static_cast<uint32_t>(texture.levels.front().width);
+    header.height = static_cast<uint32_t>(texture.levels.front().height);
+    header.sourceHash = sourceHash;
+    header.levelOffset = Align(sizeof(EtexHeader));
+
+    std::vector<EtexLevel> levels(texture.levels.size());
+    uint64_t offset = Align(header.levelOffset + levels.size() * sizeof(EtexLevel));
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        const CompressedTexture::Level &level = texture.levels[i];
+        levels[i].offset = offset;
+        levels[i].size = level.blocks.size();
+        levels[i].width = static_cast<uint32_t>(level.width);
+        levels[i].height = static_cast<uint32_t>(level.height);
+        offset = Align(offset + level.blocks.size());
+    }
+    header.fileSize = offset;
+
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return false;
+        }
+
+        uint64_t written = 0;
+        auto write = [&](const void *data, uint64_t size)
+        {
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        auto pad = [&]()
+        {
+            static const char zeros[EtexAlignment] = {};
+            write(zeros, Align(written) - written);
+        };
+
+        write(&header, sizeof(header));
+        pad();
+        write(levels.data(), levels.size() * sizeof(EtexLevel));
+        pad();
+        for (const CompressedTexture::Level &level : texture.levels)
+        {
+            write(level.blocks.data(), level.blocks.size());
+            pad();
+        }
+
+        if (!out || written != header.fileSize)
+        {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::string GetCookedTextureName(uint64_t sourceHash, TextureCompression compression)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 ".%s.etex", sourceHash, compression == TextureCompression::BC7 ? "bc7" : "bc");
+    return name;
+}
+
+bool CookedTexture::Load(const std::string &path)
+{
+    header = nullptr;
+    if (!file.Open(path))
+    {
+        return false;
+    }
+
+    header = reinterpret_cast<const EtexHeader *>(file.GetData());
+    if (!Validate())
+    {
+        header = nullptr;
+        file.Close();
+        return false;
+    }
+    return true;
+}
+
+bool CookedTexture::Validate() const
+{
+    uint64_t size = file.GetSize();
+    if (size < sizeof(EtexHeader) || header->magic != EtexMagic || header->version != EtexVersion || header->fileSize != size ||
+        header->format < static_cast<uint32_t>(BlockFormat::BC1) || header->format > static_cast<uint32_t>(BlockFormat::BC7) ||
+        header->levelCount == 0 || header->levelCount > 32 || header->width == 0 || header->width > 65536 ||
+        header->height == 0 || header->height > 65536 ||
+        header->levelOffset % EtexAlignment != 0 || header->levelOffset > size ||
+        header->levelCount > (size - header->levelOffset) / sizeof(EtexLevel))
+    {
+        return false;
+    }
+
+    // Every level halves the one above and holds exactly its blocks
+    const EtexLevel *levels = reinterpret_cast<const EtexLevel *>(file.GetData() + header->levelOffset);
+    uint32_t width = header->width;
+    uint32_t height = header->height;
+    for (uint32_t i = 0; i < header->levelCount; i++)
+    {
+        const EtexLevel &level = levels[i];
+        if (level.width != width || level.height != height ||
+            level.size != GetCompressedSize(GetFormat(), static_cast<int>(width), static_cast<int>(height)) ||
+            level.offset % EtexAlignment != 0 || level.offset > size || level.size > size - level.offset)
+        {
+            return false;
+        }
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return true;
+}
+
+std::vector<CompressedLevel> CookedTexture::GetLevels() const
+{
+    std::vector<CompressedLevel> views;
+    const EtexLevel *levels = reinterpret_cast<const EtexLevel *>(file.GetData() + header->levelOffset);
+    for (uint32_t i = 0; i < header->levelCount; i++)
+    {
+        views.push_back({static_cast<int>(levels[i].width), static_cast<int>(levels[i].height), file.GetData() + levels[i].offset,
+                         static_cast<size_t>(levels[i].size)});
+    }
+    return views;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../core/MappedFile.h"
+#include "../core/TextureCompression.h"
+
+// Cooked texture file (.etex): a block-compressed texture with its whole mip chain, laid out so
+// each level is uploaded straight from the mapping with glCompressedTexImage2D.
+//
+//   EtexHeader
+//   EtexLevel levels[levelCount]  Largest first, down to 1x1
+//   uint8_t blocks[]              Each level's blocks in row-major order
+//
+// Every section and level starts on a 16-byte boundary. Offsets are in bytes from the start of
+// the file, values are little-endian.
+
+const uint32_t EtexMagic = 0x58455445; // "ETEX"
+const uint32_t EtexVersion = 1;
+const uint32_t EtexAlignment = 16;
+
+struct EtexHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format; // BlockFormat
+    uint32_t levelCount;
+    uint32_t width;
+    uint32_t height;
+    uint64_t sourceHash; // Content hash of the image file the texture was cooked from
+    uint64_t fileSize;
+    uint64_t levelOffset;
+};
+
+struct EtexLevel
+{
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Writes through a temporary file that replaces path once complete, so readers never see a partial file
+bool WriteCookedTexture(const std::string &path, const CompressedTexture &texture, uint64_t sourceHash);
+
+// File name of the cooked copy of an image in a cache directory: its content hash and the
+// compression setting, so copies of one image share a file
+std::string GetCookedTextureName(uint64_t sourceHash, TextureCompression compression);
+
+// A mapped .etex file. The level views point into the mapping and stay valid until the texture is
+// destroyed or loads another file.
+class CookedTexture
+{
+public:
+    // Maps the file and checks the header and every level against the file size; false if it is
+    // missing, malformed or from another format version
+    bool Load(const std::string &path);
+
+    bool IsCookedFrom(uint64_t sourceHash) const { return header && header->sourceHash == sourceHash; }
+
+    BlockFormat GetFormat() const { return static_cast<BlockFormat>(header->format); }
+    int GetWidth() const { return static_cast<int>(header->width); }
+    int GetHeight() const { return static_cast<int>(header->height); }
+    std::vector<CompressedLevel> GetLevels() const;
+
+private:
+    bool Validate() const;
+
+    MappedFile file;
+    const EtexHeader *header = nullptr;
+};
@@ -1,122 +1,47 @@
 #include "Mesh.h"
-#include "../ecs/MovementSystem.h"
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 #include <iostream>
 #include <glm.hpp>
 
-// Function to compile shaders
-GLuint CompileShader(const char *source, GLenum shaderType)
+// Constructor
+Mesh::Mesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+           const std::vector<Texture> &textures, const MeshBounds &bounds)
+    : textures(textures), instanceCapacity(0), indexCount(indexCount), bounds(bounds)
 {
-    GLuint shader = glCreateShader(shaderType);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
-
-    // Check for compilation errors
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    // Fold the texture names into a key; collisions only cost a few extra binds
+    materialKey = 2166136261u;
+    for (const Texture &texture : textures)
     {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
+        materialKey = (materialKey ^ texture.handle.GetId()) * 16777619u;
     }
 
-    return shader;
+    SetupMesh(vertices, vertexCount, indices);
 }
 
-// Function to create a shader program
-GLuint CreateShaderProgram()
+Mesh::~Mesh()
 {
-    // Vertex Shader source code
-    const char *vertexShaderSource = R"(
-       #version 330 core
-        layout (location = 0) in vec3 aPos;
-        layout (location = 1) in vec3 aNormal;
-        layout (location = 2) in vec2 aTexCoords;
-
-        out vec2 TexCoords;
-
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
-
-        void main()
-        {
-            TexCoords = aTexCoords; // Pass the texture coordinates to the fragment shader
-            gl_Position = projection * view * model * vec4(aPos, 1.0);
-        }
-
-        )";
-
-    // Fragment Shader source code
-    const char *fragmentShaderSource = R"(
-        #version 330 core
-        out vec4 FragColor;
-
-        in vec2 TexCoords;
-
-        uniform sampler2D texture1; // Texture uniform
-
-        void main()
-        {
-            FragColor = texture(texture1, TexCoords); // Sample the texture
-        }
-
-        )";
-
-    // Compile vertex shader
-    GLuint vertexShader = CompileShader(vertexShaderSource, GL_VERTEX_SHADER);
-
-    // Compile fragment shader
-    GLuint fragmentShader = CompileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    // Link shaders into a shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // Check for linking errors
-    GLint success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                  << infoLog << std::endl;
-    }
-
-    // Clean up shaders as they are now linked into the program
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-// Constructor
-Mesh::Mesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, const std::vector<Texture> &textures, entt::registry *registry, entt::entity entity)
-    : vertices(vertices), indices(indices), textures(textures), registry(registry), entity(entity)
-{
-    SetupMesh();
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &VAO);
 }
 
 // Method to setup the mesh data (VAO, VBO, EBO)
-void Mesh::SetupMesh()
+void Mesh::SetupMesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices)
 {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
+    glGenBuffers(1, &instanceVBO);
 
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 
     // Vertex Positions
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
@@ -130,47 +55,39 @@ void Mesh::SetupMesh()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, TexCoords));
     glEnableVertexAttribArray(2);
 
+    // Instance model matrix, one vec4 column per attribute, advancing once per instance
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(sizeof(glm::vec4) * column));
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribDivisor(3 + column, 1);
+    }
+
     glBindVertexArray(0);
 }
 
 // Method to draw the mesh
-void Mesh::Draw(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+void Mesh::DrawInstanced(GLStateCache &state, const glm::mat4 *models, size_t instanceCount)
 {
-    GLuint shaderProgram = CreateShaderProgram(); // Use the correct shader program
-    glUseProgram(shaderProgram);
-
-    // Retrieve the transform from the TransformComponent of the entity
-    auto &transform = registry->get<TransformComponent>(entity);
-
-    // Calculate the model matrix from the transform component
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), transform.position) *
-                      glm::rotate(glm::mat4(1.0f), glm::radians(transform.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
-                      glm::rotate(glm::mat4(1.0f), glm::radians(transform.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
-                      glm::rotate(glm::mat4(1.0f), glm::radians(transform.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f)) *
-                      glm::scale(glm::mat4(1.0f), transform.scale);
-
-    // Set shader uniforms
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+    // Orphan the instance buffer so the upload never waits on last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (instanceCount > instanceCapacity)
+    {
+        instanceCapacity = instanceCount;
+    }
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(glm::mat4), models);
 
-    // Bind textures
+    // Bind textures; sampler "textureN" already reads from unit N-1
     for (unsigned int i = 0; i < textures.size(); i++)
     {
-        glActiveTexture(GL_TEXTURE0 + i);                                                                 // Activate texture unit
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);                                                     // Bind the texture
-        glUniform1i(glGetUniformLocation(shaderProgram, ("texture" + std::to_string(i + 1)).c_str()), i); // Pass texture unit to shader
+        state.BindTexture(i, textures[i].handle.GetId());
     }
 
-    // Bind VAO and draw the mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    // Unbind textures
-    glActiveTexture(GL_TEXTURE0);
+    // Bind VAO and draw every instance; the binding is left for the next draw to reuse
+    state.BindVertexArray(VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(instanceCount));
+    state.GetStats().drawCalls++;
+    state.GetStats().instances += static_cast<uint32_t>(instanceCount);
 }
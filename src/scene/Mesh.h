@@ -5,6 +5,10 @@
 #include <GL/glew.h>
 #include <string>
 #include <entt.hpp>
+#include <memory>
+#include "../core/GLStateCache.h"
+#include "../core/TextureManager.h"
+#include "Bounds.h"
 
 struct Vertex
 {
@@ -13,26 +17,54 @@ struct Vertex
     glm::vec2 TexCoords;
 };
 
+// A texture a mesh is drawn with; the mesh's reference keeps it resident
 struct Texture
 {
-    GLuint id;
+    TextureHandle handle;
     std::string type;
     std::string path;
 };
 
+// GPU geometry plus the textures it is drawn with.
+// A Mesh is shared by every entity that references it through a MeshComponent,
+// and all of those entities are drawn together with one instanced call.
 class Mesh
 {
 public:
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
     std::vector<Texture> textures;
 
-    Mesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, const std::vector<Texture> &textures, entt::registry *registry, entt::entity entity);
-    void Draw(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
+    // Uploads the geometry straight from the given arrays, which may point into a mapped file;
+    // no CPU copy is kept
+    Mesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+         const std::vector<Texture> &textures, const MeshBounds &bounds);
+    ~Mesh();
+
+    Mesh(const Mesh &) = delete;
+    Mesh &operator=(const Mesh &) = delete;
+
+    // Streams the per-instance model matrices and draws them all in one call.
+    // The program must already be bound; texture and VAO binds go through the state cache.
+    void DrawInstanced(GLStateCache &state, const glm::mat4 *models, size_t instanceCount);
+
+    GLuint GetVertexArray() const { return VAO; }
+    size_t GetIndexCount() const { return indexCount; }
+    uint32_t GetMaterialKey() const { return materialKey; }
+    const MeshBounds &GetBounds() const { return bounds; }
 
 private:
     GLuint VAO, VBO, EBO;
-    void SetupMesh();
-    entt::registry *registry;
-    entt::entity entity;
+    GLuint instanceVBO;    // Per-instance model matrices, attribute locations 3-6
+    size_t instanceCapacity;
+    size_t indexCount;
+    uint32_t materialKey; // Identifies the texture set so draws sharing it sort together
+    MeshBounds bounds;    // Local-space bounds used for culling
+    void SetupMesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices);
+};
+
+// Attaches shared geometry to an entity; the entity's TransformComponent places it
+struct MeshComponent
+{
+    std::shared_ptr<Mesh> mesh;
+
+    MeshComponent(std::shared_ptr<Mesh> mesh = nullptr) : mesh(std::move(mesh)) {}
 };
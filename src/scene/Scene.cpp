@@ -2,24 +2,51 @@
 
 #include "Scene.h"
 #include "Mesh.h"
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <iostream>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "../core/Log.h"
+#include "../core/Profiler.h"
+#include <limits>
 #include <entt.hpp>
 #include "../ecs/MovementSystem.h"
 #include "../ecs/NameComponent.h"
-
-Scene::Scene(entt::registry *registry) : registry(registry)
+#include "../ecs/ParallelView.h"
+#include "../ecs/RelationshipComponent.h"
+
+Scene::Scene(entt::registry *registry)
+    : registry(registry), revision(0), hierarchyRevision(0), interpolation(1.0f), snapshotCount(0),
+      transforms(*registry),
+      meshObserver(*registry, entt::collector.group<TransformComponent, MeshComponent>().update<MeshComponent>()),
+      importer(*this, FindJobSystem(*registry), FindTextureManager(*registry))
 {
     // Initialize game objects, load resources, etc.
+    registry->on_destroy<MeshComponent>().connect<&Scene::OnMeshDestroyed>(*this);
+    registry->on_destroy<RelationshipComponent>().connect<&DetachRelationship>();
+
+    registry->on_construct<TransformComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+    registry->on_destroy<TransformComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+    registry->on_update<RelationshipComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+    registry->on_destroy<RelationshipComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+    registry->on_construct<NameComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+    registry->on_update<NameComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+    registry->on_destroy<NameComponent>().connect<&Scene::OnHierarchyChanged>(*this);
 }
 
 Scene::~Scene()
 {
-    // Cleanup resources
+    registry->on_destroy<MeshComponent>().disconnect<&Scene::OnMeshDestroyed>(*this);
+    registry->on_destroy<RelationshipComponent>().disconnect<&DetachRelationship>();
+    registry->on_construct<TransformComponent>().disconnect(this);
+    registry->on_destroy<TransformComponent>().disconnect(this);
+    registry->on_update<RelationshipComponent>().disconnect(this);
+    registry->on_destroy<RelationshipComponent>().disconnect(this);
+    registry->on_construct<NameComponent>().disconnect(this);
+    registry->on_update<NameComponent>().disconnect(this);
+    registry->on_destroy<NameComponent>().disconnect(this);
+    meshObserver.disconnect();
+
+    // Release the geometry while the GL context is still current
+    registry->clear<MeshComponent>();
+    models.clear();
+    meshes.clear();
 }
 
 void Scene::Update()
@@ -27,168 +54,149 @@ void Scene::Update()
     // Update game objects, physics, etc.
 }
 
-void Scene::Draw(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+void Scene::ExtractSnapshot(RenderSnapshot &snapshot)
 {
-    // Debug: Ensure this method is called
-    std::cout << "Scene: Drawing " << meshes.size() << " meshes" << std::endl;
+    PROFILE_SCOPE("Scene::ExtractSnapshot");
+    auto view = registry->view<WorldTransformComponent, MeshComponent>();
+
+    LOG_TRACE(LogCategory::Scene, "Extracting {} mesh instances", view.size_hint());
 
-    // Draw all meshes in the scene
-    for (Mesh &mesh : meshes)
+    snapshot.Clear();
+    for (auto entity : view)
     {
-        mesh.Draw(viewMatrix, projectionMatrix);
+        const std::shared_ptr<Mesh> &mesh = view.get<MeshComponent>(entity).mesh;
+        if (!mesh)
+        {
+            continue;
+        }
+        const WorldTransformComponent &world = view.get<WorldTransformComponent>(entity);
+        snapshot.instances.push_back({mesh, world.matrix, world.previousMatrix});
     }
+
+    snapshot.interpolation = interpolation;
+    snapshot.sceneRevision = revision;
+    snapshot.frame = snapshotCount++;
+    snapshot.capturedAt = std::chrono::steady_clock::now();
 }
 
-void Scene::AddMesh(const Mesh &mesh)
+void Scene::SetInterpolation(float alpha)
 {
-    meshes.push_back(mesh);
+    alpha = glm::clamp(alpha, 0.0f, 1.0f);
+    if (alpha != interpolation && transforms.HasMotion())
+    {
+        revision++; // Moving entities land somewhere else even though no step ran
+    }
+    interpolation = alpha;
 }
 
-void Scene::ProcessAssimpScene(const aiScene *scene)
+AABB Scene::GetWorldBounds(entt::entity entity) const
 {
-    // Recursively process all nodes
-    ProcessNode(scene->mRootNode, scene);
+    const Mesh *mesh = registry->get<MeshComponent>(entity).mesh.get();
+    return mesh->GetBounds().box.Transformed(registry->get<WorldTransformComponent>(entity).matrix);
 }
 
-void Scene::ProcessNode(aiNode *node, const aiScene *scene)
+void Scene::UpdateSpatialIndex()
 {
-    // Process all the node's meshes (if any)
-    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+    PROFILE_SCOPE("Scene::UpdateSpatialIndex");
+    if (transforms.Update(FindJobSystem(*registry)))
     {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        ProcessMesh(mesh, scene);
+        revision++;
     }
 
-    // Then process all the children
-    for (unsigned int i = 0; i < node->mNumChildren; i++)
+    if (!meshObserver.empty())
     {
-        ProcessNode(node->mChildren[i], scene);
+        revision++;
     }
-}
 
-void Scene::ProcessMesh(aiMesh *mesh, const aiScene *scene)
-{
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
-
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    // An empty index, e.g. right after a scene was loaded, gets its meshes in one SAH build,
+    // which makes a better tree than inserting them one at a time
+    bool bulkBuild = bvh.Size() == 0 && meshObserver.size() > 1;
+    std::vector<std::pair<entt::entity, AABB>> added;
+    for (auto entity : meshObserver)
     {
-        Vertex vertex;
-        glm::vec3 vector;
-        vector.x = mesh->mVertices[i].x;
-        vector.y = mesh->mVertices[i].y;
-        vector.z = mesh->mVertices[i].z;
-        vertex.Position = vector;
-
-        if (mesh->mNormals)
+        if (!registry->all_of<TransformComponent, MeshComponent>(entity) || !registry->get<MeshComponent>(entity).mesh)
         {
-            vector.x = mesh->mNormals[i].x;
-            vector.y = mesh->mNormals[i].y;
-            vector.z = mesh->mNormals[i].z;
-            vertex.Normal = vector;
+            bvh.Remove(entity);
         }
-
-        if (mesh->mTextureCoords[0])
+        else if (bulkBuild)
         {
-            glm::vec2 vec;
-            vec.x = mesh->mTextureCoords[0][i].x;
-            vec.y = mesh->mTextureCoords[0][i].y;
-            vertex.TexCoords = vec;
+            added.push_back({entity, GetWorldBounds(entity)});
         }
         else
         {
-            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+            bvh.Update(entity, GetWorldBounds(entity));
         }
-
-        vertices.push_back(vertex);
     }
-
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+    meshObserver.clear();
+    if (!added.empty())
     {
-        aiFace face = mesh->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
+        bvh.Build(added);
     }
 
-    // Manually load the texture for testing
-    std::string diffusePath = "C:/Users/pc/Downloads/Prunus_Pendula_OBJ/maps/prunus_pendula_branch_3_1_diffuse.jpg";
-    Texture texture;
-    texture.id = TextureFromFile(diffusePath.c_str());
-    texture.type = "texture_diffuse";
-    texture.path = diffusePath;
-    if (texture.id == 0)
+    // Moving a parent moves the bounds of every mesh below it
+    for (entt::entity entity : transforms.GetChangedEntities())
     {
-        std::cerr << "Texture failed to load at path: " << diffusePath << std::endl;
-    }
-    else
-    {
-        textures.push_back(texture);
+        const MeshComponent *meshComponent = registry->try_get<MeshComponent>(entity);
+        if (meshComponent && meshComponent->mesh)
+        {
+            bvh.Update(entity, GetWorldBounds(entity));
+        }
     }
+}
 
-    static entt::entity meshEntity = entt::null;
-    bool initialized = false;
-    if (!initialized)
-    {
-        meshEntity = registry->create();
-        registry->emplace<TransformComponent>(meshEntity, glm::vec3(0.0f, 0.0f, 0.0f));
-        registry->emplace<NameComponent>(meshEntity, "Mesh");
-        initialized = true;
-    }
+bool Scene::Pick(const glm::vec3 &origin, const glm::vec3 &direction, RaycastHit &hit) const
+{
+    return bvh.Raycast(origin, direction, std::numeric_limits<float>::max(), hit);
+}
 
-    Mesh newMesh(vertices, indices, textures, registry, meshEntity);
-    AddMesh(newMesh);
+void Scene::OnMeshDestroyed(entt::registry &, entt::entity entity)
+{
+    bvh.Remove(entity);
+    revision++;
 }
 
-std::vector<Texture> Scene::LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
+void Scene::OnHierarchyChanged(entt::registry &, entt::entity)
 {
-    std::vector<Texture> textures;
-    for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
-    {
-        aiString str;
-        mat->GetTexture(type, i, &str);
-        Texture texture;
-        texture.id = TextureFromFile(str.C_Str());
-        texture.type = typeName;
-        texture.path = str.C_Str();
-        textures.push_back(texture);
-    }
-    return textures;
+    hierarchyRevision++;
 }
 
-GLuint Scene::TextureFromFile(const char *path)
+void Scene::AddMesh(const std::shared_ptr<Mesh> &mesh)
 {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
+    meshes.push_back(mesh);
+}
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
+entt::entity Scene::InstantiateMesh(const std::shared_ptr<Mesh> &mesh, const std::string &name)
+{
+    entt::entity meshEntity = registry->create();
+    registry->emplace<TransformComponent>(meshEntity, glm::vec3(0.0f, 0.0f, 0.0f));
+    registry->emplace<NameComponent>(meshEntity, name);
+    registry->emplace<MeshComponent>(meshEntity, mesh);
+    return meshEntity;
+}
+
+bool Scene::InstantiateModel(const std::string &assetPath)
+{
+    auto it = models.find(assetPath);
+    if (it == models.end())
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        return false;
     }
-    else
+
+    for (const std::shared_ptr<Mesh> &mesh : it->second)
     {
-        std::cerr << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        InstantiateMesh(mesh);
     }
+    return true;
+}
 
-    return textureID;
+void Scene::AddModel(const std::string &assetPath, const std::vector<std::shared_ptr<Mesh>> &modelMeshes)
+{
+    models[assetPath] = modelMeshes;
+}
+
+bool Scene::ImportModel(const std::string &assetPath)
+{
+    // A failed import of another file still pending would be reported here too, so finish those first
+    importer.Finish();
+    return importer.ImportAsync(assetPath) && importer.Finish();
 }
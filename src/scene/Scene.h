@@ -5,9 +5,13 @@
 #include <vector>
 #include <string>
 #include <glm.hpp>
-#include <assimp/scene.h>
 #include "Mesh.h" // Assuming you have a Mesh class to handle the rendering
-#include <vector>
+#include "../core/RenderSnapshot.h"
+#include "BVH.h"
+#include "AssetImporter.h"
+#include "../ecs/TransformHierarchy.h"
+#include <unordered_map>
+#include <memory>
 #include <entt.hpp>
 
 class Scene
@@ -17,16 +21,61 @@ public:
     ~Scene();
 
     void Update();
-    void Draw(glm::mat4 viewMatrix, glm::mat4 projectionMatrix); // Pass view and projection matrices
-    void AddMesh(const Mesh &mesh);
+    // Copies the placement of every mesh entity into the snapshot for the renderer; safe to
+    // call from the simulation thread, the snapshot is only read once it has been handed over
+    void ExtractSnapshot(RenderSnapshot &snapshot);
+    void AddMesh(const std::shared_ptr<Mesh> &mesh);
+
+    // Creates an entity drawing the mesh at the origin
+    entt::entity InstantiateMesh(const std::shared_ptr<Mesh> &mesh, const std::string &name = "Mesh");
+
+    // Creates one entity per mesh of an already imported model, sharing its geometry.
+    // Returns false if the model has not been imported yet.
+    bool InstantiateModel(const std::string &assetPath);
+    bool HasModel(const std::string &assetPath) const { return models.count(assetPath) > 0; }
+
+    // Registers the meshes of an imported model so InstantiateModel can place it again
+    void AddModel(const std::string &assetPath, const std::vector<std::shared_ptr<Mesh>> &modelMeshes);
+
+    // Imports a model file and instantiates it, blocking until it is uploaded; returns false if
+    // the import failed. The editor goes through GetImporter() instead so it keeps drawing.
+    bool ImportModel(const std::string &assetPath);
+    AssetImporter &GetImporter() { return importer; }
+
+    // Recomputes the world matrices of edited transforms and their descendants, then brings the
+    // BVH up to date for entities whose world matrix or mesh changed since the last call
+    void UpdateSpatialIndex();
+    const SceneBVH &GetSpatialIndex() const { return bvh; }
+
+    // Start of a simulation step: what is current now becomes the interpolation start point
+    void SavePreviousTransforms() { transforms.SavePreviousMatrices(); }
+
+    // Where rendering falls between the previous and the current simulation step, 0..1.
+    // Recorded in snapshots, so moving entities are drawn blended by this factor; 1 draws the latest step.
+    void SetInterpolation(float alpha);
+
+    // Increases whenever something that affects the rendered image changed, so views can skip redraws
+    uint64_t GetRevision() const { return revision; }
+
+    // Increases whenever entities are added to or removed from the hierarchy, reparented or renamed
+    uint64_t GetHierarchyRevision() const { return hierarchyRevision; }
 
-    void ProcessAssimpScene(const aiScene *scene);
-    void ProcessNode(aiNode *node, const aiScene *scene);
-    void ProcessMesh(aiMesh *mesh, const aiScene *scene);
+    // Closest mesh entity under a world-space ray, used for editor picking
+    bool Pick(const glm::vec3 &origin, const glm::vec3 &direction, RaycastHit &hit) const;
 
 private:
-    std::vector<Texture> LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
-    GLuint TextureFromFile(const char *path);
+    AABB GetWorldBounds(entt::entity entity) const;
+    void OnMeshDestroyed(entt::registry &registry, entt::entity entity);
+    void OnHierarchyChanged(entt::registry &registry, entt::entity entity);
     entt::registry *registry;
-    std::vector<Mesh> meshes; // Store all meshes in the scene
+    uint64_t revision;
+    uint64_t hierarchyRevision;
+    float interpolation;
+    uint64_t snapshotCount;
+    std::vector<std::shared_ptr<Mesh>> meshes;                                   // Store all meshes in the scene
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Mesh>>> models; // Meshes of each imported asset
+    SceneBVH bvh;                                                               // Spatial index over mesh entities
+    TransformHierarchy transforms;                                              // World matrices of every transform
+    entt::observer meshObserver;                                                // Entities that gained or replaced a mesh
+    AssetImporter importer;                                                     // Last, so pending imports stop first
 };
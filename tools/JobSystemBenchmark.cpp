@@ -0,0 +1,363 @@
+// Micro-benchmarks for the job system, without a window or GL context: scheduling overhead,
+// small jobs against a single mutex-protected queue, ParallelFor, dependency chains, fan-out and
+// fan-in, and recursively spawned jobs that only stealing spreads across the workers. Also checks
+// that Background jobs run neither on the main thread nor inside a worker's Wait().
+//
+//   scons bench-jobs
+//
+// builds build/JobSystemBenchmark and runs it with one worker per hardware thread minus one;
+// pass the binary a worker count to change that.
+#include "../src/core/JobSystem.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Best of a few runs, in milliseconds
+    template <typename Func>
+    double Measure(Func func, int runs = 5)
+    {
+        double best = 1e30;
+        for (int i = 0; i < runs; i++)
+        {
+            Clock::time_point start = Clock::now();
+            func();
+            best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        return best;
+    }
+
+    std::atomic<double> sink{0.0};
+    int iterationsPerMicrosecond = 1;
+
+    // Busy work of about the given duration, with no memory traffic
+    void Work(int microseconds)
+    {
+        double x = 1.0;
+        for (int i = 0; i < microseconds * iterationsPerMicrosecond; i++)
+        {
+            x = std::sqrt(x + 1.0);
+        }
+        sink.store(x, std::memory_order_relaxed);
+    }
+
+    void CalibrateWork()
+    {
+        iterationsPerMicrosecond = 1000;
+        double milliseconds = Measure([]
+                                      { Work(1000); });
+        iterationsPerMicrosecond = std::max(1, static_cast<int>(1000 * 1000 / (milliseconds * 1000)));
+    }
+
+    // Baseline: workers pulling from one shared queue behind a mutex
+    class SharedQueuePool
+    {
+    public:
+        explicit SharedQueuePool(size_t workerCount)
+        {
+            for (size_t i = 0; i < workerCount; i++)
+            {
+                workers.emplace_back([this]
+                                     { WorkerLoop(); });
+            }
+        }
+
+        ~SharedQueuePool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        void Submit(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            wake.notify_one();
+        }
+
+    private:
+        void WorkerLoop()
+        {
+            for (;;)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this]
+                              { return stopping || !tasks.empty(); });
+                    if (tasks.empty())
+                    {
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+    };
+
+    // Splits into two children until depth runs out, like a divide-and-conquer algorithm
+    void SpawnTree(JobSystem &jobs, int depth, std::atomic<int> &leaves)
+    {
+        if (depth == 0)
+        {
+            Work(2);
+            leaves.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        JobHandle left = jobs.Schedule([&jobs, depth, &leaves]
+                                       { SpawnTree(jobs, depth - 1, leaves); });
+        SpawnTree(jobs, depth - 1, leaves);
+        jobs.Wait(left);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int workerCount = argc > 1 ? static_cast<unsigned int>(std::max(1, std::atoi(argv[1]))) : 0;
+    JobSystem jobs(workerCount);
+    CalibrateWork();
+    std::printf("%zu threads (main thread included)\n", jobs.GetThreadCount());
+    bool passed = true;
+
+    // Cost of scheduling and finishing a job that does nothing
+    {
+        const int count = 100000;
+        std::vector<JobHandle> handles(count);
+        double milliseconds = Measure([&]
+                                      {
+                                          for (int i = 0; i < count; i++)
+                                          {
+                                              handles[i] = jobs.Schedule([] {});
+                                          }
+                                          for (const JobHandle &handle : handles)
+                                          {
+                                              jobs.Wait(handle);
+                                          } });
+        std::printf("Empty jobs:      %6.0f ns per job\n", milliseconds * 1e6 / count);
+    }
+
+    // Small jobs against the shared-queue baseline and a serial loop
+    for (int microseconds : {1, 5, 20})
+    {
+        const int count = 20000;
+        std::vector<JobHandle> handles(count);
+        double jobTime = Measure([&]
+                                 {
+                                     for (int i = 0; i < count; i++)
+                                     {
+                                         handles[i] = jobs.Schedule([microseconds]
+                                                                    { Work(microseconds); });
+                                     }
+                                     for (const JobHandle &handle : handles)
+                                     {
+                                         jobs.Wait(handle);
+                                     } });
+        double poolTime;
+        {
+            SharedQueuePool pool(jobs.GetThreadCount());
+            poolTime = Measure([&]
+                               {
+                                   std::atomic<int> done{0};
+                                   for (int i = 0; i < count; i++)
+                                   {
+                                       pool.Submit([microseconds, &done]
+                                                   {
+                                                       Work(microseconds);
+                                                       done.fetch_add(1, std::memory_order_release); });
+                                   }
+                                   while (done.load(std::memory_order_acquire) < count)
+                                   {
+                                       std::this_thread::yield();
+                                   } });
+        }
+        double serialTime = Measure([&]
+                                    {
+                                        for (int i = 0; i < count; i++)
+                                        {
+                                            Work(microseconds);
+                                        } },
+                                    1);
+        std::printf("%2d us jobs x %d: jobs %7.2f ms   shared queue %7.2f ms   serial %7.2f ms\n", microseconds, count, jobTime,
+                    poolTime, serialTime);
+    }
+
+    // ParallelFor over a large array with the automatic grain size
+    {
+        std::vector<float> values(1 << 22, 1.0f);
+        double parallelTime = Measure([&]
+                                      { jobs.ParallelFor(0, values.size(), [&](size_t first, size_t last)
+                                                         {
+                                                             for (size_t i = first; i < last; i++)
+                                                             {
+                                                                 values[i] = std::sqrt(values[i] * 1.0001f + 1.0f);
+                                                             } }); });
+        double serialTime = Measure([&]
+                                    {
+                                        for (float &value : values)
+                                        {
+                                            value = std::sqrt(value * 1.0001f + 1.0f);
+                                        } });
+        std::printf("ParallelFor 4M:  %7.2f ms   serial %7.2f ms\n", parallelTime, serialTime);
+    }
+
+    // Each job depends on the one before, so this measures the hand-off latency
+    {
+        const int length = 10000;
+        std::atomic<int> next{0};
+        bool ordered = true;
+        double milliseconds = Measure([&]
+                                      {
+                                          next = 0;
+                                          JobHandle previous;
+                                          for (int i = 0; i < length; i++)
+                                          {
+                                              previous = jobs.Schedule([i, &next, &ordered]
+                                                                       { ordered &= next.fetch_add(1) == i; },
+                                                                       {previous});
+                                          }
+                                          jobs.Wait(previous); });
+        std::printf("Chain of %d:  %6.0f ns per link%s\n", length, milliseconds * 1e6 / length, ordered ? "" : "  OUT OF ORDER");
+        passed &= ordered;
+    }
+
+    // One job releases a wide batch that a single job joins again
+    {
+        const int width = 1000;
+        const int rounds = 20;
+        std::atomic<int> joined{0};
+        double milliseconds = Measure([&]
+                                      {
+                                          joined = 0;
+                                          JobHandle join;
+                                          for (int round = 0; round < rounds; round++)
+                                          {
+                                              JobHandle start = jobs.Schedule([] {}, {join});
+                                              std::vector<JobHandle> batch;
+                                              batch.reserve(width);
+                                              for (int i = 0; i < width; i++)
+                                              {
+                                                  batch.push_back(jobs.Schedule([]
+                                                                                { Work(1); },
+                                                                                {start}));
+                                              }
+                                              join = jobs.Schedule([&joined]
+                                                                   { joined++; },
+                                                                   batch);
+                                          }
+                                          jobs.Wait(join); });
+        std::printf("Fan-out/in:      %7.2f ms for %d rounds of %d\n", milliseconds, rounds, width);
+        passed &= joined == rounds;
+    }
+
+    // Work that only exists once a worker spawns it, so it spreads by stealing
+    {
+        const int depth = 14;
+        std::atomic<int> leaves{0};
+        double milliseconds = Measure([&]
+                                      {
+                                          leaves = 0;
+                                          JobHandle root = jobs.Schedule([&jobs, &leaves]
+                                                                         { SpawnTree(jobs, depth, leaves); });
+                                          jobs.Wait(root); });
+        double serialTime = (1 << depth) * 2 / 1000.0;
+        std::printf("Spawn tree 2^%d: %7.2f ms   serial work %7.2f ms\n", depth, milliseconds, serialTime);
+        passed &= leaves == (1 << depth);
+    }
+
+    // Background jobs must never run on the main thread, even while it waits on them
+    {
+        std::atomic<int> onMainThread{0};
+        std::vector<JobHandle> handles;
+        for (int i = 0; i < 1000; i++)
+        {
+            handles.push_back(jobs.Schedule([&jobs, &onMainThread]
+                                            { onMainThread += jobs.IsMainThread(); },
+                                            {}, JobAffinity::Background));
+        }
+        for (const JobHandle &handle : handles)
+        {
+            jobs.Wait(handle);
+        }
+        std::printf("Background jobs on the main thread: %d%s\n", onMainThread.load(), onMainThread == 0 ? "" : "  FAIL");
+        passed &= onMainThread == 0;
+    }
+
+    // A worker's ParallelFor must not pick up a long Background job while it waits for its
+    // chunks, or whoever waits for the worker's job stalls for the whole Background job
+    if (jobs.GetThreadCount() > 1)
+    {
+        const int backgroundMilliseconds = 200;
+        std::atomic<int> startedOn{-1};
+        std::atomic<bool> backgroundQueued{false};
+        double parallelTime = 0.0;
+        JobHandle outer = jobs.Schedule([&]
+                                        {
+                                            startedOn = jobs.GetThreadIndex();
+                                            while (!backgroundQueued.load(std::memory_order_acquire))
+                                            {
+                                                std::this_thread::yield();
+                                            }
+                                            Clock::time_point start = Clock::now();
+                                            // Chunks long enough that other threads steal some,
+                                            // so this worker ends up waiting for them
+                                            jobs.ParallelFor(0, 16, [](size_t first, size_t last)
+                                                             { Work(static_cast<int>(last - first) * 2000); },
+                                                             1);
+                                            parallelTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count(); });
+
+        // The outer job has to start on a worker before the Background job is queued
+        while (startedOn.load() < 0)
+        {
+            std::this_thread::yield();
+        }
+        // One more than there are workers, so one is still queued while the other workers are busy
+        std::vector<JobHandle> background;
+        for (size_t i = 0; i < jobs.GetThreadCount(); i++)
+        {
+            background.push_back(jobs.Schedule([backgroundMilliseconds]
+                                               { Work(backgroundMilliseconds * 1000); },
+                                               {}, JobAffinity::Background));
+        }
+        backgroundQueued.store(true, std::memory_order_release);
+        jobs.Wait(outer);
+        bool onWorker = startedOn.load() > 0;
+        bool blocked = parallelTime >= backgroundMilliseconds; // The chunks alone take a sixth of that
+        std::printf("Worker ParallelFor with %d ms Background jobs queued: %.2f ms%s\n", backgroundMilliseconds, parallelTime,
+                    !onWorker ? "  (ran on the main thread, not checked)" : blocked ? "  WAITED FOR THE BACKGROUND JOB" : "");
+        passed &= !(onWorker && blocked);
+        for (const JobHandle &handle : background)
+        {
+            jobs.Wait(handle);
+        }
+    }
+
+    return passed ? 0 : 1;
+}
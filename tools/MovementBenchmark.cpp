@@ -0,0 +1,136 @@
+// Measures MovementSystem::Tick on one million moving entities with 1, 2, 4, ... threads, up to
+// the hardware's, against the 2 ms budget for a tick. Also times the bare integration kernel on
+// one thread and reports the memory bandwidth it reached next to the bandwidth the budget needs.
+//
+//   scons bench-movement
+//
+// builds build/MovementBenchmark and runs it; the exit code is 1 if the parallel result differs
+// from the serial one. Missing the budget is reported, not failed, since it depends on the machine.
+#include "../src/ecs/MovementSystem.h"
+#include "../src/ecs/ParallelView.h"
+#include "../src/ecs/TransformChangeLog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const size_t EntityCount = 1000000;
+    const float DeltaTime = 1.0f / 60.0f;
+    const double BudgetMilliseconds = 2.0;
+
+    // Best of a few runs, in milliseconds
+    template <typename Func>
+    double Measure(Func func, int runs = 10)
+    {
+        double best = 1e30;
+        for (int i = 0; i < runs; i++)
+        {
+            Clock::time_point start = Clock::now();
+            func();
+            best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        return best;
+    }
+
+    void Populate(entt::registry &registry)
+    {
+        for (size_t i = 0; i < EntityCount; i++)
+        {
+            entt::entity entity = registry.create();
+            float x = static_cast<float>(i % 1000);
+            float z = static_cast<float>(i / 1000);
+            registry.emplace<TransformComponent>(entity, glm::vec3(x, 0.0f, z));
+            registry.emplace<VelocityComponent>(entity, glm::vec3(0.5f, 1.0f, -0.25f * (i % 7)));
+        }
+    }
+
+    // Positions after one tick, in entity order
+    std::vector<glm::vec3> Positions(entt::registry &registry)
+    {
+        std::vector<glm::vec3> positions;
+        positions.reserve(EntityCount);
+        for (entt::entity entity : registry.view<entt::entity>())
+        {
+            positions.push_back(registry.get<TransformComponent>(entity).position);
+        }
+        return positions;
+    }
+}
+
+int main()
+{
+    unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%zu moving entities, %u hardware threads, budget %.1f ms per tick\n", EntityCount, hardwareThreads, BudgetMilliseconds);
+
+    // Reference: one serial tick, without a job system
+    entt::registry reference;
+    Populate(reference);
+    MovementSystem system;
+    system.AssurePools(reference);
+    system.Tick(reference, DeltaTime);
+    std::vector<glm::vec3> expected = Positions(reference);
+
+    // The kernel alone on one thread, page by page as ParallelChunks splits it. Every tick reads
+    // and writes each transform and reads each velocity, so the traffic sets a floor on the time.
+    {
+        auto group = reference.group<TransformComponent, VelocityComponent>();
+        auto &transforms = *group.storage<TransformComponent>();
+        auto &velocities = *group.storage<VelocityComponent>();
+        size_t pageSize = entt::component_traits<TransformComponent>::page_size;
+        double kernel = Measure([&]
+                                {
+                                    for (size_t first = 0; first < group.size(); first += pageSize)
+                                    {
+                                        size_t last = std::min(group.size(), first + pageSize);
+                                        IntegratePositions(PackedComponents(transforms, first), PackedComponents(velocities, first),
+                                                           last - first, DeltaTime);
+                                    } });
+        double bytes = static_cast<double>(EntityCount) * (2 * sizeof(TransformComponent) + sizeof(VelocityComponent));
+        std::printf("Kernel, 1 thread:  %6.2f ms, %.1f GB/s; the budget needs %.1f GB/s\n", kernel, bytes / (kernel * 1e6),
+                    bytes / (BudgetMilliseconds * 1e6));
+    }
+
+    bool passed = true;
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads);
+
+    for (unsigned int threads : threadCounts)
+    {
+        entt::registry registry;
+        Populate(registry);
+
+        // threads counts the main thread, which helps while ParallelChunks waits
+        std::unique_ptr<JobSystem> jobs;
+        if (threads > 1)
+        {
+            jobs = std::make_unique<JobSystem>(threads - 1);
+            registry.ctx().emplace<JobSystem *>(jobs.get());
+        }
+        TransformChangeLog &changes = registry.ctx().emplace<TransformChangeLog>();
+        system.AssurePools(registry);
+
+        system.Tick(registry, DeltaTime);
+        bool matches = Positions(registry) == expected;
+        passed &= matches;
+
+        double tick = Measure([&]
+                              {
+                                  changes.Clear();
+                                  system.Tick(registry, DeltaTime);
+                              });
+        std::printf("Tick, %2u thread%s: %6.2f ms   %s%s\n", threads, threads == 1 ? " " : "s", tick,
+                    tick <= BudgetMilliseconds ? "within budget" : "over budget", matches ? "" : "   RESULT DIFFERS");
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+// Benchmarks the scene BVH on a synthetic scene without a window or GL context: bulk SAH build
+// against one-by-one insertion, frustum, overlap, ray and nearest queries against a brute-force
+// scan, and a frame of moving entities. Query results are compared with the brute-force answer
+// over the exact boxes; the exit code is 1 if any differ.
+//
+//   scons bench-bvh
+//
+// builds build/SceneBVHBenchmark and runs it with 100000 entities; pass the binary a count to
+// change that.
+#include "../src/scene/BVH.h"
+#include <gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using Item = std::pair<entt::entity, AABB>;
+
+    // Best of a few runs, in milliseconds
+    template <typename Func>
+    double Measure(Func func, int runs = 5)
+    {
+        double best = 1e30;
+        for (int i = 0; i < runs; i++)
+        {
+            Clock::time_point start = Clock::now();
+            func();
+            best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        return best;
+    }
+
+    bool Overlaps(const AABB &a, const AABB &b)
+    {
+        return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+    }
+
+    bool InsideFrustum(const Frustum &frustum, const AABB &box)
+    {
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = glm::dot(glm::vec3(plane), box.GetCenter()) + plane.w;
+            if (distance < -glm::dot(glm::abs(glm::vec3(plane)), box.GetExtents()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    float RayEntry(const AABB &box, const glm::vec3 &origin, const glm::vec3 &direction)
+    {
+        glm::vec3 t0 = (box.min - origin) / direction;
+        glm::vec3 t1 = (box.max - origin) / direction;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+        return entry <= exit ? entry : -1.0f;
+    }
+
+    float DistanceSquared(const AABB &box, const glm::vec3 &point)
+    {
+        glm::vec3 offset = point - glm::clamp(point, box.min, box.max);
+        return glm::dot(offset, offset);
+    }
+
+    // Entities scattered through a 1 km cube, a few clustered like props in a room
+    std::vector<Item> MakeScene(entt::registry &registry, int count, std::mt19937 &random)
+    {
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> size(0.5f, 3.0f);
+        std::normal_distribution<float> cluster(0.0f, 10.0f);
+        std::vector<Item> items;
+        items.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            glm::vec3 center = i % 4 == 0 ? glm::vec3(cluster(random), cluster(random), cluster(random))
+                                          : glm::vec3(position(random), position(random), position(random));
+            glm::vec3 half(size(random), size(random), size(random));
+            items.push_back({registry.create(), {center - half, center + half}});
+        }
+        return items;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+    std::mt19937 random(7);
+    entt::registry registry;
+    std::vector<Item> items = MakeScene(registry, count, random);
+    std::printf("%d entities\n", count);
+
+    // Construction
+    SceneBVH bulk;
+    double buildTime = Measure([&]
+                               { bulk.Build(items); });
+    SceneBVH incremental;
+    double insertTime = Measure([&]
+                                {
+                                    incremental.Clear();
+                                    for (const Item &item : items)
+                                    {
+                                        incremental.Update(item.first, item.second);
+                                    } });
+    std::printf("Build:   SAH %8.2f ms (cost %.1f)   one by one %8.2f ms (cost %.1f)\n", buildTime, bulk.GetSAHCost(), insertTime,
+                incremental.GetSAHCost());
+
+    // Queries, each checked against a scan of the exact boxes
+    bool passed = true;
+    std::vector<entt::entity> results;
+
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f) *
+                               glm::lookAt(glm::vec3(0.0f, 5.0f, 15.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+    double frustumTime = Measure([&]
+                                 {
+                                     results.clear();
+                                     bulk.QueryFrustum(frustum, results); });
+    std::vector<entt::entity> scanned;
+    double frustumScan = Measure([&]
+                                 {
+                                     scanned.clear();
+                                     for (const Item &item : items)
+                                     {
+                                         if (InsideFrustum(frustum, item.second))
+                                         {
+                                             scanned.push_back(item.first);
+                                         }
+                                     } });
+    size_t expected = scanned.size();
+    std::printf("Frustum: %8.3f ms   scan %8.3f ms   %zu visible%s\n", frustumTime, frustumScan, results.size(),
+                results.size() == expected ? "" : "  MISMATCH");
+    passed &= results.size() == expected;
+
+    AABB region = {glm::vec3(-20.0f), glm::vec3(20.0f)};
+    double overlapTime = Measure([&]
+                                 {
+                                     results.clear();
+                                     bulk.QueryOverlap(region, results); });
+    expected = std::count_if(items.begin(), items.end(), [&](const Item &item)
+                             { return Overlaps(item.second, region); });
+    std::printf("Overlap: %8.3f ms   %zu hits%s\n", overlapTime, results.size(), results.size() == expected ? "" : "  MISMATCH");
+    passed &= results.size() == expected;
+
+    // Rays from random points towards random entities, so most of them hit something
+    const int rayCount = 1000;
+    std::vector<std::pair<glm::vec3, glm::vec3>> rays;
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    for (int i = 0; i < rayCount; i++)
+    {
+        glm::vec3 origin(position(random), position(random), position(random));
+        glm::vec3 target = items[random() % items.size()].second.GetCenter();
+        rays.push_back({origin, glm::normalize(target - origin)});
+    }
+    int rayMismatches = 0;
+    double rayTime = Measure([&]
+                             {
+                                 for (const auto &ray : rays)
+                                 {
+                                     RaycastHit hit;
+                                     bulk.Raycast(ray.first, ray.second, 1e9f, hit);
+                                 } });
+    for (int i = 0; i < 50; i++)
+    {
+        RaycastHit hit;
+        bool found = bulk.Raycast(rays[i].first, rays[i].second, 1e9f, hit);
+        float nearest = 1e30f;
+        for (const Item &item : items)
+        {
+            float entry = RayEntry(item.second, rays[i].first, rays[i].second);
+            nearest = entry >= 0.0f ? std::min(nearest, entry) : nearest;
+        }
+        rayMismatches += found != (nearest < 1e30f) || (found && std::abs(hit.distance - nearest) > 1e-3f);
+    }
+    std::printf("Raycast: %8.4f ms per ray   %d of 50 checked differ%s\n", rayTime / rayCount, rayMismatches,
+                rayMismatches == 0 ? "" : "  MISMATCH");
+    passed &= rayMismatches == 0;
+
+    const size_t k = 8;
+    glm::vec3 point(3.0f, -2.0f, 1.0f);
+    double nearestTime = Measure([&]
+                                 {
+                                     results.clear();
+                                     bulk.QueryNearest(point, k, results); });
+    std::vector<float> distances;
+    for (const Item &item : items)
+    {
+        distances.push_back(DistanceSquared(item.second, point));
+    }
+    std::nth_element(distances.begin(), distances.begin() + (k - 1), distances.end());
+    float kthDistance = distances[k - 1];
+    float farthest = 0.0f;
+    for (entt::entity entity : results)
+    {
+        auto found = std::find_if(items.begin(), items.end(), [&](const Item &item)
+                                  { return item.first == entity; });
+        farthest = std::max(farthest, DistanceSquared(found->second, point));
+    }
+    bool nearestMatches = results.size() == k && farthest <= kthDistance;
+    std::printf("Nearest: %8.4f ms for k = %zu%s\n", nearestTime, k, nearestMatches ? "" : "  MISMATCH");
+    passed &= nearestMatches;
+
+    // One frame with a tenth of the entities moving: most jiggle inside their fat boxes, some
+    // drift far enough to be refitted or re-inserted
+    std::normal_distribution<float> jiggle(0.0f, 0.05f);
+    std::normal_distribution<float> drift(0.0f, 5.0f);
+    double updateTime = Measure([&]
+                                {
+                                    for (size_t i = 0; i < items.size(); i += 10)
+                                    {
+                                        glm::vec3 offset = i % 100 == 0 ? glm::vec3(drift(random), drift(random), drift(random))
+                                                                        : glm::vec3(jiggle(random), jiggle(random), jiggle(random));
+                                        items[i].second.min += offset;
+                                        items[i].second.max += offset;
+                                        bulk.Update(items[i].first, items[i].second);
+                                    } });
+    std::printf("Update:  %8.3f ms for %zu moving entities (cost now %.1f)\n", updateTime, (items.size() + 9) / 10, bulk.GetSAHCost());
+
+    // Moved entities must be found at their new place
+    results.clear();
+    bulk.QueryOverlap(region, results);
+    expected = std::count_if(items.begin(), items.end(), [&](const Item &item)
+                             { return Overlaps(item.second, region); });
+    std::printf("Overlap after update: %zu hits%s\n", results.size(), results.size() == expected ? "" : "  MISMATCH");
+    passed &= results.size() == expected;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// Checks the texture compressor without a window or GL context: compresses a fixed synthetic
+// image to every block format and fails when the decoded image falls below the format's PSNR
+// floor, or when a solid color the format can represent does not come back exactly.
+//
+//   scons check-textures
+//
+// builds build/TextureCompressionCheck and runs it; the exit code is 1 if any check failed.
+#include "../src/core/TextureCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    struct FormatCheck
+    {
+        BlockFormat format;
+        int channelCount; // Channels the format stores
+        double minimumPSNR;
+    };
+
+    // Floors sit 2-3 dB below what the encoder reaches on the test image (BC1 31.2, BC3 32.5,
+    // BC5 44.4, BC7 33.3 dB), so a regression fails but small changes to the endpoint search do not
+    const FormatCheck Checks[] = {
+        {BlockFormat::BC1, 3, 28.0},
+        {BlockFormat::BC3, 4, 29.0},
+        {BlockFormat::BC5, 2, 41.0},
+        {BlockFormat::BC7, 4, 31.0},
+    };
+
+    // Smooth gradients for the endpoint fit, noise, hard edges and patches of 2x2 cells in
+    // unrelated colors for the index search, and an alpha channel that is opaque in some blocks
+    // and varies in others. The size is not a multiple of 4, so edge padding is covered too.
+    std::vector<uint8_t> MakeTestImage(int width, int height)
+    {
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        uint32_t seed = 1;
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                int noise = static_cast<int>((seed >> 16) % 9) - 4;
+                bool checker = (x / 32 + y / 32) % 2 != 0;
+                uint8_t *texel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+                texel[0] = static_cast<uint8_t>(std::clamp(x + noise, 0, 255));
+                texel[1] = static_cast<uint8_t>(std::clamp(static_cast<int>(128 + 100 * std::sin(y * 0.1)) + noise, 0, 255));
+                texel[2] = static_cast<uint8_t>(checker ? (x * y) >> 8 : 255 - ((x * y) >> 8));
+                texel[3] = static_cast<uint8_t>(checker ? 255 : x);
+                if ((x / 64 + y / 64) % 3 == 0)
+                {
+                    uint32_t cell = static_cast<uint32_t>((y / 2) * width + x / 2) * 2654435761u;
+                    texel[0] = static_cast<uint8_t>(texel[0] / 2 + (cell >> 25));
+                    texel[1] = static_cast<uint8_t>(texel[1] / 2 + ((cell >> 17) & 127));
+                }
+            }
+        }
+        return rgba;
+    }
+
+    double RoundTrip(BlockFormat format, const std::vector<uint8_t> &rgba, int width, int height, int channelCount)
+    {
+        std::vector<uint8_t> blocks(GetCompressedSize(format, width, height));
+        std::vector<uint8_t> decoded(rgba.size());
+        CompressBlocks(format, rgba.data(), width, height, blocks.data());
+        DecompressBlocks(format, blocks.data(), width, height, decoded.data());
+        return ComputePSNR(rgba.data(), decoded.data(), width, height, channelCount);
+    }
+
+    bool CheckImage(const FormatCheck &check, const std::vector<uint8_t> &rgba, int width, int height)
+    {
+        double psnr = RoundTrip(check.format, rgba, width, height, check.channelCount);
+        bool passed = psnr >= check.minimumPSNR;
+        std::printf("%s %s: %.2f dB (minimum %.1f)\n", passed ? "PASS" : "FAIL", GetFormatName(check.format), psnr, check.minimumPSNR);
+        return passed;
+    }
+
+    bool CheckSolid(const FormatCheck &check, const uint8_t color[4])
+    {
+        const int size = 8;
+        std::vector<uint8_t> rgba(size * size * 4);
+        for (size_t i = 0; i < rgba.size(); i += 4)
+        {
+            std::copy(color, color + 4, &rgba[i]);
+        }
+        bool passed = std::isinf(RoundTrip(check.format, rgba, size, size, check.channelCount));
+        std::printf("%s %s solid (%d, %d, %d, %d): %s\n", passed ? "PASS" : "FAIL", GetFormatName(check.format), color[0], color[1],
+                    color[2], color[3], passed ? "exact" : "not exact");
+        return passed;
+    }
+}
+
+int main()
+{
+    const int width = 258;
+    const int height = 194;
+    std::vector<uint8_t> image = MakeTestImage(width, height);
+
+    // Every channel is on the RGB565 grid (165 = 20 << 3 | 20 >> 2, 162 = 40 << 2 | 40 >> 4,
+    // 82 = 10 << 3 | 10 >> 2), so even BC1 must reproduce it. The translucent copy needs BC3's
+    // 8-bit alpha endpoints and a BC7 color with mixed low bits.
+    const uint8_t solidColor[4] = {165, 162, 82, 255};
+    const uint8_t solidTranslucent[4] = {165, 162, 82, 77};
+
+    bool passed = true;
+    for (const FormatCheck &check : Checks)
+    {
+        passed &= CheckImage(check, image, width, height);
+        passed &= CheckSolid(check, solidColor);
+        if (check.channelCount == 4)
+        {
+            passed &= CheckSolid(check, solidTranslucent);
+        }
+    }
+
+    std::printf(passed ? "All texture compression checks passed\n" : "Texture compression checks FAILED\n");
+    return passed ? 0 : 1;
+}